@@ -0,0 +1,159 @@
+/** ***************************************************************************
+ * @file cmdqueue.h
+ * @brief Queue of complete SPI commands between ISR(SPI_STC_vect) and the main loop
+ *
+ * The queue stores fixed layout command records (opcode, payload length and
+ * payload). The SPI ISR (single producer) assembles a command directly in the
+ * next free record and publishes it once the last data byte has arrived. The
+ * main loop (single consumer) only ever sees complete commands, no scanning
+ * for a termination character is necessary. Full frames do not pass through
+ * the queue, they are streamed into the framebuffer by the ISR.
+ *
+ * Head and tail are free running 8bit indices, the amount of stored commands
+ * is their difference. Each index is written by one side only and a single
+ * byte access is atomic on the AVR, so no interrupt lock is needed.
+ * All functions are inlined for speed (same approach as ringbuffer.h).
+ *
+ * @author agent
+ * @date 16.10.2026
+ *****************************************************************************/
+
+
+#ifndef CMDQUEUE_H_
+#define CMDQUEUE_H_
+
+#define CMD_QUEUE_SIZE		4						///< amount of command records, must be a power of two
+#define CMD_QUEUE_MASK		(CMD_QUEUE_SIZE-1)		///< index mask of the command records
+#define CMD_QUEUE_RESERVE	1						///< free records at which the queue counts as nearly full
+#define CMD_RANGE_MAX		20						///< maximum amount of colors of 0x86 (independent of the strip length)
+#define CMD_PAYLOAD_SIZE	(2+(CMD_RANGE_MAX*3))	///< maximum payload: [SS, NN, NN colors] of 0x86
+#define CMD_RLE_RUNS_MAX	((CMD_PAYLOAD_SIZE-2)/4)	///< maximum runs of 0x98: [SH, SL, runs of NN, RR, GG, BB]
+
+/** compiler barrier: memory accesses are not moved across a head or tail update */
+#define CMD_QUEUE_BARRIER()	__asm__ __volatile__ ("" ::: "memory")
+
+
+/** One complete command */
+typedef struct
+{
+	unsigned char ucOpcode;							///< command byte as received (e.g. 0x84)
+	unsigned char ucLength;							///< amount of valid payload bytes
+	unsigned char aucPayload[CMD_PAYLOAD_SIZE];		///< data bytes following the command byte
+} COMMAND;
+
+/** Single producer, single consumer queue of commands */
+typedef struct
+{
+	COMMAND asCommand[CMD_QUEUE_SIZE];				///< command records
+	volatile unsigned char ucHead;					///< next record to be published (producer only)
+	volatile unsigned char ucTail;					///< next record to be executed (consumer only)
+} CMDQUEUE;
+
+
+/** ***************************************************************************
+ * @brief Initialize an empty command queue
+ *
+ * @param [out] sQueue_ptr: queue to initialize
+ * @return no return value
+ *****************************************************************************/
+static inline void CmdQueue_Init(CMDQUEUE* sQueue_ptr)
+{
+	sQueue_ptr->ucHead = 0;
+	sQueue_ptr->ucTail = 0;
+}
+
+
+/** ***************************************************************************
+ * @brief Amount of published commands
+ *
+ * @param [in] sQueue_ptr: command queue
+ * @return amount of commands waiting for execution
+ *****************************************************************************/
+static inline unsigned char CmdQueue_GetCount(CMDQUEUE* sQueue_ptr)
+{
+	return (unsigned char)(sQueue_ptr->ucHead - sQueue_ptr->ucTail);
+}
+
+
+/** ***************************************************************************
+ * @brief Check if the queue is nearly full
+ *
+ * At most CMD_QUEUE_RESERVE records are free: the next command still fits,
+ * the one after it may be dropped.
+ *
+ * @param [in] sQueue_ptr: command queue
+ * @return 1: nearly full  0: enough free records
+ *****************************************************************************/
+static inline unsigned char CmdQueue_IsNearlyFull(CMDQUEUE* sQueue_ptr)
+{
+	return (CmdQueue_GetCount(sQueue_ptr) >= (CMD_QUEUE_SIZE-CMD_QUEUE_RESERVE));
+}
+
+
+/** ***************************************************************************
+ * @brief Get the record for the next command (producer)
+ *
+ * The record may be filled over several calls of the ISR. It is not visible
+ * to the consumer until CmdQueue_Publish() is called. Getting the write
+ * record again without publishing discards the incomplete command.
+ *
+ * @param [in] sQueue_ptr: command queue
+ * @return pointer to the free record, 0 if the queue is full
+ *****************************************************************************/
+static inline COMMAND* CmdQueue_GetWriteSlot(CMDQUEUE* sQueue_ptr)
+{
+	unsigned char ucHead = sQueue_ptr->ucHead;
+
+	if((unsigned char)(ucHead - sQueue_ptr->ucTail) >= CMD_QUEUE_SIZE)
+	{
+		return 0;
+	}
+	return &sQueue_ptr->asCommand[ucHead & CMD_QUEUE_MASK];
+}
+
+
+/** ***************************************************************************
+ * @brief Publish the record returned by CmdQueue_GetWriteSlot() (producer)
+ *
+ * @param [in,out] sQueue_ptr: command queue
+ * @return no return value
+ *****************************************************************************/
+static inline void CmdQueue_Publish(CMDQUEUE* sQueue_ptr)
+{
+	CMD_QUEUE_BARRIER();
+	sQueue_ptr->ucHead++;
+}
+
+
+/** ***************************************************************************
+ * @brief Get the oldest published command without removing it (consumer)
+ *
+ * @param [in] sQueue_ptr: command queue
+ * @return pointer to the command, 0 if the queue is empty
+ *****************************************************************************/
+static inline COMMAND* CmdQueue_Peek(CMDQUEUE* sQueue_ptr)
+{
+	unsigned char ucTail = sQueue_ptr->ucTail;
+
+	if(sQueue_ptr->ucHead == ucTail)
+	{
+		return 0;
+	}
+	CMD_QUEUE_BARRIER();
+	return &sQueue_ptr->asCommand[ucTail & CMD_QUEUE_MASK];
+}
+
+
+/** ***************************************************************************
+ * @brief Release the command returned by CmdQueue_Peek() (consumer)
+ *
+ * @param [in,out] sQueue_ptr: command queue
+ * @return no return value
+ *****************************************************************************/
+static inline void CmdQueue_Pop(CMDQUEUE* sQueue_ptr)
+{
+	CMD_QUEUE_BARRIER();
+	sQueue_ptr->ucTail++;
+}
+
+#endif /* CMDQUEUE_H_ */
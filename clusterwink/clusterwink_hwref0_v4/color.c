@@ -0,0 +1,224 @@
+/** ***************************************************************************
+ * @file color.c
+ * @brief Integer color conversions for the RGB strip
+ *
+ * - Hue wheel
+ * @n An 8bit hue [0-255] is converted to a fully saturated color with a
+ * multiplication by 6 and a linear ramp per sector (red, yellow, green, cyan,
+ * blue, magenta). No table and no division is needed.
+ *
+ * - HSV
+ * @n Hue wheel, then the saturation blends towards white and the value
+ * scales the result. The hue is given as 8bit fraction of the circle or in
+ * degree [0-359].
+ *
+ * - Color temperature
+ * @n Black body colors (approximation of the CIE 1964 data by Tanner
+ * Helland, 255 at the brightest channel) every COLOR_KELVIN_STEP are kept in
+ * a table in the flash memory (273 bytes). Temperatures in between are
+ * interpolated linearly.
+ *
+ * All conversions use 8 and 16bit integer operations only.
+ *
+ * @author agent
+ * @date 16.10.2026
+ *****************************************************************************/
+
+
+#include <avr/pgmspace.h>
+#include "color.h"
+
+
+#define KELVIN_ENTRIES	(((COLOR_KELVIN_MAX - COLOR_KELVIN_MIN) / COLOR_KELVIN_STEP) + 1)	///< entries of the color temperature table
+
+
+/** Color temperature table: red, green, blue from COLOR_KELVIN_MIN to COLOR_KELVIN_MAX */
+const unsigned char aucColorKelvin[KELVIN_ENTRIES*3] PROGMEM =
+{
+	0xFF, 0x44, 0x00, 0xFF, 0x4D, 0x00, 0xFF, 0x56, 0x00, 0xFF, 0x5E, 0x00,	// 1000K
+	0xFF, 0x65, 0x00, 0xFF, 0x6C, 0x00, 0xFF, 0x73, 0x00, 0xFF, 0x79, 0x00,	// 1400K
+	0xFF, 0x7E, 0x00, 0xFF, 0x84, 0x00, 0xFF, 0x89, 0x0E, 0xFF, 0x8E, 0x1B,	// 1800K
+	0xFF, 0x92, 0x27, 0xFF, 0x97, 0x32, 0xFF, 0x9B, 0x3D, 0xFF, 0x9F, 0x46,	// 2200K
+	0xFF, 0xA3, 0x4F, 0xFF, 0xA7, 0x57, 0xFF, 0xAA, 0x5F, 0xFF, 0xAE, 0x67,	// 2600K
+	0xFF, 0xB1, 0x6E, 0xFF, 0xB4, 0x75, 0xFF, 0xB8, 0x7B, 0xFF, 0xBB, 0x81,	// 3000K
+	0xFF, 0xBE, 0x87, 0xFF, 0xC1, 0x8D, 0xFF, 0xC3, 0x92, 0xFF, 0xC6, 0x97,	// 3400K
+	0xFF, 0xC9, 0x9D, 0xFF, 0xCB, 0xA1, 0xFF, 0xCE, 0xA6, 0xFF, 0xD0, 0xAB,	// 3800K
+	0xFF, 0xD3, 0xAF, 0xFF, 0xD5, 0xB3, 0xFF, 0xD7, 0xB7, 0xFF, 0xDA, 0xBB,	// 4200K
+	0xFF, 0xDC, 0xBF, 0xFF, 0xDE, 0xC3, 0xFF, 0xE0, 0xC7, 0xFF, 0xE2, 0xCA,	// 4600K
+	0xFF, 0xE4, 0xCE, 0xFF, 0xE6, 0xD1, 0xFF, 0xE8, 0xD5, 0xFF, 0xEA, 0xD8,	// 5000K
+	0xFF, 0xEC, 0xDB, 0xFF, 0xED, 0xDE, 0xFF, 0xEF, 0xE1, 0xFF, 0xF1, 0xE4,	// 5400K
+	0xFF, 0xF3, 0xE7, 0xFF, 0xF4, 0xEA, 0xFF, 0xF6, 0xED, 0xFF, 0xF8, 0xF0,	// 5800K
+	0xFF, 0xF9, 0xF2, 0xFF, 0xFB, 0xF5, 0xFF, 0xFD, 0xF8, 0xFF, 0xFE, 0xFA,	// 6200K
+	0xFF, 0xFF, 0xFF, 0xFE, 0xF9, 0xFF, 0xFA, 0xF6, 0xFF, 0xF6, 0xF4, 0xFF,	// 6600K
+	0xF3, 0xF2, 0xFF, 0xF0, 0xF0, 0xFF, 0xED, 0xEF, 0xFF, 0xEA, 0xED, 0xFF,	// 7000K
+	0xE8, 0xEC, 0xFF, 0xE6, 0xEB, 0xFF, 0xE4, 0xEA, 0xFF, 0xE2, 0xE9, 0xFF,	// 7400K
+	0xE0, 0xE8, 0xFF, 0xDF, 0xE7, 0xFF, 0xDD, 0xE6, 0xFF, 0xDC, 0xE5, 0xFF,	// 7800K
+	0xDA, 0xE4, 0xFF, 0xD9, 0xE3, 0xFF, 0xD8, 0xE3, 0xFF, 0xD7, 0xE2, 0xFF,	// 8200K
+	0xD6, 0xE1, 0xFF, 0xD5, 0xE1, 0xFF, 0xD4, 0xE0, 0xFF, 0xD3, 0xDF, 0xFF,	// 8600K
+	0xD2, 0xDF, 0xFF, 0xD1, 0xDE, 0xFF, 0xD0, 0xDE, 0xFF, 0xCF, 0xDD, 0xFF,	// 9000K
+	0xCE, 0xDD, 0xFF, 0xCD, 0xDC, 0xFF, 0xCD, 0xDC, 0xFF, 0xCC, 0xDB, 0xFF,	// 9400K
+	0xCB, 0xDB, 0xFF, 0xCA, 0xDA, 0xFF, 0xCA, 0xDA, 0xFF		// 9800K
+};
+
+
+/** ***************************************************************************
+ * @brief Scale a value by a factor
+ *
+ * The factor is stretched to [0-256], so that factor 255 keeps the value.
+ *
+ * @param [in] ucValue: value
+ * @param [in] ucFactor: factor [1/255]
+ * @return scaled value (rounded)
+ *****************************************************************************/
+static unsigned char scale(unsigned char ucValue, unsigned char ucFactor)
+{
+	return (unsigned char)((((unsigned int)ucValue * ((unsigned int)ucFactor + (ucFactor >> 7))) + 128) >> 8);
+}
+
+
+/** ***************************************************************************
+ * @brief Convert a hue to a fully saturated color
+ *
+ * hue * 6 selects the sector (high byte) and the position inside of the
+ * sector (low byte). One channel is 255, one is 0 and the third one ramps.
+ *
+ * @param [in] ucHue: hue [0-255], 0: red, 85: green, 170: blue
+ * @param [out] aucColor: color (red, green, blue)
+ * @return no return value
+ *****************************************************************************/
+void Color_Hue(unsigned char ucHue, unsigned char* aucColor)
+{
+	unsigned int uiScaled = (unsigned int)ucHue * 6;
+	unsigned char ucRise = (unsigned char)uiScaled;
+	unsigned char ucFall = 255 - ucRise;
+
+	switch(uiScaled >> 8)
+	{
+		case 0: // red -> yellow
+		aucColor[0] = 255;
+		aucColor[1] = ucRise;
+		aucColor[2] = 0;
+		break;
+
+		case 1: // yellow -> green
+		aucColor[0] = ucFall;
+		aucColor[1] = 255;
+		aucColor[2] = 0;
+		break;
+
+		case 2: // green -> cyan
+		aucColor[0] = 0;
+		aucColor[1] = 255;
+		aucColor[2] = ucRise;
+		break;
+
+		case 3: // cyan -> blue
+		aucColor[0] = 0;
+		aucColor[1] = ucFall;
+		aucColor[2] = 255;
+		break;
+
+		case 4: // blue -> magenta
+		aucColor[0] = ucRise;
+		aucColor[1] = 0;
+		aucColor[2] = 255;
+		break;
+
+		default: // magenta -> red
+		aucColor[0] = 255;
+		aucColor[1] = 0;
+		aucColor[2] = ucFall;
+		break;
+	}
+}
+
+
+/** ***************************************************************************
+ * @brief Convert a hue in degree to the 8bit hue
+ *
+ * degree * 256/360 as degree * 182 / 256 (16bit, no division).
+ *
+ * @param [in] uiDegree: hue [0-359] degree, larger values wrap around
+ * @return hue [0-255]
+ *****************************************************************************/
+unsigned char Color_Degree(unsigned int uiDegree)
+{
+	while(uiDegree>=360)
+	{
+		uiDegree -= 360;
+	}
+	return (unsigned char)(((uiDegree * 182) + 128) >> 8);
+}
+
+
+/** ***************************************************************************
+ * @brief Convert a HSV color to RGB
+ *
+ * @param [in] ucHue: hue [0-255], 0: red, 85: green, 170: blue
+ * @param [in] ucSaturation: saturation [0-255], 0: white
+ * @param [in] ucValue: value [0-255], 0: off
+ * @param [out] aucColor: color (red, green, blue)
+ * @return no return value
+ *****************************************************************************/
+void Color_HSV(unsigned char ucHue, unsigned char ucSaturation, unsigned char ucValue, unsigned char* aucColor)
+{
+	unsigned char i;
+
+	Color_Hue(ucHue, aucColor);
+	for(i=0;i<3;i++)
+	{
+		aucColor[i] = scale(255 - scale(255 - aucColor[i], ucSaturation), ucValue);
+	}
+}
+
+
+/** ***************************************************************************
+ * @brief Convert a color temperature to RGB
+ *
+ * @param [in] uiKelvin: color temperature [K], limited to
+ * [COLOR_KELVIN_MIN-COLOR_KELVIN_MAX]
+ * @param [in] ucBrightness: brightness [0-255], 0: off
+ * @param [out] aucColor: color (red, green, blue)
+ * @return no return value
+ *****************************************************************************/
+void Color_Kelvin(unsigned int uiKelvin, unsigned char ucBrightness, unsigned char* aucColor)
+{
+	unsigned char i;
+	unsigned char ucIndex;
+	unsigned char ucFraction;
+	unsigned char ucFrom;
+	unsigned char ucTo;
+	unsigned int uiOffset;
+
+	if(uiKelvin<COLOR_KELVIN_MIN)
+	{
+		uiKelvin = COLOR_KELVIN_MIN;
+	}
+	if(uiKelvin>COLOR_KELVIN_MAX)
+	{
+		uiKelvin = COLOR_KELVIN_MAX;
+	}
+	uiOffset = uiKelvin - COLOR_KELVIN_MIN;
+	ucIndex = (unsigned char)(uiOffset / COLOR_KELVIN_STEP);
+	ucFraction = (unsigned char)((((uiOffset - ((unsigned int)ucIndex * COLOR_KELVIN_STEP)) * 655) + 128) >> 8); // remainder * 256/100
+	if(ucIndex>=(KELVIN_ENTRIES-1)) // COLOR_KELVIN_MAX: no next entry
+	{
+		ucIndex = KELVIN_ENTRIES-2;
+		ucFraction = 255;
+	}
+
+	for(i=0;i<3;i++)
+	{
+		ucFrom = pgm_read_byte(&aucColorKelvin[(ucIndex*3)+i]);
+		ucTo = pgm_read_byte(&aucColorKelvin[((ucIndex+1)*3)+i]);
+		if(ucTo>=ucFrom)
+		{
+			aucColor[i] = ucFrom + scale(ucTo - ucFrom, ucFraction);
+		}
+		else
+		{
+			aucColor[i] = ucFrom - scale(ucFrom - ucTo, ucFraction);
+		}
+		aucColor[i] = scale(aucColor[i], ucBrightness);
+	}
+}
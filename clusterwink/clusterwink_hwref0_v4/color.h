@@ -0,0 +1,38 @@
+/** ***************************************************************************
+ * @file color.h
+ * @brief Integer color conversions for the RGB strip
+ *
+ * - Hue wheel
+ * @n An 8bit hue [0-255] is converted to a fully saturated color with a
+ * multiplication by 6 and a linear ramp per sector (red, yellow, green, cyan,
+ * blue, magenta). No table and no division is needed.
+ *
+ * - HSV
+ * @n Hue wheel, then the saturation blends towards white and the value
+ * scales the result. The hue is given as 8bit fraction of the circle or in
+ * degree [0-359].
+ *
+ * - Color temperature
+ * @n Black body colors from COLOR_KELVIN_MIN to COLOR_KELVIN_MAX in steps of
+ * COLOR_KELVIN_STEP are kept in a table in the flash memory, temperatures in
+ * between are interpolated, outside they are limited. The brightness scales
+ * the result.
+ *
+ * @author agent
+ * @date 16.10.2026
+ *****************************************************************************/
+
+
+#ifndef COLOR_H_
+#define COLOR_H_
+
+#define COLOR_KELVIN_MIN		1000	///< lowest color temperature of the table [K]
+#define COLOR_KELVIN_MAX		10000	///< highest color temperature of the table [K]
+#define COLOR_KELVIN_STEP		100		///< color temperature step of the table [K]
+
+void Color_Hue(unsigned char ucHue, unsigned char* aucColor);
+unsigned char Color_Degree(unsigned int uiDegree);
+void Color_HSV(unsigned char ucHue, unsigned char ucSaturation, unsigned char ucValue, unsigned char* aucColor);
+void Color_Kelvin(unsigned int uiKelvin, unsigned char ucBrightness, unsigned char* aucColor);
+
+#endif /* COLOR_H_ */
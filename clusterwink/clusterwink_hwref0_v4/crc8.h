@@ -0,0 +1,37 @@
+/** ***************************************************************************
+ * @file crc8.h
+ * @brief CRC-8 checksum of the framed SPI protocol
+ *
+ * CRC8_Update() is inlined so that ISR(SPI_STC_vect) can update the checksum
+ * of a frame with every received byte.
+ *
+ * @author agent
+ * @date 16.10.2026
+ *****************************************************************************/
+
+
+#ifndef CRC8_H_
+#define CRC8_H_
+
+#include <avr/pgmspace.h>
+
+#define CRC8_INIT		0x00	///< initial value of the checksum
+
+extern const unsigned char aucCRC8Table[256] PROGMEM;
+
+
+/** ***************************************************************************
+ * @brief Add one byte to a CRC-8
+ *
+ * @param [in] ucCRC: checksum of the previous bytes (CRC8_INIT for the first byte)
+ * @param [in] ucData: next byte
+ * @return updated checksum
+ *****************************************************************************/
+static inline unsigned char CRC8_Update(unsigned char ucCRC, unsigned char ucData)
+{
+	return pgm_read_byte(&aucCRC8Table[ucCRC ^ ucData]);
+}
+
+unsigned char CRC8_Calculate(const unsigned char* aucData, unsigned char ucLength);
+
+#endif /* CRC8_H_ */
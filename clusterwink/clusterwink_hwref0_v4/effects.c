@@ -0,0 +1,369 @@
+/** ***************************************************************************
+ * @file effects.c
+ * @brief On-device animated effects of the RGB strip
+ *
+ * An effect (rainbow, chase, breathe, twinkle) with its speed, density and
+ * two colors is uploaded once. The effects task advances it with
+ * Effect_Step() and renders every step into the back frame with
+ * Effect_Render(), which is then latched. The strip is animated at the rate
+ * of the effects task without any SPI traffic.
+ *
+ * The phase is a 16bit fraction of a cycle, the speed adds ucSpeed*16 per
+ * step (speed 16: one cycle in 256 steps). All calculations are 8 and 16bit
+ * integer operations: the brightness of "breathe" comes from a sine table in
+ * the flash memory, the colors of "rainbow" from the hue wheel (color.c) and
+ * "twinkle" uses a 16bit xorshift generator. The colors are corrected with
+ * the selected RGB gamma table. Effect_Stop() may be called by an ISR, all
+ * other functions are called from the main loop only.
+ *
+ * @author agent
+ * @date 16.10.2026
+ *****************************************************************************/
+
+
+#include <avr/pgmspace.h>
+#include "gamma.h"
+#include "color.h"
+#include "rgbooster.h"
+#include "effects.h"
+
+
+/** Brightness of one cycle: round(127.5 - 127.5*cos(2*pi*i/256)), 0 at the start, 255 at the half */
+const unsigned char aucEffectSine[256] PROGMEM =
+{
+	0x00, 0x00, 0x00, 0x00, 0x01, 0x01, 0x01, 0x02, 0x02, 0x03, 0x04, 0x05, 0x05, 0x06, 0x07, 0x09,
+	0x0A, 0x0B, 0x0C, 0x0E, 0x0F, 0x11, 0x12, 0x14, 0x15, 0x17, 0x19, 0x1B, 0x1D, 0x1F, 0x21, 0x23,
+	0x25, 0x28, 0x2A, 0x2C, 0x2F, 0x31, 0x34, 0x36, 0x39, 0x3B, 0x3E, 0x41, 0x43, 0x46, 0x49, 0x4C,
+	0x4F, 0x52, 0x55, 0x58, 0x5A, 0x5D, 0x61, 0x64, 0x67, 0x6A, 0x6D, 0x70, 0x73, 0x76, 0x79, 0x7C,
+	0x7F, 0x83, 0x86, 0x89, 0x8C, 0x8F, 0x92, 0x95, 0x98, 0x9B, 0x9E, 0xA2, 0xA5, 0xA7, 0xAA, 0xAD,
+	0xB0, 0xB3, 0xB6, 0xB9, 0xBC, 0xBE, 0xC1, 0xC4, 0xC6, 0xC9, 0xCB, 0xCE, 0xD0, 0xD3, 0xD5, 0xD7,
+	0xDA, 0xDC, 0xDE, 0xE0, 0xE2, 0xE4, 0xE6, 0xE8, 0xEA, 0xEB, 0xED, 0xEE, 0xF0, 0xF1, 0xF3, 0xF4,
+	0xF5, 0xF6, 0xF8, 0xF9, 0xFA, 0xFA, 0xFB, 0xFC, 0xFD, 0xFD, 0xFE, 0xFE, 0xFE, 0xFF, 0xFF, 0xFF,
+	0xFF, 0xFF, 0xFF, 0xFF, 0xFE, 0xFE, 0xFE, 0xFD, 0xFD, 0xFC, 0xFB, 0xFA, 0xFA, 0xF9, 0xF8, 0xF6,
+	0xF5, 0xF4, 0xF3, 0xF1, 0xF0, 0xEE, 0xED, 0xEB, 0xEA, 0xE8, 0xE6, 0xE4, 0xE2, 0xE0, 0xDE, 0xDC,
+	0xDA, 0xD7, 0xD5, 0xD3, 0xD0, 0xCE, 0xCB, 0xC9, 0xC6, 0xC4, 0xC1, 0xBE, 0xBC, 0xB9, 0xB6, 0xB3,
+	0xB0, 0xAD, 0xAA, 0xA7, 0xA5, 0xA2, 0x9E, 0x9B, 0x98, 0x95, 0x92, 0x8F, 0x8C, 0x89, 0x86, 0x83,
+	0x80, 0x7C, 0x79, 0x76, 0x73, 0x70, 0x6D, 0x6A, 0x67, 0x64, 0x61, 0x5D, 0x5A, 0x58, 0x55, 0x52,
+	0x4F, 0x4C, 0x49, 0x46, 0x43, 0x41, 0x3E, 0x3B, 0x39, 0x36, 0x34, 0x31, 0x2F, 0x2C, 0x2A, 0x28,
+	0x25, 0x23, 0x21, 0x1F, 0x1D, 0x1B, 0x19, 0x17, 0x15, 0x14, 0x12, 0x11, 0x0F, 0x0E, 0x0C, 0x0B,
+	0x0A, 0x09, 0x07, 0x06, 0x05, 0x05, 0x04, 0x03, 0x02, 0x02, 0x01, 0x01, 0x01, 0x00, 0x00, 0x00
+};
+
+static EFFECT sEffect;						///< running effect
+static volatile unsigned char ucRunning = 0;	///< effect running (cleared by ISRs too)
+static unsigned int uiPhase = 0;			///< fraction of the cycle [0-0xFFFF]
+static unsigned char ucPosition = 0;		///< chase: first lit LED [0-ucDensity-1]
+static unsigned int uiRandom = 1;			///< twinkle: state of the xorshift generator, never 0
+
+
+/** ***************************************************************************
+ * @brief Blend two values
+ *
+ * The level is stretched to [0-256], so that level 255 gives the end value.
+ *
+ * @param [in] ucFrom: value at level 0
+ * @param [in] ucTo: value at level 255
+ * @param [in] ucLevel: level [0-255]
+ * @return blended value
+ *****************************************************************************/
+static unsigned char blend(unsigned char ucFrom, unsigned char ucTo, unsigned char ucLevel)
+{
+	unsigned int uiLevel = (unsigned int)ucLevel + (ucLevel >> 7);
+
+	if(ucTo>=ucFrom)
+	{
+		return ucFrom + (unsigned char)((((unsigned int)(ucTo - ucFrom) * uiLevel) + 128) >> 8);
+	}
+	return ucFrom - (unsigned char)((((unsigned int)(ucFrom - ucTo) * uiLevel) + 128) >> 8);
+}
+
+
+/** ***************************************************************************
+ * @brief Move a value towards a target by a fraction of the difference
+ *
+ * At least one step is done, so the target is always reached.
+ *
+ * @param [in] ucValue: current value
+ * @param [in] ucTarget: target value
+ * @param [in] ucRate: fraction [1/256]
+ * @return new value
+ *****************************************************************************/
+static unsigned char fade(unsigned char ucValue, unsigned char ucTarget, unsigned char ucRate)
+{
+	unsigned char ucStep;
+
+	if(ucValue>ucTarget)
+	{
+		ucStep = (unsigned char)(((unsigned int)(ucValue - ucTarget) * ucRate) >> 8);
+		return ucValue - ((ucStep) ? ucStep : 1);
+	}
+	if(ucValue<ucTarget)
+	{
+		ucStep = (unsigned char)(((unsigned int)(ucTarget - ucValue) * ucRate) >> 8);
+		return ucValue + ((ucStep) ? ucStep : 1);
+	}
+	return ucValue;
+}
+
+
+/** ***************************************************************************
+ * @brief Get the next random value (xorshift, period 65535)
+ *
+ * @param [void] no input
+ * @return random value [0-255]
+ *****************************************************************************/
+static unsigned char random8(void)
+{
+	unsigned int uiValue = uiRandom;
+
+	uiValue ^= uiValue << 7;
+	uiValue ^= uiValue >> 9;
+	uiValue ^= uiValue << 8;
+	uiRandom = uiValue;
+	return (unsigned char)uiValue;
+}
+
+
+/** ***************************************************************************
+ * @brief Write one LED in wire order
+ *
+ * @param [out] pucLED: LED in the frame
+ * @param [in] aucColor: corrected color (red, green, blue)
+ * @return no return value
+ *****************************************************************************/
+static inline void setLED(unsigned char* pucLED, const unsigned char* aucColor)
+{
+	pucLED[GRB_GREEN] = aucColor[1];
+	pucLED[GRB_RED] = aucColor[0];
+	pucLED[GRB_BLUE] = aucColor[2];
+}
+
+
+/** ***************************************************************************
+ * @brief Decode the payload of the effect command
+ *
+ * Payload: [EE, SS, DD, RR, GG, BB, RB, GB, BB]
+ * - EE: effect (EFFECT_RAINBOW, ...)
+ * - SS: speed, DD: density (see EFFECT)
+ * - RR, GG, BB: foreground color, RB, GB, BB: background color
+ *
+ * @param [out] psEffect: decoded effect
+ * @param [in] aucPayload: payload of the command
+ * @param [in] ucLength: amount of payload bytes
+ * @return 1: valid effect  0: wrong length or unknown effect
+ *****************************************************************************/
+unsigned char Effect_Parse(EFFECT* psEffect, const unsigned char* aucPayload, unsigned char ucLength)
+{
+	unsigned char i;
+
+	if((ucLength!=EFFECT_PAYLOAD_SIZE) || (aucPayload[0]>=EFFECTS))
+	{
+		return 0;
+	}
+	psEffect->ucEffect = aucPayload[0];
+	psEffect->ucSpeed = aucPayload[1];
+	psEffect->ucDensity = aucPayload[2];
+	for(i=0;i<3;i++)
+	{
+		psEffect->aucColor[i] = aucPayload[3+i];
+		psEffect->aucBackground[i] = aucPayload[6+i];
+	}
+	if((psEffect->ucEffect==EFFECT_CHASE) && (psEffect->ucDensity==0))
+	{
+		psEffect->ucDensity = 1;
+	}
+	return 1;
+}
+
+
+/** ***************************************************************************
+ * @brief Encode the running (or last) effect as payload of the effect command
+ *
+ * Effect_Parse() of the payload gives the same effect again (scenes).
+ *
+ * @param [out] aucPayload: payload (EFFECT_PAYLOAD_SIZE bytes)
+ * @return no return value
+ *****************************************************************************/
+void Effect_GetPayload(unsigned char* aucPayload)
+{
+	unsigned char i;
+
+	aucPayload[0] = sEffect.ucEffect;
+	aucPayload[1] = sEffect.ucSpeed;
+	aucPayload[2] = sEffect.ucDensity;
+	for(i=0;i<3;i++)
+	{
+		aucPayload[3+i] = sEffect.aucColor[i];
+		aucPayload[6+i] = sEffect.aucBackground[i];
+	}
+}
+
+
+/** ***************************************************************************
+ * @brief Start an effect
+ *
+ * A running effect is replaced, the phase starts at 0.
+ *
+ * @param [in] psEffect: effect (copied)
+ * @return no return value
+ *****************************************************************************/
+void Effect_Start(const EFFECT* psEffect)
+{
+	ucRunning = 0;
+	sEffect = *psEffect;
+	uiPhase = 0;
+	ucPosition = 0;
+	ucRunning = 1;
+}
+
+
+/** ***************************************************************************
+ * @brief Stop the running effect
+ *
+ * The strip keeps the last rendered frame.
+ *
+ * @param [void] no input
+ * @return no return value
+ *****************************************************************************/
+void Effect_Stop(void)
+{
+	ucRunning = 0;
+}
+
+
+/** ***************************************************************************
+ * @brief Check if an effect is running
+ *
+ * @param [void] no input
+ * @return 1: running  0: stopped
+ *****************************************************************************/
+unsigned char Effect_IsRunning(void)
+{
+	return ucRunning;
+}
+
+
+/** ***************************************************************************
+ * @brief Advance the running effect by one step
+ *
+ * Called once per period of the effects task after the frame of the
+ * current step has been rendered, also if it could not be rendered (back
+ * frame busy), so the speed does not depend on the load.
+ *
+ * @param [void] no input
+ * @return no return value
+ *****************************************************************************/
+void Effect_Step(void)
+{
+	unsigned int uiStep = (unsigned int)sEffect.ucSpeed << 4;
+	unsigned char ucSteps = (unsigned char)(((uiPhase & 0xFF) + uiStep) >> 8);
+
+	if(!ucRunning)
+	{
+		return;
+	}
+	uiPhase += uiStep;
+	if(sEffect.ucEffect==EFFECT_CHASE) // one LED per 256 phase units
+	{
+		while(ucSteps--)
+		{
+			ucPosition++;
+			if(ucPosition>=sEffect.ucDensity)
+			{
+				ucPosition = 0;
+			}
+		}
+	}
+}
+
+
+/** ***************************************************************************
+ * @brief Render the current step of the running effect into a frame
+ *
+ * - rainbow: LED i gets the hue phase + i*DENSITY/16
+ * - chase: LEDs at the position + n*DENSITY get the foreground, all others
+ *   the background color
+ * - breathe: all LEDs blend from the background to the foreground color and
+ *   back with the sine table
+ * - twinkle: every LED fades towards the background by SPEED/256 of the
+ *   difference and lights up in the foreground color with a chance of
+ *   DENSITY/256. The previous frame is faded, so it has to be passed in.
+ *
+ * @param [in,out] pucFrame: frame in wire order (previous frame for twinkle)
+ * @param [in] uiLEDs: amount of LEDs
+ * @return no return value
+ *****************************************************************************/
+void Effect_Render(unsigned char* pucFrame, unsigned int uiLEDs)
+{
+	unsigned int i;
+	unsigned char j;
+	unsigned char ucLevel;
+	unsigned char ucSpacing;
+	unsigned int uiHue;
+	unsigned char aucColor[3];
+	unsigned char aucBackground[3];
+
+	for(j=0;j<3;j++)
+	{
+		aucColor[j] = Gamma_RGB(sEffect.aucColor[j]);
+		aucBackground[j] = Gamma_RGB(sEffect.aucBackground[j]);
+	}
+
+	switch(sEffect.ucEffect)
+	{
+		case EFFECT_RAINBOW:
+		uiHue = uiPhase;
+		for(i=0;i<uiLEDs;i++)
+		{
+			Color_Hue((unsigned char)(uiHue >> 8), aucColor);
+			for(j=0;j<3;j++)
+			{
+				aucColor[j] = Gamma_RGB(aucColor[j]);
+			}
+			setLED(pucFrame, aucColor);
+			pucFrame += 3;
+			uiHue += (unsigned int)sEffect.ucDensity << 4;
+		}
+		break;
+
+		case EFFECT_CHASE:
+		ucSpacing = ucPosition; // LEDs until the next lit one
+		for(i=0;i<uiLEDs;i++)
+		{
+			setLED(pucFrame, (ucSpacing) ? aucBackground : aucColor);
+			pucFrame += 3;
+			ucSpacing = (ucSpacing) ? (ucSpacing - 1) : (sEffect.ucDensity - 1);
+		}
+		break;
+
+		case EFFECT_BREATHE:
+		ucLevel = pgm_read_byte(&aucEffectSine[uiPhase >> 8]);
+		for(j=0;j<3;j++)
+		{
+			aucColor[j] = Gamma_RGB(blend(sEffect.aucBackground[j], sEffect.aucColor[j], ucLevel));
+		}
+		for(i=0;i<uiLEDs;i++)
+		{
+			setLED(pucFrame, aucColor);
+			pucFrame += 3;
+		}
+		break;
+
+		default: // twinkle
+		for(i=0;i<uiLEDs;i++)
+		{
+			if(random8()<sEffect.ucDensity)
+			{
+				setLED(pucFrame, aucColor);
+			}
+			else
+			{
+				pucFrame[GRB_GREEN] = fade(pucFrame[GRB_GREEN], aucBackground[1], sEffect.ucSpeed);
+				pucFrame[GRB_RED] = fade(pucFrame[GRB_RED], aucBackground[0], sEffect.ucSpeed);
+				pucFrame[GRB_BLUE] = fade(pucFrame[GRB_BLUE], aucBackground[2], sEffect.ucSpeed);
+			}
+			pucFrame += 3;
+		}
+		break;
+	}
+}
@@ -0,0 +1,46 @@
+/** ***************************************************************************
+ * @file effects.h
+ * @brief On-device animated effects of the RGB strip
+ *
+ * An effect (rainbow, chase, breathe, twinkle) with its speed, density and
+ * two colors is uploaded once. The effects task advances it with
+ * Effect_Step() and renders every step into the back frame with
+ * Effect_Render(), which is then latched. The strip is animated at the rate
+ * of the effects task without any SPI traffic.
+ *
+ * @author agent
+ * @date 16.10.2026
+ *****************************************************************************/
+
+
+#ifndef EFFECTS_H_
+#define EFFECTS_H_
+
+#define EFFECT_RAINBOW			0		///< effect: hue wheel moving along the strip
+#define EFFECT_CHASE			1		///< effect: every DENSITY-th LED lit, moving along the strip
+#define EFFECT_BREATHE			2		///< effect: whole strip fading between the two colors (sine)
+#define EFFECT_TWINKLE			3		///< effect: random LEDs lighting up and fading out
+#define EFFECTS					4		///< amount of effects
+
+#define EFFECT_PAYLOAD_SIZE		9		///< payload of the effect command (see Effect_Parse())
+
+
+/** Effect program */
+typedef struct
+{
+	unsigned char ucEffect;				///< effect (EFFECT_RAINBOW, ...)
+	unsigned char ucSpeed;				///< phase advance per step [1/16 of 1/256 cycle], 0: still
+	unsigned char ucDensity;			///< hue change per LED (rainbow), spacing of the lit LEDs (chase), chance to light up (twinkle)
+	unsigned char aucColor[3];			///< foreground color (red, green, blue)
+	unsigned char aucBackground[3];		///< background color (red, green, blue)
+} EFFECT;
+
+unsigned char Effect_Parse(EFFECT* psEffect, const unsigned char* aucPayload, unsigned char ucLength);
+void Effect_GetPayload(unsigned char* aucPayload);
+void Effect_Start(const EFFECT* psEffect);
+void Effect_Stop(void);
+unsigned char Effect_IsRunning(void);
+void Effect_Step(void);
+void Effect_Render(unsigned char* pucFrame, unsigned int uiLEDs);
+
+#endif /* EFFECTS_H_ */
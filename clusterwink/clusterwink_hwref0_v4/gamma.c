@@ -0,0 +1,177 @@
+/** ***************************************************************************
+ * @file gamma.c
+ * @brief Perceptual brightness correction of the power LED and the RGB strip
+ *
+ * - Power LED
+ * @n Brightness levels are perceived lightness (CIE 1931 L*). A table in the
+ * flash memory converts them to the linear intensity of the PWM output.
+ *
+ * - RGB strip
+ * @n Color values are corrected with a gamma table in the flash memory
+ * before they are written to the framebuffer.
+ *
+ * Both corrections can be selected or disabled at runtime. No division is
+ * needed on the output path.
+ *
+ * @author agent
+ * @date 16.10.2026
+ *****************************************************************************/
+
+
+#include <avr/pgmspace.h>
+#include <util/atomic.h>
+#include "gamma.h"
+
+
+/**
+ * Linear intensity [0-0xFFFF] of the lightness L* = i*100/256 (i = 0-256)
+ * @n Y = L/903.3 for L <= 8, Y = ((L+16)/116)^3 above (L = L* = 0-100)
+ */
+const unsigned int auiGammaCIE1931[257] PROGMEM =
+{
+	0x0000, 0x001C, 0x0039, 0x0055, 0x0071, 0x008E, 0x00AA, 0x00C6,
+	0x00E3, 0x00FF, 0x011B, 0x0138, 0x0154, 0x0170, 0x018D, 0x01A9,
+	0x01C5, 0x01E2, 0x01FE, 0x021A, 0x0237, 0x0253, 0x0271, 0x028F,
+	0x02AE, 0x02CE, 0x02EF, 0x0311, 0x0335, 0x0359, 0x037E, 0x03A5,
+	0x03CC, 0x03F4, 0x041E, 0x0449, 0x0475, 0x04A2, 0x04D0, 0x04FF,
+	0x0530, 0x0562, 0x0595, 0x05C9, 0x05FF, 0x0636, 0x066E, 0x06A7,
+	0x06E2, 0x071E, 0x075B, 0x079A, 0x07DA, 0x081C, 0x085F, 0x08A3,
+	0x08E9, 0x0930, 0x0979, 0x09C4, 0x0A0F, 0x0A5D, 0x0AAB, 0x0AFC,
+	0x0B4E, 0x0BA1, 0x0BF6, 0x0C4D, 0x0CA5, 0x0CFF, 0x0D5B, 0x0DB8,
+	0x0E17, 0x0E78, 0x0EDA, 0x0F3E, 0x0FA4, 0x100C, 0x1075, 0x10E0,
+	0x114D, 0x11BC, 0x122C, 0x129F, 0x1313, 0x1389, 0x1401, 0x147B,
+	0x14F7, 0x1575, 0x15F5, 0x1677, 0x16FA, 0x1780, 0x1808, 0x1891,
+	0x191D, 0x19AB, 0x1A3B, 0x1ACD, 0x1B61, 0x1BF7, 0x1C90, 0x1D2A,
+	0x1DC7, 0x1E66, 0x1F07, 0x1FAA, 0x2050, 0x20F7, 0x21A1, 0x224D,
+	0x22FC, 0x23AD, 0x2460, 0x2515, 0x25CD, 0x2687, 0x2744, 0x2803,
+	0x28C4, 0x2988, 0x2A4E, 0x2B16, 0x2BE2, 0x2CAF, 0x2D7F, 0x2E52,
+	0x2F27, 0x2FFE, 0x30D8, 0x31B5, 0x3294, 0x3376, 0x345B, 0x3542,
+	0x362C, 0x3718, 0x3807, 0x38F9, 0x39EE, 0x3AE5, 0x3BDF, 0x3CDB,
+	0x3DDB, 0x3EDD, 0x3FE2, 0x40EA, 0x41F5, 0x4302, 0x4412, 0x4526,
+	0x463C, 0x4755, 0x4871, 0x498F, 0x4AB1, 0x4BD6, 0x4CFE, 0x4E28,
+	0x4F56, 0x5087, 0x51BA, 0x52F1, 0x542B, 0x5568, 0x56A8, 0x57EB,
+	0x5931, 0x5A7B, 0x5BC7, 0x5D17, 0x5E6A, 0x5FC0, 0x6119, 0x6276,
+	0x63D6, 0x6539, 0x669F, 0x6808, 0x6975, 0x6AE6, 0x6C59, 0x6DD0,
+	0x6F4A, 0x70C8, 0x7249, 0x73CD, 0x7555, 0x76E0, 0x786F, 0x7A01,
+	0x7B97, 0x7D30, 0x7ECD, 0x806D, 0x8211, 0x83B8, 0x8563, 0x8712,
+	0x88C4, 0x8A7A, 0x8C33, 0x8DF0, 0x8FB1, 0x9175, 0x933D, 0x9509,
+	0x96D8, 0x98AB, 0x9A82, 0x9C5D, 0x9E3B, 0xA01E, 0xA204, 0xA3EE,
+	0xA5DC, 0xA7CD, 0xA9C3, 0xABBC, 0xADB9, 0xAFBB, 0xB1C0, 0xB3C9,
+	0xB5D6, 0xB7E7, 0xB9FC, 0xBC15, 0xBE32, 0xC053, 0xC279, 0xC4A2,
+	0xC6CF, 0xC901, 0xCB36, 0xCD70, 0xCFAE, 0xD1F0, 0xD436, 0xD680,
+	0xD8CF, 0xDB21, 0xDD78, 0xDFD4, 0xE233, 0xE497, 0xE6FF, 0xE96B,
+	0xEBDC, 0xEE51, 0xF0CA, 0xF348, 0xF5CA, 0xF851, 0xFADC, 0xFD6B,
+	0xFFFF
+};
+
+/** Corrected color values: round(255 * (i/255)^gamma) */
+const unsigned char aucGammaRGB[GAMMA_RGB_CURVES-1][256] PROGMEM =
+{
+	{ // 1.8
+		0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x02,
+		0x02, 0x02, 0x02, 0x02, 0x03, 0x03, 0x03, 0x03, 0x04, 0x04, 0x04, 0x04, 0x05, 0x05, 0x05, 0x06,
+		0x06, 0x06, 0x07, 0x07, 0x08, 0x08, 0x08, 0x09, 0x09, 0x0A, 0x0A, 0x0A, 0x0B, 0x0B, 0x0C, 0x0C,
+		0x0D, 0x0D, 0x0E, 0x0E, 0x0F, 0x0F, 0x10, 0x10, 0x11, 0x11, 0x12, 0x12, 0x13, 0x13, 0x14, 0x15,
+		0x15, 0x16, 0x16, 0x17, 0x18, 0x18, 0x19, 0x1A, 0x1A, 0x1B, 0x1C, 0x1C, 0x1D, 0x1E, 0x1E, 0x1F,
+		0x20, 0x20, 0x21, 0x22, 0x23, 0x23, 0x24, 0x25, 0x26, 0x26, 0x27, 0x28, 0x29, 0x29, 0x2A, 0x2B,
+		0x2C, 0x2D, 0x2E, 0x2E, 0x2F, 0x30, 0x31, 0x32, 0x33, 0x34, 0x35, 0x35, 0x36, 0x37, 0x38, 0x39,
+		0x3A, 0x3B, 0x3C, 0x3D, 0x3E, 0x3F, 0x40, 0x41, 0x42, 0x43, 0x44, 0x45, 0x46, 0x47, 0x48, 0x49,
+		0x4A, 0x4B, 0x4C, 0x4D, 0x4E, 0x4F, 0x50, 0x51, 0x52, 0x53, 0x54, 0x56, 0x57, 0x58, 0x59, 0x5A,
+		0x5B, 0x5C, 0x5D, 0x5F, 0x60, 0x61, 0x62, 0x63, 0x64, 0x66, 0x67, 0x68, 0x69, 0x6B, 0x6C, 0x6D,
+		0x6E, 0x6F, 0x71, 0x72, 0x73, 0x74, 0x76, 0x77, 0x78, 0x7A, 0x7B, 0x7C, 0x7E, 0x7F, 0x80, 0x81,
+		0x83, 0x84, 0x86, 0x87, 0x88, 0x8A, 0x8B, 0x8C, 0x8E, 0x8F, 0x91, 0x92, 0x93, 0x95, 0x96, 0x98,
+		0x99, 0x9A, 0x9C, 0x9D, 0x9F, 0xA0, 0xA2, 0xA3, 0xA5, 0xA6, 0xA8, 0xA9, 0xAB, 0xAC, 0xAE, 0xAF,
+		0xB1, 0xB2, 0xB4, 0xB5, 0xB7, 0xB8, 0xBA, 0xBC, 0xBD, 0xBF, 0xC0, 0xC2, 0xC3, 0xC5, 0xC7, 0xC8,
+		0xCA, 0xCC, 0xCD, 0xCF, 0xD0, 0xD2, 0xD4, 0xD5, 0xD7, 0xD9, 0xDA, 0xDC, 0xDE, 0xE0, 0xE1, 0xE3,
+		0xE5, 0xE6, 0xE8, 0xEA, 0xEC, 0xED, 0xEF, 0xF1, 0xF3, 0xF4, 0xF6, 0xF8, 0xFA, 0xFB, 0xFD, 0xFF
+	},
+	{ // 2.2
+		0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01,
+		0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x02, 0x02, 0x02, 0x02, 0x02, 0x02, 0x02,
+		0x03, 0x03, 0x03, 0x03, 0x03, 0x04, 0x04, 0x04, 0x04, 0x05, 0x05, 0x05, 0x05, 0x06, 0x06, 0x06,
+		0x06, 0x07, 0x07, 0x07, 0x08, 0x08, 0x08, 0x09, 0x09, 0x09, 0x0A, 0x0A, 0x0B, 0x0B, 0x0B, 0x0C,
+		0x0C, 0x0D, 0x0D, 0x0D, 0x0E, 0x0E, 0x0F, 0x0F, 0x10, 0x10, 0x11, 0x11, 0x12, 0x12, 0x13, 0x13,
+		0x14, 0x14, 0x15, 0x16, 0x16, 0x17, 0x17, 0x18, 0x19, 0x19, 0x1A, 0x1A, 0x1B, 0x1C, 0x1C, 0x1D,
+		0x1E, 0x1E, 0x1F, 0x20, 0x21, 0x21, 0x22, 0x23, 0x23, 0x24, 0x25, 0x26, 0x27, 0x27, 0x28, 0x29,
+		0x2A, 0x2B, 0x2B, 0x2C, 0x2D, 0x2E, 0x2F, 0x30, 0x31, 0x31, 0x32, 0x33, 0x34, 0x35, 0x36, 0x37,
+		0x38, 0x39, 0x3A, 0x3B, 0x3C, 0x3D, 0x3E, 0x3F, 0x40, 0x41, 0x42, 0x43, 0x44, 0x45, 0x46, 0x47,
+		0x49, 0x4A, 0x4B, 0x4C, 0x4D, 0x4E, 0x4F, 0x51, 0x52, 0x53, 0x54, 0x55, 0x57, 0x58, 0x59, 0x5A,
+		0x5B, 0x5D, 0x5E, 0x5F, 0x61, 0x62, 0x63, 0x64, 0x66, 0x67, 0x69, 0x6A, 0x6B, 0x6D, 0x6E, 0x6F,
+		0x71, 0x72, 0x74, 0x75, 0x77, 0x78, 0x79, 0x7B, 0x7C, 0x7E, 0x7F, 0x81, 0x82, 0x84, 0x85, 0x87,
+		0x89, 0x8A, 0x8C, 0x8D, 0x8F, 0x91, 0x92, 0x94, 0x95, 0x97, 0x99, 0x9A, 0x9C, 0x9E, 0x9F, 0xA1,
+		0xA3, 0xA5, 0xA6, 0xA8, 0xAA, 0xAC, 0xAD, 0xAF, 0xB1, 0xB3, 0xB5, 0xB6, 0xB8, 0xBA, 0xBC, 0xBE,
+		0xC0, 0xC2, 0xC4, 0xC5, 0xC7, 0xC9, 0xCB, 0xCD, 0xCF, 0xD1, 0xD3, 0xD5, 0xD7, 0xD9, 0xDB, 0xDD,
+		0xDF, 0xE1, 0xE3, 0xE5, 0xE7, 0xEA, 0xEC, 0xEE, 0xF0, 0xF2, 0xF4, 0xF6, 0xF8, 0xFB, 0xFD, 0xFF
+	},
+	{ // 2.8
+		0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+		0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01, 0x01, 0x01, 0x01,
+		0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x02, 0x02, 0x02, 0x02, 0x02, 0x02, 0x02,
+		0x02, 0x03, 0x03, 0x03, 0x03, 0x03, 0x03, 0x03, 0x04, 0x04, 0x04, 0x04, 0x04, 0x05, 0x05, 0x05,
+		0x05, 0x06, 0x06, 0x06, 0x06, 0x07, 0x07, 0x07, 0x07, 0x08, 0x08, 0x08, 0x09, 0x09, 0x09, 0x0A,
+		0x0A, 0x0A, 0x0B, 0x0B, 0x0B, 0x0C, 0x0C, 0x0D, 0x0D, 0x0D, 0x0E, 0x0E, 0x0F, 0x0F, 0x10, 0x10,
+		0x11, 0x11, 0x12, 0x12, 0x13, 0x13, 0x14, 0x14, 0x15, 0x15, 0x16, 0x16, 0x17, 0x18, 0x18, 0x19,
+		0x19, 0x1A, 0x1B, 0x1B, 0x1C, 0x1D, 0x1D, 0x1E, 0x1F, 0x20, 0x20, 0x21, 0x22, 0x23, 0x23, 0x24,
+		0x25, 0x26, 0x27, 0x27, 0x28, 0x29, 0x2A, 0x2B, 0x2C, 0x2D, 0x2E, 0x2F, 0x30, 0x31, 0x32, 0x32,
+		0x33, 0x34, 0x36, 0x37, 0x38, 0x39, 0x3A, 0x3B, 0x3C, 0x3D, 0x3E, 0x3F, 0x40, 0x42, 0x43, 0x44,
+		0x45, 0x46, 0x48, 0x49, 0x4A, 0x4B, 0x4D, 0x4E, 0x4F, 0x51, 0x52, 0x53, 0x55, 0x56, 0x57, 0x59,
+		0x5A, 0x5C, 0x5D, 0x5F, 0x60, 0x62, 0x63, 0x65, 0x66, 0x68, 0x69, 0x6B, 0x6D, 0x6E, 0x70, 0x72,
+		0x73, 0x75, 0x77, 0x78, 0x7A, 0x7C, 0x7E, 0x7F, 0x81, 0x83, 0x85, 0x87, 0x89, 0x8A, 0x8C, 0x8E,
+		0x90, 0x92, 0x94, 0x96, 0x98, 0x9A, 0x9C, 0x9E, 0xA0, 0xA2, 0xA4, 0xA7, 0xA9, 0xAB, 0xAD, 0xAF,
+		0xB1, 0xB4, 0xB6, 0xB8, 0xBA, 0xBD, 0xBF, 0xC1, 0xC4, 0xC6, 0xC8, 0xCB, 0xCD, 0xD0, 0xD2, 0xD5,
+		0xD7, 0xDA, 0xDC, 0xDF, 0xE1, 0xE4, 0xE7, 0xE9, 0xEC, 0xEF, 0xF1, 0xF4, 0xF7, 0xF9, 0xFC, 0xFF
+	}
+};
+
+const unsigned char* volatile pucGammaRGB = 0;	///< selected RGB table, 0: no correction (GAMMA_RGB_DEFAULT)
+static volatile unsigned char ucGammaPLED = GAMMA_PLED_DEFAULT;				///< selected power LED curve
+
+
+/** ***************************************************************************
+ * @brief Convert a brightness level of the power LED to the PWM intensity
+ *
+ * The CIE 1931 table has 256 segments, the low byte of the level
+ * interpolates linearly inside of a segment. Called by the SPI ISR.
+ *
+ * @param [in] uiLevel: brightness level [0-0xFFFF]
+ * @return linear intensity [0-0xFFFF]
+ *****************************************************************************/
+unsigned int Gamma_PLED(unsigned int uiLevel)
+{
+	unsigned int uiLow;
+	unsigned int uiHigh;
+	unsigned char ucIndex = (unsigned char)(uiLevel >> 8);
+
+	if((ucGammaPLED==GAMMA_PLED_LINEAR) || (uiLevel==0xFFFF)) // full level: full intensity, not the interpolation of the last segment
+	{
+		return uiLevel;
+	}
+	uiLow = pgm_read_word(&auiGammaCIE1931[ucIndex]);
+	uiHigh = pgm_read_word(&auiGammaCIE1931[ucIndex+1]);
+	return uiLow + (unsigned int)(((unsigned long)(uiHigh - uiLow) * (uiLevel & 0xFF)) >> 8);
+}
+
+
+/** ***************************************************************************
+ * @brief Select the correction curves
+ *
+ * The power LED output has to be refreshed afterwards (refreshDuty()), the
+ * RGB curve applies to colors written from now on.
+ *
+ * @param [in] ucPLED: power LED curve (GAMMA_PLED_LINEAR, GAMMA_PLED_CIE1931)
+ * @param [in] ucRGB: RGB curve (GAMMA_RGB_OFF, GAMMA_RGB_1_8, ...)
+ * @return 1: curves selected  0: unknown curve, nothing changed
+ *****************************************************************************/
+unsigned char Gamma_Select(unsigned char ucPLED, unsigned char ucRGB)
+{
+	if((ucPLED>=GAMMA_PLED_CURVES) || (ucRGB>=GAMMA_RGB_CURVES))
+	{
+		return 0;
+	}
+	ucGammaPLED = ucPLED;
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE) // 16bit pointer
+	{
+		pucGammaRGB = (ucRGB==GAMMA_RGB_OFF) ? 0 : aucGammaRGB[ucRGB-1];
+	}
+	return 1;
+}
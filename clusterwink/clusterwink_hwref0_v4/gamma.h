@@ -0,0 +1,68 @@
+/** ***************************************************************************
+ * @file gamma.h
+ * @brief Perceptual brightness correction of the power LED and the RGB strip
+ *
+ * - Power LED
+ * @n Brightness levels are perceived lightness (CIE 1931 L*). A table in the
+ * flash memory converts them to the linear intensity of the PWM output.
+ *
+ * - RGB strip
+ * @n Color values are corrected with a gamma table in the flash memory
+ * before they are written to the framebuffer.
+ *
+ * Both corrections can be selected or disabled at runtime. No division is
+ * needed on the output path. The RGB strip starts uncorrected: the legacy
+ * commands carry 7bit colors, a curve would darken their full scale 0x7F to
+ * 55. Clients with 8bit colors select a curve with 0x92.
+ *
+ * @author agent
+ * @date 16.10.2026
+ *****************************************************************************/
+
+
+#ifndef GAMMA_H_
+#define GAMMA_H_
+
+#include <avr/pgmspace.h>
+
+#define GAMMA_PLED_LINEAR		0		///< power LED: level = intensity
+#define GAMMA_PLED_CIE1931		1		///< power LED: level = CIE 1931 lightness
+#define GAMMA_PLED_CURVES		2		///< amount of power LED curves
+
+#define GAMMA_RGB_OFF			0		///< RGB strip: no correction
+#define GAMMA_RGB_1_8			1		///< RGB strip: gamma 1.8
+#define GAMMA_RGB_2_2			2		///< RGB strip: gamma 2.2
+#define GAMMA_RGB_2_8			3		///< RGB strip: gamma 2.8
+#define GAMMA_RGB_CURVES		4		///< amount of RGB curves
+
+#define GAMMA_PLED_DEFAULT		GAMMA_PLED_CIE1931	///< power LED curve after reset
+#define GAMMA_RGB_DEFAULT		GAMMA_RGB_OFF		///< RGB curve after reset (legacy 7bit colors unchanged)
+
+extern const unsigned int auiGammaCIE1931[257] PROGMEM;
+extern const unsigned char aucGammaRGB[GAMMA_RGB_CURVES-1][256] PROGMEM;
+extern const unsigned char* volatile pucGammaRGB;
+
+
+/** ***************************************************************************
+ * @brief Correct one color value of the RGB strip
+ *
+ * Inlined for the frame writing loops.
+ *
+ * @param [in] ucValue: color value
+ * @return corrected value for the strip
+ *****************************************************************************/
+static inline unsigned char Gamma_RGB(unsigned char ucValue)
+{
+	const unsigned char* pucTable = pucGammaRGB;
+
+	if(!pucTable)
+	{
+		return ucValue;
+	}
+	return pgm_read_byte(&pucTable[ucValue]);
+}
+
+unsigned int Gamma_PLED(unsigned int uiLevel);
+unsigned char Gamma_Select(unsigned char ucPLED, unsigned char ucRGB);
+
+#endif /* GAMMA_H_ */
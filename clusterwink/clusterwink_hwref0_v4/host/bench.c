@@ -0,0 +1,167 @@
+/** ***************************************************************************
+ * @file bench.c
+ * @brief Host benchmark suite, entry point
+ *
+ * Usage (from the host directory):
+ * @n make bench
+ *
+ * The costs are measured without INSTRUMENTATION, the instrumented build
+ * only checks the instrumentation registers.
+ *
+ * Every suite checks the output of the simulated peripherals before it
+ * reports any numbers. A failing check terminates with a non-zero exit code.
+ *
+ * @author agent
+ * @date 16.10.2026
+ *****************************************************************************/
+
+
+#include <stdio.h>
+#include <time.h>
+#include "bench.h"
+
+
+static uint64_t ullOverhead = 0;	///< cost of an empty measurement (subtracted)
+static uint64_t ullIrqOff = 0;		///< cycle count when the interrupts were disabled
+volatile uint8_t ucBenchIrqTrace = 0;	///< 1: report interrupt flag transitions (BENCH_IRQ_TRACE)
+BENCH_STAT* psBenchIrq = 0;			///< statistics of the interrupt disabled time
+
+
+/** ***************************************************************************
+ * @brief Add one measurement to the statistics
+ *
+ * @param [in,out] psStat: statistics to update
+ * @param [in] ullStart: cycle count before the measured section
+ * @param [in] ullEnd: cycle count after the measured section
+ * @return no return value
+ *****************************************************************************/
+void Bench_Add(BENCH_STAT* psStat, uint64_t ullStart, uint64_t ullEnd)
+{
+	uint64_t ullCycles = ullEnd - ullStart;
+
+	ullCycles = (ullCycles > ullOverhead) ? (ullCycles - ullOverhead) : 0;
+	psStat->ulCalls++;
+	psStat->ullTotal += ullCycles;
+	if(ullCycles > psStat->ullMax)
+	{
+		psStat->ullMax = ullCycles;
+	}
+}
+
+
+/** ***************************************************************************
+ * @brief Print the average and worst case of the statistics
+ *
+ * @param [in] psStat: statistics to print
+ * @return no return value
+ *****************************************************************************/
+void Bench_Print(const BENCH_STAT* psStat)
+{
+	double dAverage = 0;
+
+	if(psStat->ulCalls > 0)
+	{
+		dAverage = (double)psStat->ullTotal / (double)psStat->ulCalls;
+	}
+	printf("  %-44s avg %8.1f  max %8llu cycles  (%lu calls)\n",
+		psStat->pcName, dAverage, (unsigned long long)psStat->ullMax, psStat->ulCalls);
+}
+
+
+/** ***************************************************************************
+ * @brief Global interrupts get disabled (BENCH_IRQ_TRACE, see util/atomic.h)
+ *
+ * @param [void] no input
+ * @return no return value
+ *****************************************************************************/
+void Bench_IrqOff(void)
+{
+	ullIrqOff = Bench_Cycles();
+}
+
+
+/** ***************************************************************************
+ * @brief Global interrupts get enabled again (BENCH_IRQ_TRACE)
+ *
+ * The time since Bench_IrqOff() is added to psBenchIrq.
+ *
+ * @param [void] no input
+ * @return no return value
+ *****************************************************************************/
+void Bench_IrqOn(void)
+{
+	uint64_t ullEnd = Bench_Cycles();
+
+	if(psBenchIrq)
+	{
+		Bench_Add(psBenchIrq, ullIrqOff, ullEnd);
+	}
+}
+
+
+/** ***************************************************************************
+ * @brief Wall clock for throughput measurements
+ *
+ * @param [void] no input
+ * @return monotonic time in seconds
+ *****************************************************************************/
+double Bench_Seconds(void)
+{
+	struct timespec sTime;
+
+	clock_gettime(CLOCK_MONOTONIC, &sTime);
+	return (double)sTime.tv_sec + ((double)sTime.tv_nsec * 1e-9);
+}
+
+
+/** ***************************************************************************
+ * @brief Determine the cost of an empty measurement
+ *
+ * @param [void] no input
+ * @return no return value
+ *****************************************************************************/
+static void Bench_Calibrate(void)
+{
+	unsigned long i;
+	uint64_t ullStart;
+	uint64_t ullCycles;
+	uint64_t ullMin = (uint64_t)-1;
+
+	for(i=0;i<100000;i++)
+	{
+		ullStart = Bench_Cycles();
+		ullCycles = Bench_Cycles() - ullStart;
+		if(ullCycles < ullMin)
+		{
+			ullMin = ullCycles;
+		}
+	}
+	ullOverhead = ullMin;
+}
+
+
+/** ***************************************************************************
+ * @brief Run all benchmark suites
+ *
+ * The instrumented build (clusterwink_bench_instr) only runs the
+ * instrumentation check of the firmware suite.
+ *
+ * @param [void] no input
+ * @return 0 if all suites passed their checks
+ *****************************************************************************/
+int main(void)
+{
+	int iResult = 0;
+
+	Bench_Calibrate();
+	printf("clusterwink host benchmark (measurement overhead %llu cycles subtracted)\n\n",
+		(unsigned long long)ullOverhead);
+
+	iResult |= Bench_Firmware();
+#ifndef INSTRUMENTATION
+	iResult |= Bench_RGBooster();
+	iResult |= Bench_RingBuffer();
+#endif
+
+	return iResult;
+}
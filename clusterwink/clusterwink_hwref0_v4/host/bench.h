@@ -0,0 +1,67 @@
+/** ***************************************************************************
+ * @file bench.h
+ * @brief Cycle counting helpers of the host benchmark suite
+ *
+ * Costs are measured with the time stamp counter of the host CPU (or the
+ * monotonic clock in ns on other architectures). The absolute values do not
+ * match the ATmega328, but relative changes between two firmware versions
+ * show up reliably.
+ *
+ * @author agent
+ * @date 16.10.2026
+ *****************************************************************************/
+
+
+#ifndef BENCH_H_
+#define BENCH_H_
+
+#include <stdint.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#else
+#include <time.h>
+#endif
+
+
+/** Statistics of one measured code section */
+typedef struct
+{
+	const char* pcName;			///< name printed in the report
+	unsigned long ulCalls;		///< amount of measurements
+	uint64_t ullTotal;			///< sum of all measurements [cycles]
+	uint64_t ullMax;			///< worst case measurement [cycles]
+} BENCH_STAT;
+
+
+/** ***************************************************************************
+ * @brief Read the host cycle counter
+ *
+ * @param [void] no input
+ * @return current cycle count
+ *****************************************************************************/
+static inline uint64_t Bench_Cycles(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+	return __rdtsc();
+#else
+	struct timespec sTime;
+	clock_gettime(CLOCK_MONOTONIC, &sTime);
+	return ((uint64_t)sTime.tv_sec * 1000000000ull) + (uint64_t)sTime.tv_nsec;
+#endif
+}
+
+extern volatile uint8_t ucBenchIrqTrace;
+extern BENCH_STAT* psBenchIrq;
+
+void Bench_Add(BENCH_STAT* psStat, uint64_t ullStart, uint64_t ullEnd);
+void Bench_Print(const BENCH_STAT* psStat);
+double Bench_Seconds(void);
+void Bench_IrqOff(void);
+void Bench_IrqOn(void);
+
+// benchmark suites
+int Bench_Firmware(void);
+int Bench_RGBooster(void);
+int Bench_RingBuffer(void);
+
+#endif /* BENCH_H_ */
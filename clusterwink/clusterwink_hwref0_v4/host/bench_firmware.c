@@ -0,0 +1,3211 @@
+/** ***************************************************************************
+ * @file bench_firmware.c
+ * @brief Benchmark of the firmware ISRs and the main loop command execution
+ *
+ * - per ISR cost
+ * @n ISR(SPI_STC_vect) for command and data bytes, ISR(INT1_vect) per
+ * RGBooster handshake and processCommands() per executed command.
+ *
+ * - command burst
+ * @n processCommands() per command when the command queue is full.
+ *
+ * - end-to-end throughput
+ * @n SPI command -> main loop -> complete strip transfer through INT1, for
+ * single color commands and full frame uploads (legacy and framed protocol).
+ *
+ * - framed protocol
+ * @n Frames with a corrupted checksum must be counted and dropped.
+ *
+ * - streamed frame uploads
+ * @n ISR(SPI_STC_vect) per payload byte written into the back frame. Uploads
+ * while a latched frame waits for its swap or while commands are queued must
+ * be rejected and counted, an aborted upload must not be latched.
+ *
+ * - temperature measurement
+ * @n ISR(ADC_vect) per conversion and the oversampled result of noisy
+ * conversions. The former polled 8bit measurement kept the main loop waiting
+ * for 13 ADC clocks (prescaler 128) = 1664 cycles per pass.
+ *
+ * - thermal derating
+ * @n Temperature register, status bits and OCR1A below, inside and above the
+ * derating band, and after raising the limit with [0x89, TT].
+ *
+ * - scheduler
+ * @n Latency from the last SPI byte of a command to the start of the strip
+ * transfer in 1ms ticks, and the cost of Scheduler_Run() with and without
+ * due tasks. The former main loop executed the commands after
+ * wait_1ms(1000), i.e. after up to 1000ms.
+ *
+ * - idle sleep
+ * @n The main loop sleeps between the interrupts. Commands still have to be
+ * executed with the next tick, the awake time per tick is compared with the
+ * 20000 cycles of a millisecond (host cycles, the AVR needs more).
+ *
+ * - sunrise
+ * @n A sunrise program uploaded with one frame runs on the effects task:
+ * OCR1A and the strip have to rise monotonically and end at the programmed
+ * values. The SPI bytes are compared with one duty and one color command per
+ * step sent by the RPi.
+ *
+ * - brightness correction
+ * @n setDuty() with the CIE 1931 table compared with the former Map() (32bit
+ * multiplication and division), monotonic curves, and the RGB gamma table
+ * selected with the framed 0x92 on the strip.
+ *
+ * - high resolution dimming
+ * @n The average dutycycle over a dithering cycle has to match every 16bit
+ * intensity. Distinct dutycycles at the low end (up to 10%) compared with
+ * the former 9bit PWM, cost of ISR(TIMER1_OVF_vect) and the framed 16bit
+ * level command 0x93.
+ *
+ * - backpressure
+ * @n STATUS_BUSY and STATUS_DROPPED around a full command queue. A burst of
+ * single LED commands faster than the main loop loses commands when it is
+ * sent blindly and none when the RPi waits while STATUS_BUSY is set.
+ *
+ * - strip length
+ * @n Runtime length set with the framed 0x94 in both storage modes, the
+ * single buffer blocking writes during a transfer, the framed 0x95 on a long
+ * strip and the length kept in the EEPROM over a reboot.
+ *
+ * - palette formats
+ * @n 4bit and 8bit palette indices expanded by ISR(INT1_vect), palette and
+ * indices uploaded separately (0x96, 0x87, 0x97). The SPI bytes to recolour
+ * the strip with one palette entry are compared with a full GRB upload.
+ *
+ * - run length encoding
+ * @n Solid, two-tone and gradient scenes of BENCH_RLE_LEDS LEDs uploaded
+ * with the legacy 0x87, framed 0x95 ranges and framed 0x98 runs: SPI bytes
+ * on the wire and host cycles to receive and decode a scene.
+ *
+ * - effects
+ * @n Rainbow, chase, breathe and twinkle rendered by the effects task: one
+ * frame per TASK_PERIOD_EFFECTS without SPI traffic, the pattern of every
+ * effect, stopping with 0x9A and with a color command, host cycles of a step
+ * with rendering and the SPI bytes compared with streamed frames.
+ *
+ * - color conversions
+ * @n Color_HSV() against a floating point reference, Color_Degree(),
+ * Color_Kelvin() at the table limits and its monotonic red and blue
+ * channels, the framed 0x9B and 0x9C on the strip and the host cycles per
+ * conversion.
+ *
+ * - scenes
+ * @n A scene saved with 0x9D (runs, power LED, effect) recalled with 0x9E in
+ * both GRB and palette formats, restored after a reboot, scenes that do not
+ * fit and empty slots reported with STATUS_DROPPED and the scene restored at
+ * boot over many recalls (wear-levelled ring). The restore latency after
+ * the reset is compared with the former 3s boot test sequence.
+ *
+ * - instrumentation
+ * @n Queue high-water mark, dropped commands, discarded bytes and sent frames
+ * read with [0x8C, RR, 0x00]. Only this check is built with INSTRUMENTATION
+ * (clusterwink_bench_instr), all costs above are measured without the
+ * timestamps.
+ *
+ * @author agent
+ * @date 16.10.2026
+ *****************************************************************************/
+
+
+#include <stdio.h>
+#include <avr/io.h>
+#include <avr/eeprom.h>
+#include "main.h"
+#include "utils.h"
+#include "cmdqueue.h"
+#include "crc8.h"
+#include "scheduler.h"
+#include "sunrise.h"
+#include "gamma.h"
+#include "effects.h"
+#include "color.h"
+#include "scene.h"
+#include "instrument.h"
+#include "sim.h"
+#include "bench.h"
+
+
+#define BENCH_COMMANDS		20000	///< amount of commands per measurement
+#define BENCH_LOOP_BYTES	40		///< SPI bytes per main loop pass (backpressure)
+#define BENCH_SLEEP_MS		10000	///< ticks of the main loop with idle sleep
+#define BENCH_RLE_LEDS		150		///< strip length of the run length encoding scenes
+#define BENCH_RLE_FRAMES	2000	///< amount of frames per scene and upload method
+#define BENCH_STREAM_SIZE	2048	///< SPI bytes of a scene upload
+#define BENCH_STREAM_PARTS	64		///< commands of a scene upload
+#define BENCH_EFFECT_LEDS	150		///< strip length of the effects
+#define BENCH_EFFECT_TICKS	1000	///< ticks per effect
+#define BENCH_LAYOUT_PASSES	3		///< passes of processCommands() to store the strip layout (one EEPROM byte each)
+
+
+/** SPI bytes of a scene upload, the main loop runs after every command */
+typedef struct
+{
+	unsigned char aucData[BENCH_STREAM_SIZE];	///< commands
+	unsigned int auiEnd[BENCH_STREAM_PARTS];	///< end of each command in aucData
+	unsigned int uiParts;						///< amount of commands
+} BENCH_STREAM;
+
+
+static void Bench_Gradient(unsigned char* pucFrame, unsigned long ulSeed);
+
+
+/** ***************************************************************************
+ * @brief Boot the firmware on the simulated peripherals
+ *
+ * The RGB gamma correction is disabled, the checks compare the strip with
+ * the uploaded colors.
+ *
+ * @param [void] no input
+ * @return no return value
+ *****************************************************************************/
+static void Bench_Boot(void)
+{
+	Sim_Reset();
+	Gamma_Select(GAMMA_PLED_DEFAULT, GAMMA_RGB_OFF);
+	systemInit();
+	Sim_RunRGBooster();
+	Sim_ClearStrip();
+}
+
+
+/** ***************************************************************************
+ * @brief Check that the sent data is one frame of a single color
+ *
+ * @param [in] uiLEDs: expected strip length
+ * @param [in] ucRed: expected red value
+ * @param [in] ucGreen: expected green value
+ * @param [in] ucBlue: expected blue value
+ * @return 0 if the frame is correct
+ *****************************************************************************/
+static int Bench_CheckStrip(unsigned int uiLEDs, unsigned char ucRed, unsigned char ucGreen, unsigned char ucBlue)
+{
+	unsigned int i;
+
+	if(sSim.uiStripCount != (uiLEDs*3))
+	{
+		printf("  FAIL: %u bytes sent to the RGBooster, expected %u\n", sSim.uiStripCount, uiLEDs*3);
+		return 1;
+	}
+	for(i=0;i<uiLEDs;i++)
+	{
+		if((sSim.aucStrip[(i*3)+0] != ucGreen) || (sSim.aucStrip[(i*3)+1] != ucRed) || (sSim.aucStrip[(i*3)+2] != ucBlue))
+		{
+			printf("  FAIL: wrong color on LED %u\n", i);
+			return 1;
+		}
+	}
+	return 0;
+}
+
+
+/** ***************************************************************************
+ * @brief Check that the last frame shows a single color on the whole strip
+ *
+ * @param [in] ucRed: expected red value
+ * @param [in] ucGreen: expected green value
+ * @param [in] ucBlue: expected blue value
+ * @return 0 if the frame is correct
+ *****************************************************************************/
+static int Bench_CheckFrame(unsigned char ucRed, unsigned char ucGreen, unsigned char ucBlue)
+{
+	return Bench_CheckStrip(LED_COUNT_DEFAULT, ucRed, ucGreen, ucBlue);
+}
+
+
+/** ***************************************************************************
+ * @brief Measure the ISRs and the command execution separately
+ *
+ * @param [void] no input
+ * @return 0 if all frames were correct
+ *****************************************************************************/
+static int Bench_ISRCost(void)
+{
+	BENCH_STAT sSPICommand = {"ISR(SPI_STC_vect) command byte 0x84", 0, 0, 0};
+	BENCH_STAT sSPIData = {"ISR(SPI_STC_vect) data byte", 0, 0, 0};
+	BENCH_STAT sSPIDuty = {"ISR(SPI_STC_vect) [0x82, XX] set duty", 0, 0, 0};
+	BENCH_STAT sINT1 = {"ISR(INT1_vect) per handshake", 0, 0, 0};
+	BENCH_STAT sProcess = {"processCommands() 0x84", 0, 0, 0};
+	unsigned long n;
+	unsigned int i;
+	unsigned char aucCommand[4];
+	uint64_t ullStart;
+
+	Bench_Boot();
+
+	for(n=0;n<BENCH_COMMANDS;n++)
+	{
+		aucCommand[0] = 0x84;
+		aucCommand[1] = (unsigned char)(n & 0x7F);
+		aucCommand[2] = (unsigned char)((n >> 3) & 0x7F);
+		aucCommand[3] = (unsigned char)((n >> 6) & 0x7F);
+
+		for(i=0;i<4;i++)
+		{
+			SPDR = aucCommand[i];
+			ullStart = Bench_Cycles();
+			SPI_STC_vect();
+			Bench_Add((i == 0) ? &sSPICommand : &sSPIData, ullStart, Bench_Cycles());
+		}
+
+		ullStart = Bench_Cycles();
+		processCommands();
+		Bench_Add(&sProcess, ullStart, Bench_Cycles());
+
+		while(sSim.ucHandshakePending)
+		{
+			sSim.ucHandshakePending = 0;
+			ullStart = Bench_Cycles();
+			INT1_vect();
+			Bench_Add(&sINT1, ullStart, Bench_Cycles());
+		}
+
+		if(Bench_CheckFrame(aucCommand[1], aucCommand[2], aucCommand[3]))
+		{
+			return 1;
+		}
+		Sim_ClearStrip();
+
+		SPDR = 0x82;
+		SPI_STC_vect();
+		SPDR = (unsigned char)(n % 101);
+		ullStart = Bench_Cycles();
+		SPI_STC_vect();
+		Bench_Add(&sSPIDuty, ullStart, Bench_Cycles());
+	}
+
+	Bench_Print(&sSPICommand);
+	Bench_Print(&sSPIData);
+	Bench_Print(&sSPIDuty);
+	Bench_Print(&sProcess);
+	Bench_Print(&sINT1);
+	return 0;
+}
+
+
+/** ***************************************************************************
+ * @brief Measure the execution of a full command queue
+ *
+ * CMD_QUEUE_SIZE single LED commands [0x85, II, RR, GG, BB] are received
+ * before the main loop runs, which executes all of them in one call. The
+ * last burst is latched and checked.
+ *
+ * @param [void] no input
+ * @return 0 if the frame was correct
+ *****************************************************************************/
+static int Bench_CommandBurst(void)
+{
+	BENCH_STAT sBurst = {"processCommands() full queue of 0x85", 0, 0, 0};
+	unsigned long n;
+	unsigned int i;
+	unsigned char aucCommand[5];
+	unsigned char ucLatch = 0x88;
+	uint64_t ullStart;
+
+	Bench_Boot();
+
+	for(n=0;n<BENCH_COMMANDS;n++)
+	{
+		for(i=0;i<CMD_QUEUE_SIZE;i++)
+		{
+			aucCommand[0] = 0x85;
+			aucCommand[1] = (unsigned char)i;
+			aucCommand[2] = (unsigned char)(n & 0x7F);
+			aucCommand[3] = (unsigned char)(i + 1);
+			aucCommand[4] = (unsigned char)(i + 2);
+			Sim_SPISend(aucCommand, 5);
+		}
+		ullStart = Bench_Cycles();
+		processCommands();
+		Bench_Add(&sBurst, ullStart, Bench_Cycles());
+	}
+
+	Sim_SPISend(&ucLatch, 1);
+	processCommands();
+	Sim_RunRGBooster();
+	for(i=0;i<CMD_QUEUE_SIZE;i++)
+	{
+		if((sSim.aucStrip[(i*3)+0] != (i + 1)) || (sSim.aucStrip[(i*3)+1] != ((n - 1) & 0x7F)) || (sSim.aucStrip[(i*3)+2] != (i + 2)))
+		{
+			printf("  FAIL: wrong color on LED %u\n", i);
+			return 1;
+		}
+	}
+
+	Bench_Print(&sBurst);
+	return 0;
+}
+
+
+/** ***************************************************************************
+ * @brief Measure the end-to-end command throughput
+ *
+ * Every command is received through SPI, executed by the main loop and the
+ * resulting frame is completely sent to the RGBooster.
+ *
+ * @param [void] no input
+ * @return 0 if all frames were correct
+ *****************************************************************************/
+static int Bench_Throughput(void)
+{
+	unsigned long n;
+	unsigned char aucCommand[4];
+	double dStart;
+	double dSeconds;
+
+	Bench_Boot();
+
+	dStart = Bench_Seconds();
+	for(n=0;n<BENCH_COMMANDS;n++)
+	{
+		aucCommand[0] = 0x84;
+		aucCommand[1] = (unsigned char)(n & 0x7F);
+		aucCommand[2] = 0x10;
+		aucCommand[3] = 0x20;
+		Sim_SPISend(aucCommand, 4);
+		processCommands();
+		Sim_RunRGBooster();
+		if(Bench_CheckFrame(aucCommand[1], aucCommand[2], aucCommand[3]))
+		{
+			return 1;
+		}
+		Sim_ClearStrip();
+	}
+	dSeconds = Bench_Seconds() - dStart;
+
+	printf("  %-44s %10.0f commands/s (%.1f ns/command)\n", "0x84 SPI -> main loop -> strip",
+		(double)BENCH_COMMANDS / dSeconds, (dSeconds * 1e9) / (double)BENCH_COMMANDS);
+	return 0;
+}
+
+
+/** ***************************************************************************
+ * @brief Measure the throughput of full frame uploads
+ *
+ * Every frame is a gradient uploaded with [0x87, ...] followed by the latch
+ * command 0x88.
+ *
+ * @param [void] no input
+ * @return 0 if all frames were correct
+ *****************************************************************************/
+static int Bench_FrameUpload(void)
+{
+	unsigned long n;
+	unsigned int i;
+	unsigned char aucFrame[1+(LED_COUNT_DEFAULT*3)];
+	unsigned char ucLatch = 0x88;
+	double dStart;
+	double dSeconds;
+
+	Bench_Boot();
+
+	dStart = Bench_Seconds();
+	for(n=0;n<BENCH_COMMANDS;n++)
+	{
+		Bench_Gradient(aucFrame, n);
+		Sim_SPISend(aucFrame, sizeof(aucFrame));
+		Sim_SPISend(&ucLatch, 1);
+		processCommands();
+		processCommands();
+		Sim_RunRGBooster();
+
+		if(sSim.uiStripCount != (LED_COUNT_DEFAULT*3))
+		{
+			printf("  FAIL: %u bytes sent to the RGBooster, expected %u\n", sSim.uiStripCount, LED_COUNT_DEFAULT*3);
+			return 1;
+		}
+		for(i=0;i<LED_COUNT_DEFAULT;i++)
+		{
+			if((sSim.aucStrip[(i*3)+0] != aucFrame[2+(i*3)]) || (sSim.aucStrip[(i*3)+1] != aucFrame[1+(i*3)]) || (sSim.aucStrip[(i*3)+2] != aucFrame[3+(i*3)]))
+			{
+				printf("  FAIL: wrong color on LED %u\n", i);
+				return 1;
+			}
+		}
+		Sim_ClearStrip();
+	}
+	dSeconds = Bench_Seconds() - dStart;
+
+	printf("  %-44s %10.0f frames/s (%.1f ns/frame)\n", "0x87 frame + 0x88 latch -> strip",
+		(double)BENCH_COMMANDS / dSeconds, (dSeconds * 1e9) / (double)BENCH_COMMANDS);
+	return 0;
+}
+
+
+/** ***************************************************************************
+ * @brief Fill a frame upload command with a gradient
+ *
+ * @param [out] pucFrame: [0x87, RR, GG, BB, ...] command
+ * @param [in] ulSeed: start value of the gradient
+ * @return no return value
+ *****************************************************************************/
+static void Bench_Gradient(unsigned char* pucFrame, unsigned long ulSeed)
+{
+	unsigned int i;
+
+	pucFrame[0] = 0x87;
+	for(i=0;i<LED_COUNT_DEFAULT;i++)
+	{
+		pucFrame[1+(i*3)] = (unsigned char)((ulSeed + i) & 0x7F);			// red
+		pucFrame[2+(i*3)] = (unsigned char)((ulSeed + (i*2)) & 0x7F);		// green
+		pucFrame[3+(i*3)] = (unsigned char)((ulSeed + (i*3)) & 0x7F);		// blue
+	}
+}
+
+
+/** ***************************************************************************
+ * @brief Build a frame of the framed protocol
+ *
+ * @param [out] pucFrame: [0x8A, OPCODE, LENGTH, PAYLOAD..., CRC]
+ * @param [in] ucOpcode: opcode
+ * @param [in] pucPayload: payload
+ * @param [in] ucLength: amount of payload bytes
+ * @return amount of bytes of the frame
+ *****************************************************************************/
+static unsigned int Bench_BuildFrame(unsigned char* pucFrame, unsigned char ucOpcode, const unsigned char* pucPayload, unsigned char ucLength)
+{
+	unsigned int i;
+
+	pucFrame[0] = 0x8A;
+	pucFrame[1] = ucOpcode;
+	pucFrame[2] = ucLength;
+	for(i=0;i<ucLength;i++)
+	{
+		pucFrame[3+i] = pucPayload[i];
+	}
+	pucFrame[3+ucLength] = CRC8_Calculate(&pucFrame[1], (unsigned char)(ucLength + 2));
+	return 4 + ucLength;
+}
+
+
+/** ***************************************************************************
+ * @brief OCR1A value of an intensity without derating and dithering
+ *
+ * @param [in] uiIntensity: linear intensity [0-0xFFFF]
+ * @return OCR1A value [0-PWM_TOP]
+ *****************************************************************************/
+static unsigned int Bench_PWMBase(unsigned int uiIntensity)
+{
+	uiIntensity >>= PWM_DITHER_BITS;
+	return (uiIntensity > PWM_TOP) ? PWM_TOP : uiIntensity;
+}
+
+
+/** ***************************************************************************
+ * @brief Effective dutycycle over one dithering cycle
+ *
+ * The first period after a change still has the old OCR1A value (the
+ * overflow ISR programs the following period), it is not measured.
+ *
+ * @param [void] no input
+ * @return sum of OCR1A over 2^PWM_DITHER_BITS PWM periods [1/(PWM_TOP+1)/64]
+ *****************************************************************************/
+static unsigned long Bench_PWMAverage(void)
+{
+	Sim_RunPWM(1);
+	sSim.ulPWMSum = 0;
+	Sim_RunPWM(1<<PWM_DITHER_BITS);
+	return sSim.ulPWMSum;
+}
+
+
+/** ***************************************************************************
+ * @brief Measure the throughput of framed full frame uploads
+ *
+ * Every frame contains 8bit colors (bit 7 set) and is latched with a framed
+ * 0x88. Every 16th upload has a corrupted checksum and must neither change
+ * the strip nor go unnoticed in the rejected frames register (0x8B).
+ *
+ * @param [void] no input
+ * @return 0 if all frames were correct
+ *****************************************************************************/
+static int Bench_FramedUpload(void)
+{
+	BENCH_STAT sFramedByte = {"ISR(SPI_STC_vect) framed payload byte", 0, 0, 0};
+	unsigned long n;
+	unsigned int i;
+	unsigned int uiLength;
+	unsigned int uiLatchLength;
+	unsigned char aucColors[LED_COUNT_DEFAULT*3];
+	unsigned char aucLast[LED_COUNT_DEFAULT*3];
+	unsigned char aucFrame[4+(LED_COUNT_DEFAULT*3)];
+	unsigned char aucLatch[4];
+	unsigned long ulCorrupted = 0;
+	uint64_t ullStart;
+	double dStart;
+	double dSeconds;
+
+	Bench_Boot();
+	uiLatchLength = Bench_BuildFrame(aucLatch, 0x88, 0, 0);
+
+	dStart = Bench_Seconds();
+	for(n=0;n<BENCH_COMMANDS;n++)
+	{
+		for(i=0;i<(LED_COUNT_DEFAULT*3);i++)
+		{
+			aucColors[i] = (unsigned char)(0x80 + n + (i*5));
+		}
+		uiLength = Bench_BuildFrame(aucFrame, 0x87, aucColors, LED_COUNT_DEFAULT*3);
+		if((n & 0x0F)==0x0F)
+		{
+			aucFrame[uiLength-1] ^= 0x01; // corrupted checksum
+			ulCorrupted++;
+		}
+		else
+		{
+			for(i=0;i<(LED_COUNT_DEFAULT*3);i++)
+			{
+				aucLast[i] = aucColors[i];
+			}
+		}
+		Sim_SPISend(aucFrame, uiLength);
+		Sim_SPISend(aucLatch, uiLatchLength);
+		processCommands();
+		processCommands();
+		Sim_RunRGBooster();
+
+		if(sSim.uiStripCount != (LED_COUNT_DEFAULT*3))
+		{
+			printf("  FAIL: %u bytes sent to the RGBooster, expected %u\n", sSim.uiStripCount, LED_COUNT_DEFAULT*3);
+			return 1;
+		}
+		for(i=0;i<LED_COUNT_DEFAULT;i++)
+		{
+			if((sSim.aucStrip[(i*3)+0] != aucLast[(i*3)+1]) || (sSim.aucStrip[(i*3)+1] != aucLast[(i*3)+0]) || (sSim.aucStrip[(i*3)+2] != aucLast[(i*3)+2]))
+			{
+				printf("  FAIL: wrong color on LED %u after framed upload %lu\n", i, n);
+				return 1;
+			}
+		}
+		Sim_ClearStrip();
+	}
+	dSeconds = Bench_Seconds() - dStart;
+
+	Sim_SPITransfer(0x8B);
+	if(Sim_SPITransfer(0x00) != ((ulCorrupted>0xFF) ? 0xFF : ulCorrupted))
+	{
+		printf("  FAIL: rejected frames register does not match %lu corrupted frames\n", ulCorrupted);
+		return 1;
+	}
+
+	for(n=0;n<BENCH_COMMANDS;n++) // cost of a payload byte
+	{
+		uiLength = Bench_BuildFrame(aucFrame, 0x87, aucColors, LED_COUNT_DEFAULT*3);
+		for(i=0;i<uiLength;i++)
+		{
+			SPDR = aucFrame[i];
+			ullStart = Bench_Cycles();
+			SPI_STC_vect();
+			if((i>=3) && (i<(uiLength-1)))
+			{
+				Bench_Add(&sFramedByte, ullStart, Bench_Cycles());
+			}
+		}
+		processCommands();
+	}
+
+	Bench_Print(&sFramedByte);
+	printf("  %-44s %10.0f frames/s (%.1f ns/frame)\n", "framed 0x87 + 0x88 -> strip",
+		(double)BENCH_COMMANDS / dSeconds, (dSeconds * 1e9) / (double)BENCH_COMMANDS);
+	printf("  %-44s %lu corrupted frames rejected\n", "framed checksum", ulCorrupted);
+	return 0;
+}
+
+
+/** ***************************************************************************
+ * @brief Upload frames while the previous frame is still being sent
+ *
+ * Every frame is uploaded and latched when half of the previous frame has
+ * left the RGBooster. The strip must show every frame completely and in order
+ * (no torn frames).
+ *
+ * @param [void] no input
+ * @return 0 if all frames were correct
+ *****************************************************************************/
+static int Bench_FrameOverlap(void)
+{
+	unsigned long n;
+	unsigned int i;
+	unsigned int uiOffset;
+	unsigned char aucFrame[1+(LED_COUNT_DEFAULT*3)];
+	unsigned char ucLatch = 0x88;
+	const unsigned long ulFrames = SIM_STRIP_SIZE/(LED_COUNT_DEFAULT*3);
+
+	Bench_Boot();
+
+	for(n=0;n<ulFrames;n++)
+	{
+		for(i=0;i<((LED_COUNT_DEFAULT*3)/2);i++) // previous frame half sent
+		{
+			Sim_StepRGBooster();
+		}
+		Bench_Gradient(aucFrame, n);
+		Sim_SPISend(aucFrame, sizeof(aucFrame));
+		Sim_SPISend(&ucLatch, 1);
+		while(sSim.uiStripCount < (n*LED_COUNT_DEFAULT*3)) // the main loop keeps running while the strip is busy
+		{
+			processCommands();
+			Sim_StepRGBooster();
+		}
+		processCommands();
+		processCommands();
+	}
+	Sim_RunRGBooster();
+
+	if(sSim.uiStripCount != (ulFrames*LED_COUNT_DEFAULT*3))
+	{
+		printf("  FAIL: %u bytes sent to the RGBooster, expected %lu\n", sSim.uiStripCount, ulFrames*LED_COUNT_DEFAULT*3);
+		return 1;
+	}
+	for(n=0;n<ulFrames;n++)
+	{
+		Bench_Gradient(aucFrame, n);
+		for(i=0;i<LED_COUNT_DEFAULT;i++)
+		{
+			uiOffset = (n*LED_COUNT_DEFAULT*3) + (i*3);
+			if((sSim.aucStrip[uiOffset+0] != aucFrame[2+(i*3)]) || (sSim.aucStrip[uiOffset+1] != aucFrame[1+(i*3)]) || (sSim.aucStrip[uiOffset+2] != aucFrame[3+(i*3)]))
+			{
+				printf("  FAIL: frame %lu torn at LED %u\n", n, i);
+				return 1;
+			}
+		}
+	}
+
+	printf("  %-44s %lu frames, none torn\n", "frames latched during transfer", ulFrames);
+	return 0;
+}
+
+
+/** ***************************************************************************
+ * @brief Check a gradient frame on the strip
+ *
+ * @param [in] uiFrame: position of the frame in the sent data
+ * @param [in] ulSeed: start value of the gradient (see Bench_Gradient())
+ * @return 0 if the frame is correct
+ *****************************************************************************/
+static int Bench_CheckGradient(unsigned int uiFrame, unsigned long ulSeed)
+{
+	unsigned int i;
+	unsigned int uiOffset;
+	unsigned char aucFrame[1+(LED_COUNT_DEFAULT*3)];
+
+	Bench_Gradient(aucFrame, ulSeed);
+	for(i=0;i<LED_COUNT_DEFAULT;i++)
+	{
+		uiOffset = (uiFrame*LED_COUNT_DEFAULT*3) + (i*3);
+		if((sSim.aucStrip[uiOffset+0] != aucFrame[2+(i*3)]) || (sSim.aucStrip[uiOffset+1] != aucFrame[1+(i*3)]) || (sSim.aucStrip[uiOffset+2] != aucFrame[3+(i*3)]))
+		{
+			printf("  FAIL: frame %u (gradient %lu) wrong at LED %u\n", uiFrame, ulSeed, i);
+			return 1;
+		}
+	}
+	return 0;
+}
+
+
+/** ***************************************************************************
+ * @brief Upload frames while the back frame is busy
+ *
+ * Frame uploads are streamed by ISR(SPI_STC_vect) into the back frame. An
+ * upload received while a latched frame waits for its swap or while queued
+ * commands still have to write the back frame must be rejected, counted in
+ * the rejected frames register (0x8B) and must not change the strip. An
+ * upload interrupted by a command byte must not be latched.
+ * The ISR cost per streamed payload byte is measured as well (the former
+ * upload copied every byte into the command queue and again into the back
+ * frame in processCommands()).
+ *
+ * @param [void] no input
+ * @return 0 if all checks passed
+ *****************************************************************************/
+static int Bench_BusyUpload(void)
+{
+	BENCH_STAT sUploadByte = {"ISR(SPI_STC_vect) 0x87 payload byte", 0, 0, 0};
+	unsigned long n;
+	unsigned int i;
+	unsigned char aucFrame[1+(LED_COUNT_DEFAULT*3)];
+	unsigned char ucLatch = 0x88;
+	unsigned char ucRejected;
+	uint64_t ullStart;
+
+	Bench_Boot();
+	Sim_SPITransfer(0x8B);
+	ucRejected = Sim_SPITransfer(0x00);
+
+	Bench_Gradient(aucFrame, 0); // frame 0 sent
+	Sim_SPISend(aucFrame, sizeof(aucFrame));
+	Sim_SPISend(&ucLatch, 1);
+	processCommands();
+	Sim_StepRGBooster();
+	Bench_Gradient(aucFrame, 1); // frame 1 waits for its swap
+	Sim_SPISend(aucFrame, sizeof(aucFrame));
+	Sim_SPISend(&ucLatch, 1);
+	processCommands();
+	Bench_Gradient(aucFrame, 2); // rejected: swap pending
+	Sim_SPISend(aucFrame, sizeof(aucFrame));
+	Sim_SPISend(&ucLatch, 1);
+	Sim_RunRGBooster();
+	processCommands(); // latches frame 1 again
+	Sim_RunRGBooster();
+	Bench_Gradient(aucFrame, 3); // rejected: latch still queued
+	Sim_SPISend(&ucLatch, 1);
+	Sim_SPISend(aucFrame, sizeof(aucFrame));
+	processCommands();
+	Sim_RunRGBooster();
+	Bench_Gradient(aucFrame, 4); // aborted by a command byte
+	Sim_SPISend(aucFrame, sizeof(aucFrame)/2);
+	Sim_SPISend(&ucLatch, 1);
+	processCommands();
+	Sim_RunRGBooster();
+
+	if(sSim.uiStripCount != (5*LED_COUNT_DEFAULT*3))
+	{
+		printf("  FAIL: %u bytes sent to the RGBooster, expected %u\n", sSim.uiStripCount, 5*LED_COUNT_DEFAULT*3);
+		return 1;
+	}
+	if(Bench_CheckGradient(0, 0) || Bench_CheckGradient(1, 1) || Bench_CheckGradient(2, 1) || Bench_CheckGradient(3, 1) || Bench_CheckGradient(4, 1))
+	{
+		return 1;
+	}
+	Sim_SPITransfer(0x8B);
+	if(Sim_SPITransfer(0x00) != ((ucRejected>0xFD) ? 0xFF : (ucRejected + 2))) // saturating
+	{
+		printf("  FAIL: rejected frames register does not count the uploads to a busy back frame\n");
+		return 1;
+	}
+	Sim_ClearStrip();
+
+	for(n=0;n<BENCH_COMMANDS;n++) // cost of a payload byte
+	{
+		Bench_Gradient(aucFrame, n);
+		for(i=0;i<sizeof(aucFrame);i++)
+		{
+			SPDR = aucFrame[i];
+			ullStart = Bench_Cycles();
+			SPI_STC_vect();
+			if(i>0)
+			{
+				Bench_Add(&sUploadByte, ullStart, Bench_Cycles());
+			}
+		}
+	}
+	Sim_SPISend(&ucLatch, 1);
+	processCommands();
+	Sim_RunRGBooster();
+	if(Bench_CheckGradient(0, BENCH_COMMANDS-1))
+	{
+		return 1;
+	}
+
+	Bench_Print(&sUploadByte);
+	printf("  %-44s 2 rejected, 1 aborted, strip unchanged\n", "uploads to a busy back frame");
+	return 0;
+}
+
+
+/** ***************************************************************************
+ * @brief Measure the free running temperature measurement
+ *
+ * The noise pattern has a mean of zero, so the oversampled result must be
+ * exactly 4 times the noiseless 10bit value. A value between two 10bit steps
+ * (half of the conversions one step higher) must show up in the 12bit result.
+ *
+ * @param [void] no input
+ * @return 0 if all results were correct
+ *****************************************************************************/
+static int Bench_Temperature(void)
+{
+	static const signed char acNoise[ADC_OVERSAMPLING] = {3, -2, 1, -3, 0, 2, -1, 0, -2, 3, 0, -1, 1, -3, 2, 0};
+	static const signed char acHalfStep[2] = {0, 1};
+	BENCH_STAT sADC = {"ISR(ADC_vect) per conversion", 0, 0, 0};
+	BENCH_STAT sRead = {"ADC_GetFiltered()", 0, 0, 0};
+	unsigned long n;
+	unsigned int uiValue;
+	unsigned char ucUpdated;
+	uint64_t ullStart;
+
+	Bench_Boot();
+
+	sSim.pcADCNoise = acNoise;
+	sSim.uiADCNoiseLength = ADC_OVERSAMPLING;
+	for(n=0;n<BENCH_COMMANDS;n++)
+	{
+		sSim.uiADCValue = 100 + (unsigned int)(n % 800);
+		sSim.ulADCSample = 0;
+		Sim_RunADC(ADC_OVERSAMPLING);
+		ullStart = Bench_Cycles();
+		uiValue = ADC_GetFiltered(&ucUpdated);
+		Bench_Add(&sRead, ullStart, Bench_Cycles());
+		if((!ucUpdated) || (uiValue != (sSim.uiADCValue * 4)))
+		{
+			printf("  FAIL: oversampled %u (updated %u), expected %u\n", uiValue, ucUpdated, sSim.uiADCValue * 4);
+			return 1;
+		}
+	}
+
+	sSim.pcADCNoise = acHalfStep;
+	sSim.uiADCNoiseLength = 2;
+	sSim.uiADCValue = 0x200;
+	Sim_RunADC(ADC_OVERSAMPLING);
+	uiValue = ADC_GetFiltered(&ucUpdated);
+	if(uiValue != ((0x200 * 4) + 2))
+	{
+		printf("  FAIL: oversampled %u, expected %u\n", uiValue, (0x200 * 4) + 2);
+		return 1;
+	}
+	ADC_GetFiltered(&ucUpdated);
+	if(ucUpdated)
+	{
+		printf("  FAIL: measurement reported as new twice\n");
+		return 1;
+	}
+	sSim.pcADCNoise = 0;
+
+	for(n=0;n<(BENCH_COMMANDS*ADC_OVERSAMPLING);n++)
+	{
+		ADCW = (uint16_t)(n & 0x3FF);
+		ullStart = Bench_Cycles();
+		ADC_vect();
+		Bench_Add(&sADC, ullStart, Bench_Cycles());
+	}
+
+	Bench_Print(&sADC);
+	Bench_Print(&sRead);
+	printf("  %-44s %u -> 12bit, no waiting in the main loop\n", "oversampled conversions", ADC_OVERSAMPLING);
+	return 0;
+}
+
+
+/** ***************************************************************************
+ * @brief Run the temperature update with a constant sensor voltage
+ *
+ * @param [in] uiADC: 10bit ADC value of every conversion
+ * @param [in] ucTemperature: expected temperature register [C]
+ * @param [in] ucStatus: expected derating bits of the status register
+ * @param [in] uiOCR: expected OCR1A value
+ * @param [in,out] psStat: statistics of updateTemperature()
+ * @return 0 if all values were correct
+ *****************************************************************************/
+static int Bench_CheckThermal(unsigned int uiADC, unsigned char ucTemperature, unsigned char ucStatus, unsigned int uiOCR, BENCH_STAT* psStat)
+{
+	unsigned char ucReadTemperature;
+	unsigned char ucReadStatus;
+	uint64_t ullStart;
+
+	sSim.uiADCValue = uiADC;
+	Sim_RunADC(ADC_OVERSAMPLING);
+	ullStart = Bench_Cycles();
+	updateTemperature();
+	Bench_Add(psStat, ullStart, Bench_Cycles());
+
+	Sim_SPITransfer(0x8E);
+	ucReadTemperature = Sim_SPITransfer(0x8F);
+	ucReadStatus = Sim_SPITransfer(0x00) & ((1<<STATUS_DERATING) | (1<<STATUS_OVERTEMP));
+	if((ucReadTemperature != ucTemperature) || (ucReadStatus != ucStatus) || (OCR1A != uiOCR))
+	{
+		printf("  FAIL: ADC %u: %uC status 0x%02X OCR1A %u, expected %uC status 0x%02X OCR1A %u\n", uiADC,
+			ucReadTemperature, ucReadStatus, (unsigned int)OCR1A, ucTemperature, ucStatus, uiOCR);
+		return 1;
+	}
+	return 0;
+}
+
+
+/** ***************************************************************************
+ * @brief Check and measure the thermal derating
+ *
+ * Limit 75C (derating from 60C), power LED at 100%: OCR1A = 1023 at full
+ * scale, 0xFFFF*64/256/64 = 255 at the limit (dithered fractions are not
+ * part of OCR1A).
+ *
+ * @param [void] no input
+ * @return 0 if all values were correct
+ *****************************************************************************/
+static int Bench_Thermal(void)
+{
+	BENCH_STAT sUpdate = {"updateTemperature() (integer conversion)", 0, 0, 0};
+	unsigned char aucDuty[2] = {0x82, 100};
+	unsigned char aucLimit[2] = {0x89, 75};
+	unsigned long n;
+	int iResult = 0;
+
+	Bench_Boot();
+	Sim_SPISend(aucDuty, 2);
+	Sim_SPISend(aucLimit, 2);
+
+	for(n=0;n<(BENCH_COMMANDS/4);n++)
+	{
+		iResult |= Bench_CheckThermal(154, 25, 0, 1023, &sUpdate);						// 25.2C
+		iResult |= Bench_CheckThermal(240, 67, (1<<STATUS_DERATING), 655, &sUpdate);	// 67.2C
+		iResult |= Bench_CheckThermal(266, 80, (1<<STATUS_DERATING) | (1<<STATUS_OVERTEMP), 255, &sUpdate);	// 79.9C
+		if(iResult)
+		{
+			return 1;
+		}
+	}
+	aucLimit[1] = 100;
+	Sim_SPISend(aucLimit, 2);
+	iResult |= Bench_CheckThermal(266, 80, 0, 1023, &sUpdate);
+	aucLimit[1] = 75;
+	Sim_SPISend(aucLimit, 2);
+	if(iResult)
+	{
+		return 1;
+	}
+
+	Bench_Print(&sUpdate);
+	return 0;
+}
+
+
+/** ***************************************************************************
+ * @brief Check the command latency and measure the scheduler
+ *
+ * A color command (latches itself) arrives between two ticks. Ticks are advanced
+ * until the first byte reaches the RGBooster. The temperature task has to
+ * pick up a new measurement within its period.
+ *
+ * @param [void] no input
+ * @return 0 if all latencies were within one period
+ *****************************************************************************/
+static int Bench_Scheduler(void)
+{
+	BENCH_STAT sDue = {"Scheduler_Run() with due tasks", 0, 0, 0};
+	BENCH_STAT sIdle = {"Scheduler_Run() without due tasks", 0, 0, 0};
+	unsigned char aucColor[4] = {0x84, 0x00, 0x00, 0x00};
+	unsigned long n;
+	unsigned long ulTicks;
+	unsigned long ulMaxTicks = 0;
+	unsigned long ulTotalTicks = 0;
+	uint64_t ullStart;
+
+	Bench_Boot();
+	initTasks();
+
+	for(n=0;n<(BENCH_COMMANDS/10);n++)
+	{
+		aucColor[1] = (unsigned char)(n & 0x7F); // legacy data bytes
+		aucColor[2] = (unsigned char)((n >> 4) & 0x7F);
+		Sim_SPISend(aucColor, 4);
+		ulTicks = 0;
+		while(!sSim.ucHandshakePending)
+		{
+			Sim_RunTicks(1);
+			ulTicks++;
+			ullStart = Bench_Cycles();
+			Scheduler_Run();
+			Bench_Add(&sDue, ullStart, Bench_Cycles());
+			ullStart = Bench_Cycles();
+			Scheduler_Run(); // same tick again: nothing due
+			Bench_Add(&sIdle, ullStart, Bench_Cycles());
+			if(ulTicks > TASK_PERIOD_TEMPERATURE)
+			{
+				break;
+			}
+		}
+		Sim_RunRGBooster();
+		if(ulTicks > TASK_PERIOD_COMMANDS)
+		{
+			printf("  FAIL: command executed after %lu ticks\n", ulTicks);
+			return 1;
+		}
+		if(Bench_CheckFrame(aucColor[1], aucColor[2], aucColor[3]))
+		{
+			return 1;
+		}
+		Sim_ClearStrip();
+		ulTotalTicks += ulTicks;
+		if(ulTicks > ulMaxTicks)
+		{
+			ulMaxTicks = ulTicks;
+		}
+	}
+
+	sSim.uiADCValue = 240; // 67.2C
+	Sim_RunADC(ADC_OVERSAMPLING);
+	Sim_RunTicks(TASK_PERIOD_TEMPERATURE);
+	Scheduler_Run();
+	Sim_SPITransfer(0x8E);
+	if(Sim_SPITransfer(0x00) != 67)
+	{
+		printf("  FAIL: temperature not updated within %u ticks\n", TASK_PERIOD_TEMPERATURE);
+		return 1;
+	}
+
+	Bench_Print(&sDue);
+	Bench_Print(&sIdle);
+	printf("  %-44s %5.2f ms avg, %lu ms max (wait_1ms loop: up to 1000 ms)\n", "command latency",
+		(double)ulTotalTicks / (double)(BENCH_COMMANDS/10), ulMaxTicks);
+	return 0;
+}
+
+
+/** ***************************************************************************
+ * @brief Run the main loop with idle sleep
+ *
+ * The main loop of main() (Scheduler_Run() and Scheduler_Sleep()) runs for
+ * BENCH_SLEEP_MS ticks. Every 10ms a color command arrives while the CPU is
+ * awake and the strip transfer wakes it up once per byte. The command still
+ * has to reach the strip with the next tick. Every tick without other work
+ * must end in exactly one sleep.
+ * The time between two sleeps is measured. The former main loop polled
+ * Scheduler_Run() without ever sleeping (100% active).
+ *
+ * @param [void] no input
+ * @return 0 if all checks passed
+ *****************************************************************************/
+static int Bench_Sleep(void)
+{
+	unsigned char aucColor[4] = {0x84, 0x00, 0x00, 0x00};
+	unsigned long n;
+	unsigned long ulPasses;
+	unsigned long ulAwake = 0;
+	unsigned long ulWakeups = 0;
+	uint64_t ullStart;
+	double dActive;
+
+	Bench_Boot();
+	sSim.uiADCValue = 154; // 25C, no derating
+	initTasks();
+	sSim.ulSleeps = 0;
+
+	for(n=0;n<BENCH_SLEEP_MS;n++)
+	{
+		ullStart = Bench_Cycles();
+		Scheduler_Run();
+		if((n % 10)==0) // command received while the CPU is awake
+		{
+			aucColor[1] = (unsigned char)(n & 0x7F);
+			Sim_SPISend(aucColor, sizeof(aucColor));
+		}
+		Scheduler_Sleep(); // wakes up with the next tick
+		ulAwake += (unsigned long)(Bench_Cycles() - ullStart);
+
+		if((n % 10)==0)
+		{
+			ulPasses = 0;
+			while((!sSim.ucHandshakePending) && (ulPasses<TASK_PERIOD_EFFECTS))
+			{
+				ullStart = Bench_Cycles();
+				Scheduler_Run();
+				Scheduler_Sleep();
+				ulAwake += (unsigned long)(Bench_Cycles() - ullStart);
+				ulPasses++;
+				n++;
+			}
+			if(ulPasses>TASK_PERIOD_COMMANDS) // executed with the tick after the command
+			{
+				printf("  FAIL: command executed after %lu ticks\n", ulPasses);
+				return 1;
+			}
+			while(sSim.ucHandshakePending) // every handshake wakes the CPU
+			{
+				sSim.ucHandshakePending = 0;
+				ullStart = Bench_Cycles();
+				INT1_vect();
+				Scheduler_Run(); // nothing due
+				ulAwake += (unsigned long)(Bench_Cycles() - ullStart);
+				ulWakeups++;
+			}
+			if(Bench_CheckFrame(aucColor[1], aucColor[2], aucColor[3]))
+			{
+				return 1;
+			}
+			Sim_ClearStrip();
+		}
+	}
+
+	if(sSim.ulSleeps!=BENCH_SLEEP_MS)
+	{
+		printf("  FAIL: %lu sleeps in %u ticks\n", sSim.ulSleeps, BENCH_SLEEP_MS);
+		return 1;
+	}
+	if(SMCR & (1<<SE))
+	{
+		printf("  FAIL: sleep enable bit left set\n");
+		return 1;
+	}
+
+	dActive = (100.0 * (double)ulAwake) / ((double)BENCH_SLEEP_MS * (F_CPU / 1000));
+	printf("  %-44s %lu ticks, %lu sleeps, %lu handshake wake-ups\n", "main loop with idle sleep", (unsigned long)BENCH_SLEEP_MS, sSim.ulSleeps, ulWakeups);
+	printf("  %-44s %.0f cycles/ms awake = %.2f%% of %lu (polling loop: 100%%)\n", "active cycles (host)",
+		(double)ulAwake / (double)BENCH_SLEEP_MS, dActive, (unsigned long)(F_CPU / 1000));
+	return 0;
+}
+
+
+/** ***************************************************************************
+ * @brief Run a sunrise program and check the outputs
+ *
+ * The ticks are advanced one by one, every step has to keep OCR1A and the
+ * red value of the strip at or above the previous one.
+ *
+ * @param [in] aucPayload: sunrise payload (see Sunrise_Parse())
+ * @param [in,out] psStat: statistics of Scheduler_Run() on the sunrise steps
+ * @return 0 if the outputs were correct
+ *****************************************************************************/
+static int Bench_RunSunrise(const unsigned char* aucPayload, BENCH_STAT* psStat)
+{
+	unsigned char aucFrame[4+SUNRISE_PAYLOAD_SIZE];
+	unsigned long ulDuration = ((unsigned long)aucPayload[8] << 8) | aucPayload[9];
+	unsigned long ulTicks;
+	unsigned char aucDuty[2] = {0x82, aucPayload[0]};
+	unsigned int uiLastOCR;
+	unsigned char ucLastRed = aucPayload[2];
+	uint64_t ullStart;
+
+	Sim_SPISend(aucDuty, 2); // start from the first dutycycle of the program
+	uiLastOCR = OCR1A;
+	Sim_SPISend(aucFrame, Bench_BuildFrame(aucFrame, 0x90, aucPayload, SUNRISE_PAYLOAD_SIZE));
+	for(ulTicks=0;ulTicks<=((ulDuration*1000) + (2*TASK_PERIOD_EFFECTS));ulTicks++)
+	{
+		Sim_RunTicks(1);
+		ullStart = Bench_Cycles();
+		Scheduler_Run();
+		if((ulTicks % TASK_PERIOD_EFFECTS) == 0)
+		{
+			Bench_Add(psStat, ullStart, Bench_Cycles());
+		}
+		if(sSim.uiStripCount)
+		{
+			Sim_RunRGBooster();
+			if(sSim.aucStrip[1] < ucLastRed)
+			{
+				printf("  FAIL: sunrise red %u after %u\n", sSim.aucStrip[1], ucLastRed);
+				return 1;
+			}
+			ucLastRed = sSim.aucStrip[1];
+			Sim_ClearStrip();
+		}
+		if(OCR1A < uiLastOCR)
+		{
+			printf("  FAIL: sunrise OCR1A %u after %u\n", (unsigned int)OCR1A, uiLastOCR);
+			return 1;
+		}
+		uiLastOCR = OCR1A;
+	}
+
+	Sim_SPITransfer(0x8F);
+	if(Sim_SPITransfer(0x00) & (1<<STATUS_SUNRISE))
+	{
+		printf("  FAIL: sunrise still running after %lu s\n", ulDuration);
+		return 1;
+	}
+	if((OCR1A != Bench_PWMBase(Gamma_PLED(percentToLevel(aucPayload[1])))) || (ucLastRed != aucPayload[5]))
+	{
+		printf("  FAIL: sunrise ended at OCR1A %u red %u\n", (unsigned int)OCR1A, ucLastRed);
+		return 1;
+	}
+	return 0;
+}
+
+
+/** ***************************************************************************
+ * @brief Check and measure the sunrise engine
+ *
+ * All curves run from 0% to 100% and from a dark red to an orange within 10s
+ * (sensor at 25C, no derating). A stopped sunrise has to keep its outputs.
+ *
+ * @param [void] no input
+ * @return 0 if all outputs were correct
+ *****************************************************************************/
+static int Bench_Sunrise(void)
+{
+	BENCH_STAT sStep = {"Scheduler_Run() with a sunrise step", 0, 0, 0};
+	unsigned char aucPayload[SUNRISE_PAYLOAD_SIZE] = {0, 100, 0x10, 0x00, 0x00, 0xFF, 0x80, 0x10, 0x00, 10, SUNRISE_LINEAR};
+	unsigned char aucStart[4+SUNRISE_PAYLOAD_SIZE];
+	unsigned char aucFrame[4+1];
+	unsigned char ucCurve;
+	unsigned int uiOCR;
+	unsigned long ulSteps;
+
+	Bench_Boot();
+	sSim.uiADCValue = 154; // 25.2C: no derating
+	Sim_RunADC(ADC_OVERSAMPLING);
+	initTasks();
+
+	for(ucCurve=0;ucCurve<SUNRISE_CURVES;ucCurve++)
+	{
+		aucPayload[10] = ucCurve;
+		if(Bench_RunSunrise(aucPayload, &sStep))
+		{
+			printf("  FAIL: curve %u\n", ucCurve);
+			return 1;
+		}
+	}
+
+	aucPayload[0] = 100; // falling
+	aucPayload[1] = 0;
+	aucPayload[10] = SUNRISE_LINEAR;
+	Sim_SPISend(aucStart, Bench_BuildFrame(aucStart, 0x90, aucPayload, SUNRISE_PAYLOAD_SIZE));
+	Sim_RunTicks(5000);
+	Scheduler_Run();
+	Sim_RunTicks(TASK_PERIOD_EFFECTS);
+	Scheduler_Run();
+	Sim_RunRGBooster();
+	Sim_ClearStrip();
+	uiOCR = OCR1A;
+	Sim_SPISend(aucFrame, Bench_BuildFrame(aucFrame, 0x91, 0, 0));
+	Sim_RunTicks(TASK_PERIOD_EFFECTS);
+	Scheduler_Run();
+	Sim_RunTicks(TASK_PERIOD_EFFECTS);
+	Scheduler_Run();
+	if((OCR1A != uiOCR) || (uiOCR == 0) || (uiOCR == PWM_TOP))
+	{
+		printf("  FAIL: stopped sunrise OCR1A %u -> %u\n", uiOCR, (unsigned int)OCR1A);
+		return 1;
+	}
+
+	ulSteps = (10UL * 1000) / TASK_PERIOD_EFFECTS;
+	Bench_Print(&sStep);
+	printf("  %-44s %u SPI bytes instead of %lu (duty + color per step)\n", "10s sunrise upload",
+		4 + SUNRISE_PAYLOAD_SIZE, ulSteps * (2 + 4));
+	return 0;
+}
+
+
+/** ***************************************************************************
+ * @brief Former Map(): convert a value to a different number range
+ *
+ * @param [in] lData: data to be converted
+ * @param [in] InMin: minimal value of input range
+ * @param [in] InMax: maximal value of input range
+ * @param [in] OutMin: minimal value of output range
+ * @param [in] OutMax: maximal value of output range
+ * @return data in new number range
+ *****************************************************************************/
+static long Bench_LegacyMap(long lData, long InMin, long InMax, long OutMin, long OutMax)
+{
+	return((lData-InMin)*(OutMax-OutMin)/(InMax-InMin)+OutMin);
+}
+
+
+/** ***************************************************************************
+ * @brief Former setDuty(): linear 9bit OCR1A value with Map()
+ *
+ * @param [in] ucPercent: dutycycle in percent [0-100]
+ * @return no return value
+ *****************************************************************************/
+static void __attribute__((noinline)) Bench_LegacySetDuty(unsigned char ucPercent)
+{
+	OCR1A = (unsigned int)Bench_LegacyMap(ucPercent, 0, 100, 0, 511);
+}
+
+
+/** ***************************************************************************
+ * @brief Check and measure the brightness correction
+ *
+ * @param [void] no input
+ * @return 0 if all values were correct
+ *****************************************************************************/
+static int Bench_Gamma(void)
+{
+	BENCH_STAT sLegacy = {"setDuty() legacy Map()", 0, 0, 0};
+	BENCH_STAT sDuty = {"setDuty() CIE 1931 table", 0, 0, 0};
+	unsigned char aucSelect[2] = {GAMMA_PLED_CIE1931, GAMMA_RGB_2_2};
+	unsigned char aucColor[4] = {0x84, 0x40, 0x10, 0x7F};
+	unsigned char aucFull[4] = {0x84, 0x7F, 0x7F, 0x7F};
+	unsigned char aucFrame[6];
+	unsigned long n;
+	unsigned long ulLevel;
+	unsigned int uiLast = 0;
+	unsigned int uiIntensity;
+	static const unsigned char aucLow[4] = {1, 2, 5, 10};
+	unsigned int auiLinear[4];
+	unsigned int auiCIE[4];
+	unsigned char ucPercent;
+	uint64_t ullStart;
+
+	Bench_Boot();
+	initTasks();
+	sSim.uiADCValue = 154; // 25.2C: no derating
+	Sim_RunADC(ADC_OVERSAMPLING);
+	Scheduler_Run();
+
+	for(ulLevel=0;ulLevel<=DUTY_LEVEL_MAX;ulLevel++)
+	{
+		uiIntensity = Gamma_PLED((unsigned int)ulLevel);
+		if(uiIntensity < uiLast)
+		{
+			printf("  FAIL: CIE 1931 intensity falls at level %lu\n", ulLevel);
+			return 1;
+		}
+		uiLast = uiIntensity;
+	}
+	if(uiLast != 0xFFFF)
+	{
+		printf("  FAIL: CIE 1931 intensity %u at full level\n", uiLast);
+		return 1;
+	}
+
+	for(n=0;n<BENCH_COMMANDS;n++)
+	{
+		ucPercent = (unsigned char)(n % 101);
+		ullStart = Bench_Cycles();
+		Bench_LegacySetDuty(ucPercent);
+		Bench_Add(&sLegacy, ullStart, Bench_Cycles());
+		ullStart = Bench_Cycles();
+		setDuty(ucPercent);
+		Bench_Add(&sDuty, ullStart, Bench_Cycles());
+	}
+	for(n=0;n<4;n++) // low end of the brightness [1/65536]
+	{
+		Bench_LegacySetDuty(aucLow[n]);
+		auiLinear[n] = OCR1A * 128;
+		setDuty(aucLow[n]);
+		auiCIE[n] = (unsigned int)Bench_PWMAverage();
+	}
+	setDuty(100);
+	if(OCR1A != PWM_TOP)
+	{
+		printf("  FAIL: OCR1A %u at 100%%\n", (unsigned int)OCR1A);
+		return 1;
+	}
+
+	Gamma_Select(GAMMA_PLED_DEFAULT, GAMMA_RGB_DEFAULT); // as after a reset
+	Sim_SPISend(aucFull, 4);
+	Sim_RunTicks(TASK_PERIOD_COMMANDS);
+	Scheduler_Run();
+	Sim_RunRGBooster();
+	if(Bench_CheckFrame(0x7F, 0x7F, 0x7F))
+	{
+		printf("  FAIL: legacy 7bit full scale changed by the default RGB curve\n");
+		return 1;
+	}
+	Sim_ClearStrip();
+	Sim_SPISend(aucFrame, Bench_BuildFrame(aucFrame, 0x92, aucSelect, 2));
+	Sim_SPISend(aucColor, 4);
+	Sim_RunTicks(TASK_PERIOD_COMMANDS);
+	Scheduler_Run();
+	Sim_RunRGBooster();
+	if(Bench_CheckFrame(pgm_read_byte(&aucGammaRGB[GAMMA_RGB_2_2-1][0x40]), pgm_read_byte(&aucGammaRGB[GAMMA_RGB_2_2-1][0x10]),
+		pgm_read_byte(&aucGammaRGB[GAMMA_RGB_2_2-1][0x7F])))
+	{
+		return 1;
+	}
+	Sim_ClearStrip();
+	aucSelect[1] = GAMMA_RGB_OFF;
+	Sim_SPISend(aucFrame, Bench_BuildFrame(aucFrame, 0x92, aucSelect, 2));
+	Sim_SPISend(aucColor, 4);
+	Sim_RunTicks(TASK_PERIOD_COMMANDS);
+	Scheduler_Run();
+	Sim_RunRGBooster();
+	if(Bench_CheckFrame(0x40, 0x10, 0x7F))
+	{
+		return 1;
+	}
+	Sim_ClearStrip();
+
+	Bench_Print(&sLegacy);
+	Bench_Print(&sDuty);
+	printf("  %-44s %u/%u/%u/%u (9bit linear %u/%u/%u/%u) /65536\n", "1/2/5/10% with CIE 1931, no division",
+		auiCIE[0], auiCIE[1], auiCIE[2], auiCIE[3], auiLinear[0], auiLinear[1], auiLinear[2], auiLinear[3]);
+	return 0;
+}
+
+
+/** ***************************************************************************
+ * @brief Check and measure the dithered 16bit dutycycle
+ *
+ * The power LED curve is linear during the check, so the level is the
+ * intensity.
+ *
+ * @param [void] no input
+ * @return 0 if all dutycycles were correct
+ *****************************************************************************/
+static int Bench_Dithering(void)
+{
+	BENCH_STAT sOverflow = {"ISR(TIMER1_OVF_vect) dithering", 0, 0, 0};
+	unsigned char aucLevel[2] = {0x01, 0x23};
+	unsigned char aucFrame[6];
+	unsigned long ulLevel;
+	unsigned long ulAverage;
+	unsigned long ulLast = 0;
+	unsigned int uiLowLevels = 0;
+	unsigned long n;
+	uint64_t ullStart;
+
+	Bench_Boot();
+	Gamma_Select(GAMMA_PLED_LINEAR, GAMMA_RGB_OFF);
+	setDutyScale(DUTY_FULL_SCALE);
+
+	for(ulLevel=0;ulLevel<(PWM_TOP<<PWM_DITHER_BITS);ulLevel++)
+	{
+		setDutyLevel((unsigned int)ulLevel);
+		ulAverage = Bench_PWMAverage();
+		if(ulAverage != ulLevel)
+		{
+			printf("  FAIL: level %lu dithered to %lu\n", ulLevel, ulAverage);
+			return 1;
+		}
+		if((ulLevel <= (DUTY_LEVEL_MAX/10)) && ((ulLevel == 0) || (ulAverage != ulLast)))
+		{
+			uiLowLevels++;
+		}
+		ulLast = ulAverage;
+	}
+	setDutyLevel(DUTY_LEVEL_MAX);
+	if((Bench_PWMAverage() != (PWM_TOP<<PWM_DITHER_BITS)) || (TIMSK1 & (1<<TOIE1)))
+	{
+		printf("  FAIL: full level not constant\n");
+		return 1;
+	}
+
+	setDutyLevel(0x1234 | 0x15); // fraction 0x15 + 1 carry every 3 periods
+	for(n=0;n<(BENCH_COMMANDS*16);n++)
+	{
+		ullStart = Bench_Cycles();
+		TIMER1_OVF_vect();
+		Bench_Add(&sOverflow, ullStart, Bench_Cycles());
+	}
+
+	initTasks();
+	Sim_SPISend(aucFrame, Bench_BuildFrame(aucFrame, 0x93, aucLevel, 2));
+	Sim_RunTicks(TASK_PERIOD_COMMANDS);
+	Scheduler_Run();
+	if(Bench_PWMAverage() != 0x0123)
+	{
+		printf("  FAIL: 0x93 level 0x0123 not applied\n");
+		return 1;
+	}
+	Gamma_Select(GAMMA_PLED_DEFAULT, GAMMA_RGB_OFF);
+
+	Bench_Print(&sOverflow);
+	printf("  %-44s %u (9bit PWM: %u), 19.5kHz PWM, 305Hz dithering\n", "dutycycles up to 10%",
+		uiLowLevels, (unsigned int)((PWM_TOP+1)/2/10) + 1);
+	return 0;
+}
+
+
+/** ***************************************************************************
+ * @brief Send single LED commands faster than the main loop executes them
+ *
+ * The main loop runs once per BENCH_LOOP_BYTES SPI bytes (including the
+ * status reads), so the RPi sends about 2 commands per main loop pass more
+ * than fit into the command queue. After every command the status register
+ * is read. A paced RPi also reads it before every command and waits while
+ * STATUS_BUSY is set.
+ *
+ * @param [in] ucPaced: 1: wait for STATUS_BUSY to clear  0: send blindly
+ * @param [out] pulPolls: amount of status reads
+ * @return amount of commands reported as dropped (STATUS_DROPPED)
+ *****************************************************************************/
+static unsigned long Bench_SendCommands(unsigned char ucPaced, unsigned long* pulPolls)
+{
+	unsigned long n;
+	unsigned int i;
+	unsigned int uiBytes = 0;
+	unsigned long ulDropped = 0;
+	unsigned char ucStatus;
+	unsigned char aucCommand[5];
+
+	*pulPolls = 0;
+	for(n=0;n<BENCH_COMMANDS;n++)
+	{
+		aucCommand[0] = 0x85;
+		aucCommand[1] = (unsigned char)(n % LED_COUNT_DEFAULT);
+		aucCommand[2] = (unsigned char)(n & 0x7F);
+		aucCommand[3] = (unsigned char)((n >> 7) & 0x7F);
+		aucCommand[4] = 0x10;
+
+		for(i=0;i<=sizeof(aucCommand);i++)
+		{
+			if(i<sizeof(aucCommand)) // command byte
+			{
+				Sim_SPITransfer(aucCommand[i]);
+				uiBytes++;
+			}
+			else // status read after the command
+			{
+				Sim_SPITransfer(0x8F);
+				ucStatus = Sim_SPITransfer(0x00);
+				uiBytes += 2;
+				(*pulPolls)++;
+				if(ucStatus & (1<<STATUS_DROPPED))
+				{
+					ulDropped++;
+				}
+			}
+			if(uiBytes>=BENCH_LOOP_BYTES) // main loop pass
+			{
+				processCommands();
+				uiBytes -= BENCH_LOOP_BYTES;
+			}
+			while((ucPaced) && (i==sizeof(aucCommand)) && (ucStatus & (1<<STATUS_BUSY))) // wait before the next command
+			{
+				Sim_SPITransfer(0x8F);
+				ucStatus = Sim_SPITransfer(0x00);
+				uiBytes += 2;
+				(*pulPolls)++;
+				if(uiBytes>=BENCH_LOOP_BYTES)
+				{
+					processCommands();
+					uiBytes -= BENCH_LOOP_BYTES;
+				}
+			}
+		}
+	}
+	processCommands();
+	return ulDropped;
+}
+
+
+/** ***************************************************************************
+ * @brief Check the backpressure status bits of the command queue
+ *
+ * STATUS_BUSY must be set as soon as at most CMD_QUEUE_RESERVE records are
+ * free, STATUS_DROPPED once for every status read after a dropped command.
+ * A burst sent blindly loses commands, the same burst paced with STATUS_BUSY
+ * must not lose any.
+ *
+ * @param [void] no input
+ * @return 0 if all checks passed
+ *****************************************************************************/
+static int Bench_Backpressure(void)
+{
+	unsigned int i;
+	unsigned char aucCommand[5] = {0x85, 0x00, 0x10, 0x20, 0x30};
+	unsigned char ucStatus;
+	unsigned long ulBlind;
+	unsigned long ulPaced;
+	unsigned long ulBlindPolls;
+	unsigned long ulPacedPolls;
+	const unsigned char ucBits = (1<<STATUS_BUSY) | (1<<STATUS_DROPPED);
+	const unsigned char aucExpected[4] = {(1<<STATUS_BUSY), (1<<STATUS_BUSY) | (1<<STATUS_DROPPED), (1<<STATUS_BUSY), 0};
+
+	Bench_Boot();
+	Sim_SPITransfer(0x8F); // clear a drop of a previous measurement
+	Sim_SPITransfer(0x00);
+
+	for(i=0;i<(CMD_QUEUE_SIZE-CMD_QUEUE_RESERVE);i++)
+	{
+		Sim_SPISend(aucCommand, sizeof(aucCommand));
+	}
+	for(i=0;i<4;i++)
+	{
+		if(i==1) // queue full plus one dropped command
+		{
+			Sim_SPISend(aucCommand, sizeof(aucCommand));
+			Sim_SPISend(aucCommand, sizeof(aucCommand));
+		}
+		if(i==3)
+		{
+			processCommands();
+		}
+		Sim_SPITransfer(0x8F);
+		ucStatus = Sim_SPITransfer(0x00) & ucBits;
+		if(ucStatus!=aucExpected[i])
+		{
+			printf("  FAIL: status 0x%02X after step %u, expected 0x%02X\n", ucStatus, i, aucExpected[i]);
+			return 1;
+		}
+	}
+
+	ulBlind = Bench_SendCommands(0, &ulBlindPolls);
+	ulPaced = Bench_SendCommands(1, &ulPacedPolls);
+	if((ulBlind==0) || (ulPaced!=0))
+	{
+		printf("  FAIL: %lu commands dropped blindly, %lu paced\n", ulBlind, ulPaced);
+		return 1;
+	}
+
+	printf("  %-44s %lu of %u commands dropped\n", "burst sent blindly", ulBlind, BENCH_COMMANDS);
+	printf("  %-44s 0 of %u commands dropped (%lu status reads)\n", "burst paced with STATUS_BUSY", BENCH_COMMANDS, ulPacedPolls);
+	return 0;
+}
+
+
+/** ***************************************************************************
+ * @brief Read a register with [0x8C, RR, 0x00]
+ *
+ * @param [in] ucRegister: INSTR_REG_* or REG_*
+ * @return register value
+ *****************************************************************************/
+static unsigned char Bench_ReadRegister(unsigned char ucRegister)
+{
+	Sim_SPITransfer(0x8C);
+	Sim_SPITransfer(ucRegister);
+	return Sim_SPITransfer(0x00);
+}
+
+
+/** ***************************************************************************
+ * @brief Read the strip length from the configuration registers
+ *
+ * @param [void] no input
+ * @return strip length [LEDs]
+ *****************************************************************************/
+static unsigned int Bench_ReadLength(void)
+{
+	return ((unsigned int)Bench_ReadRegister(REG_LED_COUNT_HIGH) << 8) | Bench_ReadRegister(REG_LED_COUNT_LOW);
+}
+
+
+/** ***************************************************************************
+ * @brief Set the strip length with the framed 0x94 and execute it
+ *
+ * The following BENCH_LAYOUT_PASSES passes store the length in the EEPROM.
+ *
+ * @param [in] uiLEDs: strip length
+ * @return EEPROM bytes written by the pass executing the 0x94
+ *****************************************************************************/
+static unsigned long Bench_SetLength(unsigned int uiLEDs)
+{
+	unsigned char aucPayload[2];
+	unsigned char aucFrame[8];
+	unsigned long ulWrites = ulSimEEPROMWrites;
+	unsigned int i;
+
+	aucPayload[0] = (unsigned char)(uiLEDs >> 8);
+	aucPayload[1] = (unsigned char)uiLEDs;
+	Sim_SPISend(aucFrame, Bench_BuildFrame(aucFrame, 0x94, aucPayload, sizeof(aucPayload)));
+	processCommands();
+	ulWrites = ulSimEEPROMWrites - ulWrites;
+	for(i=0;i<BENCH_LAYOUT_PASSES;i++)
+	{
+		processCommands();
+	}
+	return ulWrites;
+}
+
+
+/** ***************************************************************************
+ * @brief Check the runtime strip length and the storage modes
+ *
+ * - 150 LEDs (double buffered) and 300 LEDs (single buffer) are cleared when
+ *   set and show a single color command and a legacy full frame upload.
+ * - With a single buffer, an upload during a transfer is rejected and
+ *   commands wait for the end of the transfer. The framed 0x95 reaches the
+ *   last LED of the long strip.
+ * - The length is stored in the EEPROM by the following passes, survives a
+ *   reboot, invalid lengths are ignored and shortening the strip turns the
+ *   LEDs behind it off.
+ *
+ * @param [void] no input
+ * @return 0 if all checks passed
+ *****************************************************************************/
+static int Bench_StripLength(void)
+{
+	static unsigned char aucUpload[1+(LED_COUNT_MAX_GRB*3)];
+	unsigned char aucColor[4] = {0x84, 0x10, 0x20, 0x30};
+	unsigned char aucLast[6] = {0x01, 0x2B, 1, 0x7F, 0x00, 0x40};	// LED 299
+	unsigned char aucFrame[16];
+	unsigned char ucLatch = 0x88;
+	unsigned int i;
+
+	Bench_Boot();
+	if((Bench_ReadLength() != LED_COUNT_DEFAULT) || (Bench_ReadRegister(REG_STORAGE) != STORAGE_DOUBLE) ||
+		(Bench_ReadRegister(REG_MAX_DOUBLE_LOW) != ((LED_COUNT_MAX_GRB/2) & 0xFF)) || (Bench_ReadRegister(REG_MAX_SINGLE_HIGH) != (LED_COUNT_MAX_GRB >> 8)) ||
+		(Bench_ReadRegister(REG_FORMAT) != FORMAT_GRB))
+	{
+		printf("  FAIL: configuration registers after boot\n");
+		return 1;
+	}
+
+	Bench_SetLength(150);
+	Sim_RunRGBooster();
+	if(Bench_CheckStrip(150, 0, 0, 0) || (Bench_ReadLength() != 150) || (Bench_ReadRegister(REG_STORAGE) != STORAGE_DOUBLE))
+	{
+		printf("  FAIL: 150 LEDs not set up double buffered\n");
+		return 1;
+	}
+	Sim_ClearStrip();
+	Sim_SPISend(aucColor, sizeof(aucColor));
+	processCommands();
+	Sim_RunRGBooster();
+	if(Bench_CheckStrip(150, aucColor[1], aucColor[2], aucColor[3]))
+	{
+		return 1;
+	}
+
+	Sim_ClearStrip();
+	if(Bench_SetLength(300))
+	{
+		printf("  FAIL: strip length written to the EEPROM by the 0x94 pass\n");
+		return 1;
+	}
+	Sim_RunRGBooster();
+	if(Bench_CheckStrip(300, 0, 0, 0) || (Bench_ReadLength() != 300) || (Bench_ReadRegister(REG_STORAGE) != STORAGE_SINGLE))
+	{
+		printf("  FAIL: 300 LEDs not set up with a single buffer\n");
+		return 1;
+	}
+	Sim_ClearStrip();
+	aucUpload[0] = 0x87;
+	for(i=0;i<(300*3);i++)
+	{
+		aucUpload[1+i] = (unsigned char)((i * 5) & 0x7F);
+	}
+	Sim_SPISend(aucUpload, 1+(300*3));
+	Sim_SPISend(&ucLatch, 1);
+	processCommands();
+	Sim_RunRGBooster();
+	for(i=0;i<300;i++)
+	{
+		if((sSim.aucStrip[(i*3)+0] != aucUpload[2+(i*3)]) || (sSim.aucStrip[(i*3)+1] != aucUpload[1+(i*3)]) || (sSim.aucStrip[(i*3)+2] != aucUpload[3+(i*3)]))
+		{
+			printf("  FAIL: upload of 300 LEDs wrong at LED %u\n", i);
+			return 1;
+		}
+	}
+
+	Sim_ClearStrip();
+	Sim_SPISend(aucColor, sizeof(aucColor));
+	processCommands(); // transfer running, the single buffer is not writable
+	Sim_SPITransfer(0x8F);
+	Sim_SPITransfer(0x00); // clears STATUS_DROPPED
+	Sim_SPISend(aucUpload, 1+(300*3));
+	Sim_SPITransfer(0x8F);
+	if(!(Sim_SPITransfer(0x00) & (1<<STATUS_DROPPED)))
+	{
+		printf("  FAIL: upload during a transfer of the single buffer not rejected\n");
+		return 1;
+	}
+	Sim_SPISend(aucFrame, Bench_BuildFrame(aucFrame, 0x95, aucLast, sizeof(aucLast)));
+	Sim_SPISend(&ucLatch, 1);
+	processCommands();
+	if(sSim.uiStripCount != 1)
+	{
+		printf("  FAIL: command executed during a transfer of the single buffer\n");
+		return 1;
+	}
+	Sim_RunRGBooster();
+	processCommands();
+	Sim_RunRGBooster();
+	if(sSim.uiStripCount != (2*300*3))
+	{
+		printf("  FAIL: %u bytes sent to the RGBooster, expected %u\n", sSim.uiStripCount, 2*300*3);
+		return 1;
+	}
+	for(i=0;i<300;i++)
+	{
+		if((sSim.aucStrip[900+(i*3)+0] != ((i==299) ? 0x00 : aucColor[2])) || (sSim.aucStrip[900+(i*3)+1] != ((i==299) ? 0x7F : aucColor[1])) ||
+			(sSim.aucStrip[900+(i*3)+2] != ((i==299) ? 0x40 : aucColor[3])))
+		{
+			printf("  FAIL: 0x95 frame wrong at LED %u\n", i);
+			return 1;
+		}
+	}
+
+	Sim_Reset(); // reboot: length from the EEPROM
+	systemInit();
+	Sim_RunRGBooster();
+	Bench_SetLength(0);
+	Bench_SetLength(LED_COUNT_MAX_GRB+1);
+	Sim_RunRGBooster();
+	if(Bench_CheckStrip(300, 0, 0, 0) || (Bench_ReadLength() != 300))
+	{
+		printf("  FAIL: strip length not restored after reboot or changed by an invalid length\n");
+		return 1;
+	}
+
+	Sim_ClearStrip();
+	Bench_SetLength(LED_COUNT_DEFAULT);
+	Sim_RunRGBooster();
+	if(Bench_CheckStrip(300, 0, 0, 0) || (Bench_ReadLength() != LED_COUNT_DEFAULT))
+	{
+		printf("  FAIL: LEDs behind the shortened strip not turned off\n");
+		return 1;
+	}
+	Bench_Boot();
+
+	printf("  %-44s 150 LEDs double buffered, 300 LEDs single buffer, kept over reboot\n", "strip length 0x94 (EEPROM)");
+	printf("  %-44s double %u LEDs (6 B/LED), single %u LEDs (3 B/LED), pool %u B\n", "maximum strip length per storage mode",
+		LED_COUNT_MAX_GRB/2, LED_COUNT_MAX_GRB, FRAME_POOL_SIZE);
+	return 0;
+}
+
+
+/** ***************************************************************************
+ * @brief Set the strip length and the format with the framed 0x94
+ *
+ * The following BENCH_LAYOUT_PASSES passes store the layout in the EEPROM.
+ *
+ * @param [in] uiLEDs: strip length
+ * @param [in] ucFormat: framebuffer format (FORMAT_*)
+ * @return no return value
+ *****************************************************************************/
+static void Bench_SetLayout(unsigned int uiLEDs, unsigned char ucFormat)
+{
+	unsigned char aucPayload[3];
+	unsigned char aucFrame[8];
+	unsigned int i;
+
+	aucPayload[0] = (unsigned char)(uiLEDs >> 8);
+	aucPayload[1] = (unsigned char)uiLEDs;
+	aucPayload[2] = ucFormat;
+	Sim_SPISend(aucFrame, Bench_BuildFrame(aucFrame, 0x94, aucPayload, sizeof(aucPayload)));
+	for(i=0;i<=BENCH_LAYOUT_PASSES;i++)
+	{
+		processCommands();
+	}
+}
+
+
+/** ***************************************************************************
+ * @brief Check that the sent frame shows the palette colors of the indices
+ *
+ * @param [in] uiLEDs: strip length
+ * @param [in] pucPalette: palette (red, green, blue per entry)
+ * @param [in] pucIndex: palette index per LED
+ * @return 0 if the frame is correct
+ *****************************************************************************/
+static int Bench_CheckPalette(unsigned int uiLEDs, const unsigned char* pucPalette, const unsigned char* pucIndex)
+{
+	unsigned int i;
+	const unsigned char* pucColor;
+
+	if(sSim.uiStripCount != (uiLEDs*3))
+	{
+		printf("  FAIL: %u bytes sent to the RGBooster, expected %u\n", sSim.uiStripCount, uiLEDs*3);
+		return 1;
+	}
+	for(i=0;i<uiLEDs;i++)
+	{
+		pucColor = &pucPalette[pucIndex[i]*3];
+		if((sSim.aucStrip[(i*3)+0] != pucColor[1]) || (sSim.aucStrip[(i*3)+1] != pucColor[0]) || (sSim.aucStrip[(i*3)+2] != pucColor[2]))
+		{
+			printf("  FAIL: wrong palette color on LED %u\n", i);
+			return 1;
+		}
+	}
+	return 0;
+}
+
+
+/** ***************************************************************************
+ * @brief Check the palette indexed framebuffer formats
+ *
+ * - FORMAT_PAL4 with 300 LEDs (double buffered): palette with the framed
+ *   0x96, indices with the legacy 0x87, latched with 0x88. Recolouring the
+ *   strip with one palette entry is compared with a full GRB upload.
+ * - The framed 0x97 writes single indices (both nibbles of a byte).
+ * - FORMAT_PAL8 with 600 LEDs (single buffer) with a framed palette of 64
+ *   entries and the indices of a framed 0x97.
+ * - The format survives a reboot, the maximum length of FORMAT_PAL4 is
+ *   accepted and one LED more is ignored.
+ *
+ * @param [void] no input
+ * @return 0 if all checks passed
+ *****************************************************************************/
+static int Bench_Palette(void)
+{
+	static unsigned char aucUpload[1+600];
+	static unsigned char aucIndex[600];
+	unsigned char aucPalette[PALETTE8_SIZE];
+	unsigned char aucPayload[CMD_PAYLOAD_SIZE];
+	unsigned char aucFrame[CMD_PAYLOAD_SIZE+4];
+	unsigned char ucLatch = 0x88;
+	unsigned int uiRecolour;
+	unsigned int uiLength;
+	unsigned int i;
+	unsigned int j;
+
+	Bench_Boot();
+	Bench_SetLayout(300, FORMAT_PAL4);
+	Sim_RunRGBooster();
+	if(Bench_CheckStrip(300, 0, 0, 0) || (Bench_ReadLength() != 300) || (Bench_ReadRegister(REG_FORMAT) != FORMAT_PAL4) ||
+		(Bench_ReadRegister(REG_STORAGE) != STORAGE_DOUBLE))
+	{
+		printf("  FAIL: 300 LEDs not set up with FORMAT_PAL4\n");
+		return 1;
+	}
+
+	for(i=0;i<(PALETTE4_ENTRIES*3);i++)
+	{
+		aucPalette[i] = (unsigned char)((i * 37) + 11);
+	}
+	for(i=0;i<PALETTE4_ENTRIES;i+=CMD_RANGE_MAX)
+	{
+		uiLength = ((PALETTE4_ENTRIES-i)<CMD_RANGE_MAX) ? (PALETTE4_ENTRIES-i) : CMD_RANGE_MAX;
+		aucPayload[0] = (unsigned char)i;
+		aucPayload[1] = (unsigned char)uiLength;
+		for(j=0;j<(uiLength*3);j++)
+		{
+			aucPayload[2+j] = aucPalette[(i*3)+j];
+		}
+		Sim_SPISend(aucFrame, Bench_BuildFrame(aucFrame, 0x96, aucPayload, (unsigned char)(2+(uiLength*3))));
+		processCommands(); // keeps the command queue from overflowing
+	}
+	aucUpload[0] = 0x87;
+	for(i=0;i<300;i++)
+	{
+		aucIndex[i] = (unsigned char)((i * 7) % PALETTE4_ENTRIES);
+		aucUpload[1+i] = aucIndex[i];
+	}
+	Sim_ClearStrip();
+	Sim_SPISend(aucUpload, 1+300);
+	Sim_SPISend(&ucLatch, 1);
+	processCommands();
+	Sim_RunRGBooster();
+	if(Bench_CheckPalette(300, aucPalette, aucIndex))
+	{
+		return 1;
+	}
+
+	aucPayload[0] = 5; // recolour: one palette entry and a latch
+	aucPayload[1] = 1;
+	aucPayload[2] = aucPalette[15] = 0x7F;
+	aucPayload[3] = aucPalette[16] = 0x00;
+	aucPayload[4] = aucPalette[17] = 0xC0;
+	uiRecolour = Bench_BuildFrame(aucFrame, 0x96, aucPayload, 5);
+	Sim_ClearStrip();
+	Sim_SPISend(aucFrame, uiRecolour);
+	Sim_SPISend(&ucLatch, 1);
+	uiRecolour++;
+	processCommands();
+	Sim_RunRGBooster();
+	if(Bench_CheckPalette(300, aucPalette, aucIndex))
+	{
+		printf("  FAIL: strip not recoloured by a palette entry\n");
+		return 1;
+	}
+
+	Sim_ClearStrip(); // palette entry sent while a frame is being sent
+	Sim_SPISend(&ucLatch, 1);
+	processCommands();
+	for(i=0;i<30;i++)
+	{
+		Sim_StepRGBooster();
+	}
+	aucPayload[2] = 0x10;
+	aucPayload[3] = 0x20;
+	aucPayload[4] = 0x30;
+	Sim_SPISend(aucFrame, Bench_BuildFrame(aucFrame, 0x96, aucPayload, 5));
+	processCommands();
+	Sim_RunRGBooster();
+	if(Bench_CheckPalette(300, aucPalette, aucIndex))
+	{
+		printf("  FAIL: palette changed during a transfer (torn frame)\n");
+		return 1;
+	}
+	aucPalette[15] = 0x10;
+	aucPalette[16] = 0x20;
+	aucPalette[17] = 0x30;
+	Sim_ClearStrip();
+	Sim_SPISend(&ucLatch, 1);
+	processCommands();
+	Sim_RunRGBooster();
+	if(Bench_CheckPalette(300, aucPalette, aucIndex))
+	{
+		printf("  FAIL: palette entry not written after the transfer\n");
+		return 1;
+	}
+
+	aucPayload[0] = 0x01; // LEDs 298 and 299: both nibbles of the last byte
+	aucPayload[1] = 0x2A;
+	aucPayload[2] = 2;
+	aucPayload[3] = aucIndex[298] = 9;
+	aucPayload[4] = aucIndex[299] = 14;
+	Sim_ClearStrip();
+	Sim_SPISend(aucFrame, Bench_BuildFrame(aucFrame, 0x97, aucPayload, 5));
+	Sim_SPISend(&ucLatch, 1);
+	processCommands();
+	Sim_RunRGBooster();
+	if(Bench_CheckPalette(300, aucPalette, aucIndex))
+	{
+		printf("  FAIL: indices of 0x97 not written\n");
+		return 1;
+	}
+
+	Sim_ClearStrip();
+	Bench_SetLayout(600, FORMAT_PAL8);
+	Sim_RunRGBooster();
+	if(Bench_CheckStrip(600, 0, 0, 0) || (Bench_ReadRegister(REG_FORMAT) != FORMAT_PAL8) || (Bench_ReadRegister(REG_STORAGE) != STORAGE_SINGLE))
+	{
+		printf("  FAIL: 600 LEDs not set up with FORMAT_PAL8\n");
+		return 1;
+	}
+	for(i=0;i<PALETTE8_SIZE;i++)
+	{
+		aucPalette[i] = (unsigned char)((i * 53) + 7);
+	}
+	for(i=0;i<PALETTE8_ENTRIES;i+=CMD_RANGE_MAX)
+	{
+		uiLength = ((PALETTE8_ENTRIES-i)<CMD_RANGE_MAX) ? (PALETTE8_ENTRIES-i) : CMD_RANGE_MAX;
+		aucPayload[0] = (unsigned char)i;
+		aucPayload[1] = (unsigned char)uiLength;
+		for(j=0;j<(uiLength*3);j++)
+		{
+			aucPayload[2+j] = aucPalette[(i*3)+j];
+		}
+		Sim_SPISend(aucFrame, Bench_BuildFrame(aucFrame, 0x96, aucPayload, (unsigned char)(2+(uiLength*3))));
+		processCommands(); // keeps the command queue from overflowing
+	}
+	for(i=0;i<600;i+=(CMD_PAYLOAD_SIZE-3))
+	{
+		uiLength = ((600-i)<(CMD_PAYLOAD_SIZE-3)) ? (600-i) : (CMD_PAYLOAD_SIZE-3);
+		aucPayload[0] = (unsigned char)(i >> 8);
+		aucPayload[1] = (unsigned char)i;
+		aucPayload[2] = (unsigned char)uiLength;
+		for(j=0;j<uiLength;j++)
+		{
+			aucIndex[i+j] = (unsigned char)(((i+j) * 13) % PALETTE8_ENTRIES);
+			aucPayload[3+j] = aucIndex[i+j];
+		}
+		Sim_SPISend(aucFrame, Bench_BuildFrame(aucFrame, 0x97, aucPayload, (unsigned char)(3+uiLength)));
+		processCommands(); // keeps the command queue from overflowing
+	}
+	Sim_ClearStrip();
+	Sim_SPISend(&ucLatch, 1);
+	processCommands();
+	Sim_RunRGBooster();
+	if(Bench_CheckPalette(600, aucPalette, aucIndex))
+	{
+		return 1;
+	}
+
+	Sim_Reset(); // reboot: format from the EEPROM
+	systemInit();
+	Sim_RunRGBooster();
+	Bench_SetLayout(LED_COUNT_MAX+1, FORMAT_PAL4);
+	Bench_SetLayout(LED_COUNT_MAX_PAL8+1, FORMAT_PAL8);
+	Bench_SetLayout(20, FORMATS);
+	if((Bench_ReadRegister(REG_FORMAT) != FORMAT_PAL8) || (Bench_ReadLength() != 600))
+	{
+		printf("  FAIL: format not restored after reboot or changed by an invalid layout\n");
+		return 1;
+	}
+	Bench_SetLayout(LED_COUNT_MAX, FORMAT_PAL4);
+	Sim_RunRGBooster();
+	if((Bench_ReadLength() != LED_COUNT_MAX) || (Bench_ReadRegister(REG_STORAGE) != STORAGE_SINGLE) ||
+		(Bench_ReadRegister(REG_MAX_SINGLE_HIGH) != (LED_COUNT_MAX >> 8)) || (Bench_ReadRegister(REG_MAX_SINGLE_LOW) != (LED_COUNT_MAX & 0xFF)))
+	{
+		printf("  FAIL: maximum length of FORMAT_PAL4 not accepted\n");
+		return 1;
+	}
+
+	Bench_SetLayout(LED_COUNT_DEFAULT, FORMAT_GRB);
+	Sim_RunRGBooster();
+	Bench_Boot();
+	if((Bench_ReadRegister(REG_FORMAT) != FORMAT_GRB) || (Bench_ReadLength() != LED_COUNT_DEFAULT))
+	{
+		printf("  FAIL: FORMAT_GRB not restored\n");
+		return 1;
+	}
+
+	printf("  %-44s 4bit 300 LEDs (legacy 0x87), 8bit 600 LEDs (0x97), kept over reboot\n", "palette formats");
+	printf("  %-44s %u SPI bytes (0x96 + 0x88), GRB upload + latch %u bytes\n", "recolour 300 LEDs",
+		uiRecolour, 1+(300*3)+1);
+	printf("  %-44s GRB %u, PAL8 %u, PAL4 %u LEDs (single buffer)\n", "maximum strip length per format",
+		LED_COUNT_MAX_GRB, LED_COUNT_MAX_PAL8, LED_COUNT_MAX);
+	return 0;
+}
+
+
+/** ***************************************************************************
+ * @brief Append a command to a scene upload
+ *
+ * @param [in,out] psStream: scene upload
+ * @param [in] pucData: command bytes
+ * @param [in] uiLength: amount of bytes
+ * @return no return value
+ *****************************************************************************/
+static void Bench_StreamAdd(BENCH_STREAM* psStream, const unsigned char* pucData, unsigned int uiLength)
+{
+	unsigned int i;
+	unsigned int uiStart = (psStream->uiParts) ? psStream->auiEnd[psStream->uiParts-1] : 0;
+
+	for(i=0;i<uiLength;i++)
+	{
+		psStream->aucData[uiStart+i] = pucData[i];
+	}
+	psStream->auiEnd[psStream->uiParts] = uiStart + uiLength;
+	psStream->uiParts++;
+}
+
+
+/** ***************************************************************************
+ * @brief Get the amount of SPI bytes of a scene upload
+ *
+ * @param [in] psStream: scene upload
+ * @return bytes
+ *****************************************************************************/
+static unsigned int Bench_StreamBytes(const BENCH_STREAM* psStream)
+{
+	return psStream->auiEnd[psStream->uiParts-1];
+}
+
+
+/** ***************************************************************************
+ * @brief Encode a scene for the three upload methods
+ *
+ * Every upload ends with the latch command 0x88.
+ * - legacy: [0x87, RR, GG, BB, ...] (7bit colors)
+ * - ranges: framed 0x95 with up to CMD_RANGE_MAX-1 LEDs each
+ * - runs: framed 0x98 with up to CMD_RLE_RUNS_MAX runs of up to 255 LEDs each
+ *
+ * @param [in] pucColors: red, green, blue per LED
+ * @param [out] psLegacy: legacy upload
+ * @param [out] psRanges: range upload
+ * @param [out] psRuns: run length encoded upload
+ * @return no return value
+ *****************************************************************************/
+static void Bench_EncodeScene(const unsigned char* pucColors, BENCH_STREAM* psLegacy, BENCH_STREAM* psRanges, BENCH_STREAM* psRuns)
+{
+	unsigned char aucPayload[CMD_PAYLOAD_SIZE];
+	unsigned char aucFrame[CMD_PAYLOAD_SIZE+4];
+	unsigned char ucLatch = 0x88;
+	unsigned int uiLength;
+	unsigned int uiRun;
+	unsigned int i;
+	unsigned int j;
+
+	psLegacy->uiParts = 0;
+	psRanges->uiParts = 0;
+	psRuns->uiParts = 0;
+
+	aucFrame[0] = 0x87;
+	Bench_StreamAdd(psLegacy, aucFrame, 1);
+	psLegacy->auiEnd[0] += BENCH_RLE_LEDS*3;
+	for(i=0;i<(BENCH_RLE_LEDS*3);i++)
+	{
+		psLegacy->aucData[1+i] = pucColors[i];
+	}
+
+	for(i=0;i<BENCH_RLE_LEDS;i+=uiLength)
+	{
+		uiLength = ((BENCH_RLE_LEDS-i)<(CMD_RANGE_MAX-1)) ? (BENCH_RLE_LEDS-i) : (CMD_RANGE_MAX-1);
+		aucPayload[0] = (unsigned char)(i >> 8);
+		aucPayload[1] = (unsigned char)i;
+		aucPayload[2] = (unsigned char)uiLength;
+		for(j=0;j<(uiLength*3);j++)
+		{
+			aucPayload[3+j] = pucColors[(i*3)+j];
+		}
+		Bench_StreamAdd(psRanges, aucFrame, Bench_BuildFrame(aucFrame, 0x95, aucPayload, (unsigned char)(3+(uiLength*3))));
+	}
+
+	i = 0;
+	while(i<BENCH_RLE_LEDS)
+	{
+		aucPayload[0] = (unsigned char)(i >> 8);
+		aucPayload[1] = (unsigned char)i;
+		uiLength = 2;
+		while((i<BENCH_RLE_LEDS) && (uiLength<(2+(CMD_RLE_RUNS_MAX*4))))
+		{
+			for(uiRun=1;((i+uiRun)<BENCH_RLE_LEDS) && (uiRun<255);uiRun++)
+			{
+				if((pucColors[((i+uiRun)*3)+0] != pucColors[(i*3)+0]) || (pucColors[((i+uiRun)*3)+1] != pucColors[(i*3)+1]) ||
+					(pucColors[((i+uiRun)*3)+2] != pucColors[(i*3)+2]))
+				{
+					break;
+				}
+			}
+			aucPayload[uiLength+0] = (unsigned char)uiRun;
+			aucPayload[uiLength+1] = pucColors[(i*3)+0];
+			aucPayload[uiLength+2] = pucColors[(i*3)+1];
+			aucPayload[uiLength+3] = pucColors[(i*3)+2];
+			uiLength += 4;
+			i += uiRun;
+		}
+		Bench_StreamAdd(psRuns, aucFrame, Bench_BuildFrame(aucFrame, 0x98, aucPayload, (unsigned char)uiLength));
+	}
+
+	Bench_StreamAdd(psLegacy, &ucLatch, 1);
+	Bench_StreamAdd(psRanges, &ucLatch, 1);
+	Bench_StreamAdd(psRuns, &ucLatch, 1);
+}
+
+
+/** ***************************************************************************
+ * @brief Upload a scene repeatedly and check the strip
+ *
+ * The main loop runs after every command, like the RPi pacing the commands
+ * with STATUS_BUSY. Only receiving and decoding is measured, not the
+ * transfer to the strip.
+ *
+ * @param [in] psStream: scene upload
+ * @param [in] pucColors: expected red, green, blue per LED
+ * @return host cycles per scene, 0 if the strip was wrong
+ *****************************************************************************/
+static double Bench_RunScene(const BENCH_STREAM* psStream, const unsigned char* pucColors)
+{
+	unsigned int n;
+	unsigned int i;
+	unsigned int uiStart;
+	uint64_t ullStart;
+	uint64_t ullTotal = 0;
+
+	for(n=0;n<BENCH_RLE_FRAMES;n++)
+	{
+		uiStart = 0;
+		Sim_ClearStrip();
+		ullStart = Bench_Cycles();
+		for(i=0;i<psStream->uiParts;i++)
+		{
+			Sim_SPISend(&psStream->aucData[uiStart], psStream->auiEnd[i] - uiStart);
+			processCommands();
+			uiStart = psStream->auiEnd[i];
+		}
+		ullTotal += Bench_Cycles() - ullStart;
+		Sim_RunRGBooster();
+		for(i=0;i<BENCH_RLE_LEDS;i++)
+		{
+			if((sSim.aucStrip[(i*3)+0] != pucColors[(i*3)+1]) || (sSim.aucStrip[(i*3)+1] != pucColors[(i*3)+0]) || (sSim.aucStrip[(i*3)+2] != pucColors[(i*3)+2]))
+			{
+				printf("  FAIL: wrong color on LED %u after a scene upload\n", i);
+				return 0;
+			}
+		}
+		if(sSim.uiStripCount != (BENCH_RLE_LEDS*3))
+		{
+			printf("  FAIL: %u bytes sent to the RGBooster, expected %u\n", sSim.uiStripCount, BENCH_RLE_LEDS*3);
+			return 0;
+		}
+	}
+	return (double)ullTotal / BENCH_RLE_FRAMES;
+}
+
+
+/** ***************************************************************************
+ * @brief Compare run length encoded scenes with the raw uploads
+ *
+ * Scenes: one color, two halves of different colors and a gradient with a
+ * different color on every LED (the worst case of the run length encoding).
+ * The colors are 7bit so that the legacy 0x87 can carry them too.
+ *
+ * @param [void] no input
+ * @return 0 if all scenes were shown correctly
+ *****************************************************************************/
+static int Bench_RunLength(void)
+{
+	static BENCH_STREAM sLegacy;
+	static BENCH_STREAM sRanges;
+	static BENCH_STREAM sRuns;
+	static const char* apcScene[3] = {"solid", "two-tone", "gradient"};
+	unsigned char aucColors[BENCH_RLE_LEDS*3];
+	char acName[48];
+	double dLegacy;
+	double dRanges;
+	double dRuns;
+	unsigned int uiScene;
+	unsigned int i;
+
+	Bench_Boot();
+	Bench_SetLength(BENCH_RLE_LEDS);
+	Sim_RunRGBooster();
+	printf("  %-44s %7s %7s %7s   (SPI bytes, host cycles to receive and decode)\n", "scene upload", "0x87", "0x95", "0x98");
+	for(uiScene=0;uiScene<3;uiScene++)
+	{
+		for(i=0;i<BENCH_RLE_LEDS;i++)
+		{
+			switch(uiScene)
+			{
+				case 0:
+				aucColors[(i*3)+0] = 0x40;
+				aucColors[(i*3)+1] = 0x18;
+				aucColors[(i*3)+2] = 0x05;
+				break;
+
+				case 1:
+				aucColors[(i*3)+0] = (i<(BENCH_RLE_LEDS/2)) ? 0x7F : 0x00;
+				aucColors[(i*3)+1] = (i<(BENCH_RLE_LEDS/2)) ? 0x30 : 0x10;
+				aucColors[(i*3)+2] = (i<(BENCH_RLE_LEDS/2)) ? 0x00 : 0x7F;
+				break;
+
+				default:
+				aucColors[(i*3)+0] = (unsigned char)(i & 0x7F);
+				aucColors[(i*3)+1] = (unsigned char)((i*2) & 0x7F);
+				aucColors[(i*3)+2] = (unsigned char)(0x7F - (i & 0x7F));
+				break;
+			}
+		}
+		Bench_EncodeScene(aucColors, &sLegacy, &sRanges, &sRuns);
+		dLegacy = Bench_RunScene(&sLegacy, aucColors);
+		dRanges = Bench_RunScene(&sRanges, aucColors);
+		dRuns = Bench_RunScene(&sRuns, aucColors);
+		if((dLegacy==0) || (dRanges==0) || (dRuns==0))
+		{
+			return 1;
+		}
+		snprintf(acName, sizeof(acName), "%s (%u LEDs)", apcScene[uiScene], BENCH_RLE_LEDS);
+		printf("  %-44s %7u %7u %7u B\n", acName, Bench_StreamBytes(&sLegacy), Bench_StreamBytes(&sRanges), Bench_StreamBytes(&sRuns));
+		printf("  %-44s %7.0f %7.0f %7.0f cycles\n", "", dLegacy, dRanges, dRuns);
+	}
+
+	Bench_SetLength(LED_COUNT_DEFAULT);
+	Sim_RunRGBooster();
+	Bench_Boot();
+	return 0;
+}
+
+
+/** ***************************************************************************
+ * @brief Start an effect with the framed 0x99
+ *
+ * @param [in] ucEffect: effect (EFFECT_*)
+ * @param [in] ucSpeed: speed
+ * @param [in] ucDensity: density
+ * @param [in] pucColor: foreground color (red, green, blue)
+ * @param [in] pucBackground: background color (red, green, blue)
+ * @return no return value
+ *****************************************************************************/
+static void Bench_StartEffect(unsigned char ucEffect, unsigned char ucSpeed, unsigned char ucDensity, const unsigned char* pucColor, const unsigned char* pucBackground)
+{
+	unsigned char aucPayload[EFFECT_PAYLOAD_SIZE];
+	unsigned char aucFrame[4+EFFECT_PAYLOAD_SIZE];
+	unsigned char i;
+
+	aucPayload[0] = ucEffect;
+	aucPayload[1] = ucSpeed;
+	aucPayload[2] = ucDensity;
+	for(i=0;i<3;i++)
+	{
+		aucPayload[3+i] = pucColor[i];
+		aucPayload[6+i] = pucBackground[i];
+	}
+	Sim_SPISend(aucFrame, Bench_BuildFrame(aucFrame, 0x99, aucPayload, EFFECT_PAYLOAD_SIZE));
+	processCommands();
+}
+
+
+/** ***************************************************************************
+ * @brief Check if a LED of the sent frame has a color
+ *
+ * @param [in] uiLED: LED
+ * @param [in] pucColor: color (red, green, blue)
+ * @return 1 if the LED has the color
+ *****************************************************************************/
+static int Bench_IsColor(unsigned int uiLED, const unsigned char* pucColor)
+{
+	const unsigned char* pucLED = &sSim.aucStrip[uiLED*3];
+
+	return (pucLED[1]==pucColor[0]) && (pucLED[0]==pucColor[1]) && (pucLED[2]==pucColor[2]);
+}
+
+
+/** ***************************************************************************
+ * @brief Run the effects task and check the sent frames of an effect
+ *
+ * The ticks are advanced one by one. The frames have to follow each other
+ * every TASK_PERIOD_EFFECTS, cover the strip and match the pattern of the
+ * effect:
+ * - rainbow: fully saturated colors (one channel 255, one 0), the first LED
+ *   changes from frame to frame
+ * - chase: every ucDensity-th LED in the foreground color starting at a
+ *   position that advances by one LED per frame (speed 16)
+ * - breathe: the whole strip in one color, the background and the
+ *   foreground color are both reached
+ * - twinkle: every frame has LEDs lighting up in the foreground color
+ *
+ * @param [in] ucEffect: running effect
+ * @param [in] ucDensity: density of the running effect
+ * @param [in] pucColor: foreground color (red, green, blue)
+ * @param [in] pucBackground: background color (red, green, blue)
+ * @param [in,out] psStat: statistics of Scheduler_Run() with a rendered frame
+ * @return amount of frames, 0 if a frame was wrong
+ *****************************************************************************/
+static unsigned int Bench_RunEffect(unsigned char ucEffect, unsigned char ucDensity, const unsigned char* pucColor, const unsigned char* pucBackground, BENCH_STAT* psStat)
+{
+	unsigned int uiTick;
+	unsigned int uiLastTick = 0;
+	unsigned int uiFrames = 0;
+	unsigned int uiLit;
+	unsigned int i;
+	unsigned char ucFirst = 0;
+	unsigned char ucLow;
+	unsigned char ucHigh;
+	unsigned char ucBackground = 0;
+	unsigned char ucForeground = 0;
+	unsigned char ucPrevious[3] = {0, 0, 0};
+	uint64_t ullStart;
+
+	for(uiTick=0;uiTick<BENCH_EFFECT_TICKS;uiTick++)
+	{
+		Sim_ClearStrip();
+		Sim_RunTicks(1);
+		ullStart = Bench_Cycles();
+		Scheduler_Run();
+		if(!sSim.uiStripCount)
+		{
+			continue;
+		}
+		Bench_Add(psStat, ullStart, Bench_Cycles());
+		Sim_RunRGBooster();
+		if((uiFrames>1) && ((uiTick - uiLastTick)!=TASK_PERIOD_EFFECTS)) // the first period of a new task may be shorter
+		{
+			printf("  FAIL: effect %u frame after %u ms\n", ucEffect, uiTick - uiLastTick);
+			return 0;
+		}
+		uiLastTick = uiTick;
+		if(sSim.uiStripCount!=(BENCH_EFFECT_LEDS*3))
+		{
+			printf("  FAIL: effect %u frame of %u bytes\n", ucEffect, sSim.uiStripCount);
+			return 0;
+		}
+
+		uiLit = 0;
+		for(i=0;i<BENCH_EFFECT_LEDS;i++)
+		{
+			ucLow = sSim.aucStrip[i*3];
+			ucHigh = sSim.aucStrip[i*3];
+			ucLow = (sSim.aucStrip[(i*3)+1]<ucLow) ? sSim.aucStrip[(i*3)+1] : ucLow;
+			ucLow = (sSim.aucStrip[(i*3)+2]<ucLow) ? sSim.aucStrip[(i*3)+2] : ucLow;
+			ucHigh = (sSim.aucStrip[(i*3)+1]>ucHigh) ? sSim.aucStrip[(i*3)+1] : ucHigh;
+			ucHigh = (sSim.aucStrip[(i*3)+2]>ucHigh) ? sSim.aucStrip[(i*3)+2] : ucHigh;
+			if(((ucEffect==EFFECT_RAINBOW) && ((ucLow!=0) || (ucHigh!=255))) ||
+				((ucEffect==EFFECT_CHASE) && (Bench_IsColor(i, pucColor)!=((i % ucDensity)==ucFirst))) ||
+				((ucEffect==EFFECT_BREATHE) && ((sSim.aucStrip[i*3]!=sSim.aucStrip[0]) || (sSim.aucStrip[(i*3)+1]!=sSim.aucStrip[1]) || (sSim.aucStrip[(i*3)+2]!=sSim.aucStrip[2]))))
+			{
+				printf("  FAIL: effect %u frame %u LED %u: %02X %02X %02X\n", ucEffect, uiFrames, i,
+					sSim.aucStrip[(i*3)+1], sSim.aucStrip[i*3], sSim.aucStrip[(i*3)+2]);
+				return 0;
+			}
+			uiLit += (unsigned int)Bench_IsColor(i, pucColor);
+		}
+
+		if((ucEffect==EFFECT_RAINBOW) && (uiFrames) && (sSim.aucStrip[0]==ucPrevious[0]) && (sSim.aucStrip[1]==ucPrevious[1]) && (sSim.aucStrip[2]==ucPrevious[2]))
+		{
+			printf("  FAIL: rainbow does not move (frame %u)\n", uiFrames);
+			return 0;
+		}
+		if((ucEffect==EFFECT_TWINKLE) && (ucDensity) && (!uiLit))
+		{
+			printf("  FAIL: twinkle frame %u without lit LEDs\n", uiFrames);
+			return 0;
+		}
+		ucBackground |= Bench_IsColor(0, pucBackground);
+		ucForeground |= Bench_IsColor(0, pucColor);
+		for(i=0;i<3;i++)
+		{
+			ucPrevious[i] = sSim.aucStrip[i];
+		}
+		ucFirst = (unsigned char)((ucFirst + 1) % ((ucDensity) ? ucDensity : 1));
+		uiFrames++;
+	}
+
+	if((ucEffect==EFFECT_BREATHE) && ((!ucBackground) || (!ucForeground)))
+	{
+		printf("  FAIL: breathe reached background %u foreground %u\n", ucBackground, ucForeground);
+		return 0;
+	}
+	return uiFrames;
+}
+
+
+/** ***************************************************************************
+ * @brief Check and measure the effects engine
+ *
+ * Every effect is started with one framed 0x99 and has to be rendered with
+ * a frame every TASK_PERIOD_EFFECTS. Twinkle with density 0
+ * has to fade to the background. 0x9A and the legacy 0x84 stop the effect,
+ * the status bit follows.
+ *
+ * @param [void] no input
+ * @return 0 if all frames were correct
+ *****************************************************************************/
+static int Bench_Effects(void)
+{
+	BENCH_STAT asStep[EFFECTS] =
+	{
+		{"Scheduler_Run() with a rainbow frame", 0, 0, 0},
+		{"Scheduler_Run() with a chase frame", 0, 0, 0},
+		{"Scheduler_Run() with a breathe frame", 0, 0, 0},
+		{"Scheduler_Run() with a twinkle frame", 0, 0, 0}
+	};
+	const unsigned char aucColor[3] = {0xFF, 0x80, 0x00};
+	const unsigned char aucBackground[3] = {0x00, 0x00, 0x20};
+	const unsigned char aucDensity[EFFECTS] = {8, 5, 0, 40};
+	const unsigned char aucSpeed[EFFECTS] = {16, 16, 255, 64};
+	unsigned char aucStop[4];
+	unsigned char aucSingle[4] = {0x84, 0x10, 0x20, 0x30};
+	unsigned char aucSingleColor[3] = {0x10, 0x20, 0x30};
+	unsigned char ucEffect;
+	unsigned int uiFrames;
+	int iResult = 0;
+
+	Bench_Boot();
+	Bench_SetLength(BENCH_EFFECT_LEDS);
+	Sim_RunRGBooster();
+	initTasks();
+
+	for(ucEffect=0;ucEffect<EFFECTS;ucEffect++)
+	{
+		Bench_StartEffect(ucEffect, aucSpeed[ucEffect], aucDensity[ucEffect], aucColor, aucBackground);
+		uiFrames = Bench_RunEffect(ucEffect, aucDensity[ucEffect], aucColor, aucBackground, &asStep[ucEffect]);
+		if(uiFrames<(BENCH_EFFECT_TICKS/TASK_PERIOD_EFFECTS))
+		{
+			printf("  FAIL: effect %u sent %u frames in %u ms\n", ucEffect, uiFrames, BENCH_EFFECT_TICKS);
+			iResult = 1;
+		}
+	}
+
+	Bench_StartEffect(EFFECT_TWINKLE, 64, 0, aucColor, aucBackground); // nothing lights up anymore
+	Bench_RunEffect(EFFECT_TWINKLE, 0, aucColor, aucBackground, &asStep[EFFECT_TWINKLE]);
+	if((!Bench_IsColor(0, aucBackground)) || (!Bench_IsColor(BENCH_EFFECT_LEDS-1, aucBackground)))
+	{
+		printf("  FAIL: twinkle did not fade to the background\n");
+		iResult = 1;
+	}
+
+	Sim_SPITransfer(0x8F);
+	if(!(Sim_SPITransfer(0x00) & (1<<STATUS_EFFECT)))
+	{
+		printf("  FAIL: STATUS_EFFECT not set\n");
+		iResult = 1;
+	}
+	Sim_SPISend(aucStop, Bench_BuildFrame(aucStop, 0x9A, 0, 0));
+	processCommands();
+	Sim_ClearStrip();
+	Sim_RunTicks(2*TASK_PERIOD_EFFECTS);
+	Scheduler_Run();
+	Sim_SPITransfer(0x8F);
+	if((sSim.uiStripCount) || (Sim_SPITransfer(0x00) & (1<<STATUS_EFFECT)))
+	{
+		printf("  FAIL: effect not stopped by 0x9A\n");
+		iResult = 1;
+	}
+
+	Bench_StartEffect(EFFECT_RAINBOW, 16, 8, aucColor, aucBackground);
+	Sim_SPISend(aucSingle, sizeof(aucSingle));
+	processCommands();
+	Sim_RunRGBooster();
+	Sim_ClearStrip();
+	Sim_RunTicks(2*TASK_PERIOD_EFFECTS);
+	Scheduler_Run();
+	Sim_RunRGBooster();
+	if((Effect_IsRunning()) || ((sSim.uiStripCount) && (!Bench_IsColor(0, aucSingleColor))))
+	{
+		printf("  FAIL: effect not stopped by 0x84\n");
+		iResult = 1;
+	}
+
+	for(ucEffect=0;ucEffect<EFFECTS;ucEffect++)
+	{
+		Bench_Print(&asStep[ucEffect]);
+	}
+	printf("  %-44s %u SPI bytes instead of %u (legacy 0x87 + latch per frame)\n", "1s of animation",
+		4 + EFFECT_PAYLOAD_SIZE, (1000/TASK_PERIOD_EFFECTS) * (1 + (BENCH_EFFECT_LEDS*3) + 1));
+
+	Effect_Stop();
+	Bench_SetLength(LED_COUNT_DEFAULT);
+	Sim_RunRGBooster();
+	Bench_Boot();
+	return iResult;
+}
+
+
+/** ***************************************************************************
+ * @brief Floating point reference of Color_HSV()
+ *
+ * @param [in] ucHue: hue [0-255]
+ * @param [in] ucSaturation: saturation [0-255]
+ * @param [in] ucValue: value [0-255]
+ * @param [out] pdColor: color (red, green, blue) [0-255]
+ * @return no return value
+ *****************************************************************************/
+static void Bench_ReferenceHSV(unsigned char ucHue, unsigned char ucSaturation, unsigned char ucValue, double* pdColor)
+{
+	double dSector = (ucHue * 6.0) / 256.0;
+	double dRamp = dSector - (int)dSector;
+	double adFull[3];
+	unsigned char i;
+	const double adRise[6][3] = {{1, 0, 0}, {0, 1, 0}, {0, 1, 0}, {0, 0, 1}, {0, 0, 1}, {1, 0, 0}};	// channel at 255
+	const signed char acRamp[6][3] = {{0, 1, 0}, {-1, 0, 0}, {0, 0, 1}, {0, -1, 0}, {1, 0, 0}, {0, 0, -1}};	// rising or falling channel
+	unsigned int uiSector = (unsigned int)dSector;
+
+	for(i=0;i<3;i++)
+	{
+		adFull[i] = adRise[uiSector][i];
+		if(acRamp[uiSector][i]>0)
+		{
+			adFull[i] = dRamp;
+		}
+		else if(acRamp[uiSector][i]<0)
+		{
+			adFull[i] = 1.0 - dRamp;
+		}
+	}
+	for(i=0;i<3;i++)
+	{
+		pdColor[i] = ucValue * (1.0 - ((ucSaturation / 255.0) * (1.0 - adFull[i])));
+	}
+}
+
+
+/** ***************************************************************************
+ * @brief Check and measure the integer color conversions
+ *
+ * Color_HSV() has to stay within 2 of the floating point reference for all
+ * hues. Color_Kelvin() has to be white
+ * at 6600K, limited outside of the table, lose red and gain blue with rising
+ * temperature. The framed 0x9B and 0x9C have to fill the strip like 0x84.
+ *
+ * @param [void] no input
+ * @return 0 if all conversions were correct
+ *****************************************************************************/
+static int Bench_Color(void)
+{
+	BENCH_STAT sHSV = {"Color_HSV()", 0, 0, 0};
+	BENCH_STAT sKelvin = {"Color_Kelvin()", 0, 0, 0};
+	const unsigned char aucSaturation[4] = {0, 64, 200, 255};
+	const unsigned char aucValue[3] = {0, 100, 255};
+	unsigned char aucColor[3];
+	unsigned char aucLast[3] = {255, 0, 0};
+	unsigned char aucPayload[4];
+	unsigned char aucFrame[8];
+	double adReference[3];
+	double dError;
+	double dMaxError = 0;
+	unsigned int uiHue;
+	unsigned int uiKelvin;
+	unsigned char ucSaturation;
+	unsigned char ucValue;
+	unsigned char i;
+	uint64_t ullStart;
+	int iResult = 0;
+
+	for(uiHue=0;uiHue<256;uiHue++)
+	{
+		for(ucSaturation=0;ucSaturation<4;ucSaturation++)
+		{
+			for(ucValue=0;ucValue<3;ucValue++)
+			{
+				ullStart = Bench_Cycles();
+				Color_HSV((unsigned char)uiHue, aucSaturation[ucSaturation], aucValue[ucValue], aucColor);
+				Bench_Add(&sHSV, ullStart, Bench_Cycles());
+				Bench_ReferenceHSV((unsigned char)uiHue, aucSaturation[ucSaturation], aucValue[ucValue], adReference);
+				for(i=0;i<3;i++)
+				{
+					dError = (aucColor[i]>adReference[i]) ? (aucColor[i] - adReference[i]) : (adReference[i] - aucColor[i]);
+					dMaxError = (dError>dMaxError) ? dError : dMaxError;
+				}
+			}
+		}
+	}
+	if(dMaxError>2.0)
+	{
+		printf("  FAIL: Color_HSV() error %.2f\n", dMaxError);
+		iResult = 1;
+	}
+	if((Color_Degree(0)!=0) || (Color_Degree(120)!=85) || (Color_Degree(180)!=128) || (Color_Degree(359)!=255) || (Color_Degree(360)!=0) || (Color_Degree(480)!=85))
+	{
+		printf("  FAIL: Color_Degree() %u %u %u\n", Color_Degree(120), Color_Degree(359), Color_Degree(480));
+		iResult = 1;
+	}
+
+	for(uiKelvin=COLOR_KELVIN_MIN;uiKelvin<=COLOR_KELVIN_MAX;uiKelvin+=10)
+	{
+		ullStart = Bench_Cycles();
+		Color_Kelvin(uiKelvin, 255, aucColor);
+		Bench_Add(&sKelvin, ullStart, Bench_Cycles());
+		if((aucColor[0]>aucLast[0]) || (aucColor[2]<aucLast[2]))
+		{
+			printf("  FAIL: Color_Kelvin(%u) %u %u %u\n", uiKelvin, aucColor[0], aucColor[1], aucColor[2]);
+			iResult = 1;
+			break;
+		}
+		for(i=0;i<3;i++)
+		{
+			aucLast[i] = aucColor[i];
+		}
+	}
+	Color_Kelvin(6600, 255, aucColor);
+	if((aucColor[0]!=255) || (aucColor[1]!=255) || (aucColor[2]!=255))
+	{
+		printf("  FAIL: Color_Kelvin(6600) %u %u %u\n", aucColor[0], aucColor[1], aucColor[2]);
+		iResult = 1;
+	}
+	Color_Kelvin(500, 255, aucColor);
+	Color_Kelvin(COLOR_KELVIN_MIN, 255, aucLast);
+	if((aucColor[0]!=aucLast[0]) || (aucColor[1]!=aucLast[1]) || (aucColor[2]!=aucLast[2]) || (aucColor[2]!=0))
+	{
+		printf("  FAIL: Color_Kelvin(500) %u %u %u\n", aucColor[0], aucColor[1], aucColor[2]);
+		iResult = 1;
+	}
+	Color_Kelvin(40000, 255, aucColor);
+	Color_Kelvin(COLOR_KELVIN_MAX, 255, aucLast);
+	if((aucColor[0]!=aucLast[0]) || (aucColor[1]!=aucLast[1]) || (aucColor[2]!=aucLast[2]) || (aucColor[2]!=255))
+	{
+		printf("  FAIL: Color_Kelvin(40000) %u %u %u\n", aucColor[0], aucColor[1], aucColor[2]);
+		iResult = 1;
+	}
+	Color_Kelvin(3000, 0, aucColor);
+	if(aucColor[0] || aucColor[1] || aucColor[2])
+	{
+		printf("  FAIL: Color_Kelvin() brightness 0\n");
+		iResult = 1;
+	}
+
+	Bench_Boot();
+	aucPayload[0] = 0x01; // 300 degree: magenta
+	aucPayload[1] = 0x2C;
+	aucPayload[2] = 255;
+	aucPayload[3] = 128;
+	Sim_SPISend(aucFrame, Bench_BuildFrame(aucFrame, 0x9B, aucPayload, 4));
+	processCommands();
+	Sim_RunRGBooster();
+	Color_HSV(Color_Degree(300), 255, 128, aucColor);
+	if(Bench_CheckStrip(LED_COUNT_DEFAULT, aucColor[0], aucColor[1], aucColor[2]))
+	{
+		printf("  FAIL: 0x9B [HH, HL, SS, VV]\n");
+		iResult = 1;
+	}
+	Sim_ClearStrip();
+	aucPayload[0] = 0; // red
+	aucPayload[1] = 255;
+	aucPayload[2] = 255;
+	Sim_SPISend(aucFrame, Bench_BuildFrame(aucFrame, 0x9B, aucPayload, 3));
+	processCommands();
+	Sim_RunRGBooster();
+	if(Bench_CheckStrip(LED_COUNT_DEFAULT, 255, 0, 0))
+	{
+		printf("  FAIL: 0x9B [HH, SS, VV]\n");
+		iResult = 1;
+	}
+	Sim_ClearStrip();
+	aucPayload[0] = (unsigned char)(6600 >> 8);
+	aucPayload[1] = (unsigned char)6600;
+	aucPayload[2] = 255;
+	Sim_SPISend(aucFrame, Bench_BuildFrame(aucFrame, 0x9C, aucPayload, 3));
+	processCommands();
+	Sim_RunRGBooster();
+	if(Bench_CheckStrip(LED_COUNT_DEFAULT, 255, 255, 255))
+	{
+		printf("  FAIL: 0x9C [KH, KL, BB]\n");
+		iResult = 1;
+	}
+	Sim_ClearStrip();
+
+	Bench_Print(&sHSV);
+	Bench_Print(&sKelvin);
+	printf("  %-44s %.2f (max. deviation from floating point)\n", "Color_HSV() error", dMaxError);
+	Bench_Boot();
+	return iResult;
+}
+
+
+/** ***************************************************************************
+ * @brief Send a frame of the framed protocol and execute it
+ *
+ * A scene save (0x9D) is driven to its end by further command ticks.
+ *
+ * @param [in] ucOpcode: opcode
+ * @param [in] pucPayload: payload
+ * @param [in] ucLength: amount of payload bytes
+ * @return status register after the command
+ *****************************************************************************/
+static unsigned char Bench_SceneCommand(unsigned char ucOpcode, const unsigned char* pucPayload, unsigned char ucLength)
+{
+	unsigned char aucFrame[4+CMD_PAYLOAD_SIZE];
+
+	Sim_SPISend(aucFrame, Bench_BuildFrame(aucFrame, ucOpcode, pucPayload, ucLength));
+	processCommands();
+	while(Scene_IsSaving())
+	{
+		processCommands();
+	}
+	Sim_SPITransfer(0x8F);
+	return Sim_SPITransfer(0x00);
+}
+
+
+/** ***************************************************************************
+ * @brief Check that the sent frame shows the runs of the scene
+ *
+ * LEDs [0-49] red, [50-99] green, [100-BENCH_EFFECT_LEDS-1] blue.
+ *
+ * @param [void] no input
+ * @return 0 if the frame is correct
+ *****************************************************************************/
+static int Bench_CheckScene(void)
+{
+	const unsigned char aucRed[3] = {0x60, 0x00, 0x00};
+	const unsigned char aucGreen[3] = {0x00, 0x60, 0x00};
+	const unsigned char aucBlue[3] = {0x00, 0x00, 0x60};
+	unsigned int i;
+
+	if(sSim.uiStripCount!=(BENCH_EFFECT_LEDS*3))
+	{
+		printf("  FAIL: scene frame of %u bytes\n", sSim.uiStripCount);
+		return 1;
+	}
+	for(i=0;i<BENCH_EFFECT_LEDS;i++)
+	{
+		if(!Bench_IsColor(i, (i<50) ? aucRed : ((i<100) ? aucGreen : aucBlue)))
+		{
+			printf("  FAIL: scene LED %u: %02X %02X %02X\n", i, sSim.aucStrip[(i*3)+1], sSim.aucStrip[i*3], sSim.aucStrip[(i*3)+2]);
+			return 1;
+		}
+	}
+	return 0;
+}
+
+
+/** ***************************************************************************
+ * @brief Check the scene store
+ *
+ * Scene 1: three runs, power LED on at 40%, a clear sent during the save
+ * has to wait for it, saving it again unchanged must not write the slot.
+ * Scene 2: a rendered chase effect (saved without runs). The save is counted in
+ * command ticks, the boot restore in ticks after systemInit() until the
+ * first byte of the restored frame is sent.
+ *
+ * @param [void] no input
+ * @return 0 if all scenes were correct
+ *****************************************************************************/
+static int Bench_Scene(void)
+{
+	const unsigned char aucRuns[2+12] = {0, 0, 50, 0x60, 0x00, 0x00, 50, 0x00, 0x60, 0x00, BENCH_EFFECT_LEDS-100, 0x00, 0x00, 0x60};
+	const unsigned char aucColor[3] = {0xFF, 0x80, 0x00};
+	const unsigned char aucBackground[3] = {0x00, 0x00, 0x20};
+	unsigned char aucRange[3+(CMD_RANGE_MAX-1)*3];
+	unsigned char aucCommand[2];
+	unsigned char aucFrame[4+1];
+	SCENE sScene;
+	unsigned char ucSlot;
+	unsigned char ucStatus;
+	unsigned int uiSave;
+	unsigned int uiTicks;
+	unsigned long ulWrites;
+	unsigned int i;
+	int iResult = 0;
+
+	Bench_Boot();
+	Bench_SetLength(BENCH_EFFECT_LEDS);
+	Sim_RunRGBooster();
+	Sim_ClearStrip();
+	initTasks();
+
+	Bench_SceneCommand(0x98, aucRuns, sizeof(aucRuns));
+	Bench_SceneCommand(0x88, 0, 0);
+	Sim_RunRGBooster();
+	Sim_ClearStrip();
+	aucCommand[0] = 0x82;
+	aucCommand[1] = 40;
+	Sim_SPITransfer(0x80);
+	Sim_SPISend(aucCommand, 2);
+	ucSlot = 1;
+	Sim_SPISend(aucFrame, Bench_BuildFrame(aucFrame, 0x9D, &ucSlot, 1));
+	processCommands();
+	Sim_SPISend(aucFrame, Bench_BuildFrame(aucFrame, 0x83, 0, 0)); // has to wait for the save
+	Sim_SPITransfer(0x8F);
+	ucStatus = Sim_SPITransfer(0x00);
+	for(uiSave=1;(Scene_IsSaving()) && (uiSave<1000);uiSave++)
+	{
+		processCommands();
+		Sim_RunRGBooster();
+		if(sSim.uiStripCount)
+		{
+			printf("  FAIL: frame sent during the save\n");
+			iResult = 1;
+			break;
+		}
+	}
+	if((!(ucStatus & (1<<STATUS_SAVING))) || (ucStatus & (1<<STATUS_DROPPED)) || (Scene_IsSaving()) ||
+		(Bench_ReadRegister(REG_SCENE)!=1))
+	{
+		printf("  FAIL: scene 1 not saved (status %02X)\n", ucStatus);
+		iResult = 1;
+	}
+
+	Bench_SceneCommand(0x83, 0, 0); // dark, power LED off
+	Sim_SPITransfer(0x81);
+	aucCommand[1] = 0;
+	Sim_SPISend(aucCommand, 2);
+	Sim_RunRGBooster();
+	Sim_ClearStrip();
+	Bench_SceneCommand(0x9E, &ucSlot, 1);
+	Sim_RunRGBooster();
+	Sim_SPITransfer(0x8D);
+	if((Bench_CheckScene()) || (Sim_SPITransfer(0x00)!=40) || (PORT_PLED & (1<<PLED_DISABLE)))
+	{
+		printf("  FAIL: scene 1 not recalled\n");
+		iResult = 1;
+	}
+	Sim_ClearStrip();
+	ulWrites = ulSimEEPROMWrites;
+	if((Bench_SceneCommand(0x9D, &ucSlot, 1) & (1<<STATUS_DROPPED)) || (ulSimEEPROMWrites!=ulWrites))
+	{
+		printf("  FAIL: unchanged scene 1 saved with %lu EEPROM writes\n", ulSimEEPROMWrites-ulWrites);
+		iResult = 1;
+	}
+
+	Bench_StartEffect(EFFECT_CHASE, 16, 5, aucColor, aucBackground);
+	updateEffects(); // rendered chase: more than SCENE_RUNS_MAX runs
+	Sim_RunRGBooster();
+	Sim_ClearStrip();
+	ucSlot = 2;
+	if((Bench_SceneCommand(0x9D, &ucSlot, 1) & (1<<STATUS_DROPPED)) || (!Scene_Read(ucSlot, &sScene)) || (sScene.ucRuns!=0))
+	{
+		printf("  FAIL: scene 2 with a running effect not saved without runs\n");
+		iResult = 1;
+	}
+	Bench_SceneCommand(0x9A, 0, 0);
+	Bench_SceneCommand(0x9E, &ucSlot, 1);
+	Sim_RunRGBooster();
+	Sim_ClearStrip();
+	if(!Effect_IsRunning())
+	{
+		printf("  FAIL: effect of scene 2 not recalled\n");
+		iResult = 1;
+	}
+	Bench_SceneCommand(0x9A, 0, 0);
+
+	aucRange[2] = CMD_RANGE_MAX-1; // gradient: more than SCENE_RUNS_MAX runs
+	for(i=0;i<BENCH_EFFECT_LEDS;i+=(CMD_RANGE_MAX-1))
+	{
+		aucRange[0] = (unsigned char)(i >> 8);
+		aucRange[1] = (unsigned char)i;
+		for(uiTicks=0;uiTicks<((CMD_RANGE_MAX-1)*3);uiTicks++)
+		{
+			aucRange[3+uiTicks] = (unsigned char)(i + uiTicks);
+		}
+		Bench_SceneCommand(0x95, aucRange, sizeof(aucRange));
+	}
+	Bench_SceneCommand(0x88, 0, 0);
+	Sim_RunRGBooster();
+	Sim_ClearStrip();
+	ucSlot = 0;
+	if(!(Bench_SceneCommand(0x9D, &ucSlot, 1) & (1<<STATUS_DROPPED)) || (Bench_ReadRegister(REG_SCENE)!=2))
+	{
+		printf("  FAIL: scene with too many runs saved\n");
+		iResult = 1;
+	}
+	ucSlot = 3;
+	if(!(Bench_SceneCommand(0x9E, &ucSlot, 1) & (1<<STATUS_DROPPED)))
+	{
+		printf("  FAIL: empty scene recalled\n");
+		iResult = 1;
+	}
+
+	for(i=0;i<(3*SCENE_RING_SIZE);i++) // wear-levelled ring wraps around
+	{
+		ucSlot = (unsigned char)(1 + (i & 0x01));
+		Bench_SceneCommand(0x9E, &ucSlot, 1);
+		Sim_RunRGBooster();
+		Sim_ClearStrip();
+		if(Scene_GetLast()!=ucSlot)
+		{
+			printf("  FAIL: last scene %u after recall %u of %u\n", Scene_GetLast(), i, ucSlot);
+			iResult = 1;
+			break;
+		}
+	}
+	ucSlot = 1;
+	Bench_SceneCommand(0x9E, &ucSlot, 1);
+	Bench_SceneCommand(0x9A, 0, 0);
+	Sim_RunRGBooster();
+
+	Sim_Reset(); // power blip
+	Gamma_Select(GAMMA_PLED_DEFAULT, GAMMA_RGB_OFF);
+	systemInit();
+	restoreScene();
+	initTasks();
+	Sim_RunRGBooster(); // boot clear
+	Sim_ClearStrip();
+	for(uiTicks=0;(uiTicks<1000) && (!sSim.uiStripCount);uiTicks++)
+	{
+		Sim_RunTicks(1);
+		Scheduler_Run();
+	}
+	Sim_RunRGBooster();
+	if(Bench_CheckScene())
+	{
+		printf("  FAIL: scene 1 not restored at boot\n");
+		iResult = 1;
+	}
+	Sim_ClearStrip();
+
+	Bench_SetLayout(BENCH_EFFECT_LEDS, FORMAT_PAL4);
+	Sim_RunRGBooster();
+	Sim_ClearStrip();
+	Bench_SceneCommand(0x9E, &ucSlot, 1);
+	Sim_RunRGBooster();
+	if(Bench_CheckScene())
+	{
+		printf("  FAIL: scene 1 not recalled in FORMAT_PAL4\n");
+		iResult = 1;
+	}
+	Sim_ClearStrip();
+
+	ucSlot = SCENE_NONE;
+	Bench_SceneCommand(0x9E, &ucSlot, 1);
+	if((Bench_ReadRegister(REG_SCENE)!=SCENE_NONE) || (Scene_GetLast()!=SCENE_NONE))
+	{
+		printf("  FAIL: scene restored at boot not cleared\n");
+		iResult = 1;
+	}
+
+	printf("  %-44s %u ms after systemInit() (before: 3000 ms boot test, then the RPi)\n", "scene restored at boot", uiTicks);
+	printf("  %-44s %u slots of %u runs, %u EEPROM bytes each\n", "scene store", SCENES, SCENE_RUNS_MAX, SCENE_SIZE);
+	printf("  %-44s %u command ticks, one EEPROM byte each (before: one blocking call)\n", "scene save (3 runs)", uiSave);
+	Bench_SetLayout(LED_COUNT_DEFAULT, FORMAT_GRB);
+	Sim_RunRGBooster();
+	Bench_Boot();
+	return iResult;
+}
+
+
+#ifdef INSTRUMENTATION
+
+
+/** ***************************************************************************
+ * @brief Measure a section of the simulated timer2 as processCommands()
+ *
+ * The section starts at TCNT2 ucStart and lasts uiTicks + 1 ticks (the exit
+ * timestamp advances the counter too).
+ *
+ * @param [in] ucStart: TCNT2 at the start of the section
+ * @param [in] uiTicks: ticks run inside the section
+ * @return INSTR_REG_COMMANDS_MAX of the section
+ *****************************************************************************/
+static unsigned char Bench_Section(unsigned char ucStart, unsigned int uiTicks)
+{
+	Bench_ReadRegister(INSTR_REG_COMMANDS_MAX); // restart the maximum
+	Sim_RunTimer2((unsigned char)(ucStart - Sim_ucTCNT2 - 1));
+	{
+		INSTR_ENTRY();
+
+		Sim_RunTimer2(uiTicks);
+		INSTR_EXIT(INSTR_COMMANDS);
+	}
+	return Bench_ReadRegister(INSTR_REG_COMMANDS_MAX);
+}
+
+
+/** ***************************************************************************
+ * @brief Check the instrumentation registers
+ *
+ * A burst of CMD_QUEUE_SIZE + 2 single color commands without a main loop
+ * pass must fill the queue (high-water mark), drop 2 commands and discard
+ * their data bytes. Every transferred frame must be counted. Maximum and
+ * high-water mark restart with the read. The simulated timer2 advances once
+ * per timestamp, so every ISR lasts exactly one tick. Sections across a
+ * timer2 overflow are measured correctly, sections above 255 ticks are
+ * saturated and flagged.
+ *
+ * @param [void] no input
+ * @return 0 if all registers were correct
+ *****************************************************************************/
+static int Bench_Instrumentation(void)
+{
+	unsigned long n;
+	unsigned char aucCommand[4] = {0x84, 0x10, 0x20, 0x30};
+	unsigned char ucLatch = 0x88;
+	unsigned char ucFrames;
+	unsigned char ucDropped;
+	unsigned char ucOverrun;
+	unsigned char ucQueueMax;
+	unsigned char ucShort;
+	unsigned char ucLong;
+
+	Bench_Boot();
+	ucFrames = Bench_ReadRegister(INSTR_REG_FRAMES);
+	ucDropped = Bench_ReadRegister(INSTR_REG_DROPPED);
+	ucOverrun = Bench_ReadRegister(INSTR_REG_OVERRUN);
+
+	for(n=0;n<(CMD_QUEUE_SIZE+2);n++)
+	{
+		Sim_SPISend(aucCommand, sizeof(aucCommand));
+	}
+	for(n=0;n<(CMD_QUEUE_SIZE+2);n++)
+	{
+		processCommands();
+		Sim_RunRGBooster();
+	}
+	Sim_SPISend(&ucLatch, 1);
+	processCommands();
+	Sim_RunRGBooster();
+
+	ucQueueMax = Bench_ReadRegister(INSTR_REG_QUEUE_MAX);
+	if(ucQueueMax != CMD_QUEUE_SIZE)
+	{
+		printf("  FAIL: command queue high-water mark %u, expected %u\n", ucQueueMax, CMD_QUEUE_SIZE);
+		return 1;
+	}
+	if(Bench_ReadRegister(INSTR_REG_QUEUE_MAX) != 0)
+	{
+		printf("  FAIL: high-water mark not restarted by the read\n");
+		return 1;
+	}
+	if((unsigned char)(Bench_ReadRegister(INSTR_REG_DROPPED) - ucDropped) != 2)
+	{
+		printf("  FAIL: dropped commands not counted\n");
+		return 1;
+	}
+	if((unsigned char)(Bench_ReadRegister(INSTR_REG_OVERRUN) - ucOverrun) != 6)
+	{
+		printf("  FAIL: data bytes of the dropped commands not counted\n");
+		return 1;
+	}
+	if((unsigned char)(Bench_ReadRegister(INSTR_REG_FRAMES) - ucFrames) != (CMD_QUEUE_SIZE+1))
+	{
+		printf("  FAIL: frames sent not counted\n");
+		return 1;
+	}
+	if((Bench_ReadRegister(INSTR_REG_SPI_AVG) != 1) || (Bench_ReadRegister(INSTR_REG_INT1_AVG) != 1))
+	{
+		printf("  FAIL: ISR timing does not match the simulated timer2\n");
+		return 1;
+	}
+
+	printf("  %-44s SPI %u/%u INT1 %u/%u commands %u/%u ticks (max/avg)\n", "instrumentation [0x8C, RR, 0x00]",
+		Bench_ReadRegister(INSTR_REG_SPI_MAX), Bench_ReadRegister(INSTR_REG_SPI_AVG),
+		Bench_ReadRegister(INSTR_REG_INT1_MAX), Bench_ReadRegister(INSTR_REG_INT1_AVG),
+		Bench_ReadRegister(INSTR_REG_COMMANDS_MAX), Bench_ReadRegister(INSTR_REG_COMMANDS_AVG));
+	printf("  %-44s queue %u/%u, 2 dropped, 6 bytes discarded\n", "command burst", ucQueueMax, CMD_QUEUE_SIZE);
+
+	Bench_ReadRegister(INSTR_REG_SATURATED);
+	ucShort = Bench_Section(240, 254); // 255 ticks across an overflow
+	if((ucShort!=255) || (Bench_ReadRegister(INSTR_REG_SATURATED)!=0))
+	{
+		printf("  FAIL: section of 255 ticks measured as %u\n", ucShort);
+		return 1;
+	}
+	ucLong = Bench_Section(240, 600); // two overflows
+	if((ucLong!=0xFF) || (Bench_ReadRegister(INSTR_REG_SATURATED)!=(1<<INSTR_COMMANDS)) ||
+		(Bench_ReadRegister(INSTR_REG_SATURATED)!=0))
+	{
+		printf("  FAIL: section of 601 ticks measured as %u, not flagged as saturated\n", ucLong);
+		return 1;
+	}
+	printf("  %-44s 255 ticks: %u, 601 ticks: %u (saturated, flagged)\n", "long sections", ucShort, ucLong);
+	return 0;
+}
+
+#endif /* INSTRUMENTATION */
+
+
+/** ***************************************************************************
+ * @brief Firmware benchmark suite
+ *
+ * @param [void] no input
+ * @return 0 if all checks passed
+ *****************************************************************************/
+int Bench_Firmware(void)
+{
+	int iResult = 0;
+
+#ifdef INSTRUMENTATION
+	printf("firmware with INSTRUMENTATION\n");
+	iResult |= Bench_Instrumentation();
+#else
+	printf("firmware (strip length %u LEDs)\n", LED_COUNT_DEFAULT);
+	iResult |= Bench_ISRCost();
+	iResult |= Bench_CommandBurst();
+	iResult |= Bench_Throughput();
+	iResult |= Bench_FrameUpload();
+	iResult |= Bench_BusyUpload();
+	iResult |= Bench_FramedUpload();
+	iResult |= Bench_FrameOverlap();
+	iResult |= Bench_Temperature();
+	iResult |= Bench_Thermal();
+	iResult |= Bench_Scheduler();
+	iResult |= Bench_Sleep();
+	iResult |= Bench_Sunrise();
+	iResult |= Bench_Gamma();
+	iResult |= Bench_Dithering();
+	iResult |= Bench_Backpressure();
+	iResult |= Bench_StripLength();
+	iResult |= Bench_Palette();
+	iResult |= Bench_RunLength();
+	iResult |= Bench_Effects();
+	iResult |= Bench_Color();
+	iResult |= Bench_Scene();
+#endif
+	printf("\n");
+
+	return iResult;
+}
@@ -0,0 +1,381 @@
+/** ***************************************************************************
+ * @file bench_rgbooster.c
+ * @brief Benchmark of the RGBooster handshake ISR
+ *
+ * - per byte cost
+ * @n ISR(INT1_vect) of the firmware (wire order framebuffer with read
+ * pointer) against a copy of the former ISR (separate volatile red, green and
+ * blue arrays, switch on the color counter).
+ *
+ * Both ISRs run with the same simulated ports on the host CPU, the firmware
+ * is built without INSTRUMENTATION. The host cycles only check that the ISR
+ * does not get grossly slower, they do not translate to the AVR (indexing
+ * and volatile reloads are cheap on a 64bit CPU). The AVR cost per byte has
+ * to be taken from the avr-gcc build (simavr or the cycles of __vector_2 in
+ * avr-objdump -d).
+ *
+ * - frame rate
+ * @n Frames per second for 20, 150 and 300 LEDs. Every byte costs 10us on
+ * the WS2812 line (8 bits at 800kHz) plus the ISR, since the next byte can
+ * only be sent after the handshake. The ISR costs are the measured host
+ * cycles per byte taken as cycles at F_CPU, the wire limit is the frame rate
+ * without any ISR cost.
+ *
+ * - palette transfer
+ * @n ISR(INT1_vect) per byte of a 4bit palette indexed frame (index lookup
+ * at every third byte) against the wire order frame, and the expanded colors.
+ *
+ * - transfer API
+ * @n The boot-time clear returns before the strip is cleared, buffers of any
+ * length are sent completely, a second start is refused while busy and the
+ * completion hook can chain the next transfer.
+ *
+ * @author agent
+ * @date 16.10.2026
+ *****************************************************************************/
+
+
+#include <stdio.h>
+#include <avr/io.h>
+#include "main.h"
+#include "rgbooster.h"
+#include "sim.h"
+#include "bench.h"
+
+
+#define BENCH_FRAMES			20000		///< amount of frames per measurement
+#define BENCH_WS2812_BYTE_US	10.0		///< time on the WS2812 line per byte
+#define BENCH_WS2812_RESET_US	50.0		///< reset (latch) time after a frame
+#define BENCH_TRANSFER_FIRST	1000		///< length of the first transfer of the API check
+#define BENCH_TRANSFER_SECOND	7			///< length of the transfer chained by the completion hook
+
+
+static volatile unsigned char aucLegacyRed[LED_COUNT_DEFAULT];		///< red buffer of the legacy ISR
+static volatile unsigned char aucLegacyGreen[LED_COUNT_DEFAULT];	///< green buffer of the legacy ISR
+static volatile unsigned char aucLegacyBlue[LED_COUNT_DEFAULT];		///< blue buffer of the legacy ISR
+static volatile unsigned char ucLegacyRGBIdx = LED_COUNT_DEFAULT;	///< LED counter of the legacy ISR
+static volatile unsigned char ucLegacyByteIdx = 0;			///< color counter of the legacy ISR
+static unsigned char aucTransfer[BENCH_TRANSFER_FIRST + BENCH_TRANSFER_SECOND];	///< data of the API check
+static unsigned int uiDoneCalls = 0;						///< calls of the completion hook
+static unsigned char aucPalette[PALETTE4_SIZE];				///< palette of the palette transfer (wire order)
+static unsigned char aucPaletteIndex[(LED_COUNT_DEFAULT+1)/2];	///< 4bit indices of the palette transfer
+
+
+/** ***************************************************************************
+ * @brief Former ISR(INT1_vect): three color arrays and a switch per byte
+ *
+ * @param [void] no input
+ * @return no return value
+ *****************************************************************************/
+static void Bench_LegacyINT1(void)
+{
+	if(ucLegacyRGBIdx<(LED_COUNT_DEFAULT))
+	{
+		switch(ucLegacyByteIdx)
+		{
+			case 0:
+			PORT_DATA_HIGH = (PORT_DATA_HIGH & ~DATA_HIGH_BITMASK) | (aucLegacyGreen[ucLegacyRGBIdx] & DATA_HIGH_BITMASK);
+			PORT_DATA_LOW = (PORT_DATA_LOW & ~DATA_LOW_BITMASK) | (aucLegacyGreen[ucLegacyRGBIdx] & DATA_LOW_BITMASK);
+			PORT_CONTROL |= (1<<SEND);
+			PORT_CONTROL &= ~(1<<SEND);
+			ucLegacyByteIdx++;
+			break;
+
+			case 1:
+			PORT_DATA_HIGH = (PORT_DATA_HIGH & ~DATA_HIGH_BITMASK) | (aucLegacyRed[ucLegacyRGBIdx] & DATA_HIGH_BITMASK);
+			PORT_DATA_LOW = (PORT_DATA_LOW & ~DATA_LOW_BITMASK) | (aucLegacyRed[ucLegacyRGBIdx] & DATA_LOW_BITMASK);
+			PORT_CONTROL |= (1<<SEND);
+			PORT_CONTROL &= ~(1<<SEND);
+			ucLegacyByteIdx++;
+			break;
+
+			case 2:
+			PORT_DATA_HIGH = (PORT_DATA_HIGH & ~DATA_HIGH_BITMASK) | (aucLegacyBlue[ucLegacyRGBIdx] & DATA_HIGH_BITMASK);
+			PORT_DATA_LOW = (PORT_DATA_LOW & ~DATA_LOW_BITMASK) | (aucLegacyBlue[ucLegacyRGBIdx] & DATA_LOW_BITMASK);
+			PORT_CONTROL |= (1<<SEND);
+			PORT_CONTROL &= ~(1<<SEND);
+			ucLegacyByteIdx=0;
+			ucLegacyRGBIdx++;
+			break;
+		}
+	}
+}
+
+
+/** ***************************************************************************
+ * @brief Measure one frame of the legacy ISR per handshake
+ *
+ * @param [in,out] psStat: statistics to update
+ * @return no return value
+ *****************************************************************************/
+static void Bench_LegacyFrame(BENCH_STAT* psStat)
+{
+	uint64_t ullStart;
+
+	ucLegacyRGBIdx = 0;
+	ucLegacyByteIdx = 0;
+	do
+	{
+		sSim.ucHandshakePending = 0;
+		ullStart = Bench_Cycles();
+		Bench_LegacyINT1();
+		Bench_Add(psStat, ullStart, Bench_Cycles());
+	}
+	while(sSim.ucHandshakePending);
+}
+
+
+/** ***************************************************************************
+ * @brief Measure one frame of the firmware ISR per handshake
+ *
+ * The frame is latched through SPI. The first byte is sent by the latch
+ * itself, all following bytes by handshakes.
+ *
+ * @param [in,out] psStat: statistics to update
+ * @return no return value
+ *****************************************************************************/
+static void Bench_CurrentFrame(BENCH_STAT* psStat)
+{
+	uint64_t ullStart;
+
+	Sim_SPITransfer(0x88);
+	processCommands();
+	while(sSim.ucHandshakePending)
+	{
+		sSim.ucHandshakePending = 0;
+		ullStart = Bench_Cycles();
+		INT1_vect();
+		Bench_Add(psStat, ullStart, Bench_Cycles());
+	}
+}
+
+
+/** ***************************************************************************
+ * @brief Measure one 4bit palette indexed frame of the firmware ISR per handshake
+ *
+ * The first byte is sent by RGBooster_StartPalette() itself, all following
+ * bytes by handshakes.
+ *
+ * @param [in,out] psStat: statistics to update
+ * @return no return value
+ *****************************************************************************/
+static void Bench_PaletteFrame(BENCH_STAT* psStat)
+{
+	uint64_t ullStart;
+
+	RGBooster_StartPalette(aucPalette, aucPaletteIndex, LED_COUNT_DEFAULT, 4);
+	while(sSim.ucHandshakePending)
+	{
+		sSim.ucHandshakePending = 0;
+		ullStart = Bench_Cycles();
+		INT1_vect();
+		Bench_Add(psStat, ullStart, Bench_Cycles());
+	}
+}
+
+
+/** ***************************************************************************
+ * @brief Print the frame rate for a strip length
+ *
+ * @param [in] uiLEDs: amount of LEDs
+ * @param [in] dLegacy: measured cycles per byte of the legacy ISR
+ * @param [in] dCurrent: measured cycles per byte of the current ISR
+ * @return no return value
+ *****************************************************************************/
+static void Bench_PrintFrameRate(unsigned int uiLEDs, double dLegacy, double dCurrent)
+{
+	double dMHz = (double)F_CPU / 1e6;
+	double dLegacyUs = (uiLEDs * 3.0 * (BENCH_WS2812_BYTE_US + (dLegacy / dMHz))) + BENCH_WS2812_RESET_US;
+	double dCurrentUs = (uiLEDs * 3.0 * (BENCH_WS2812_BYTE_US + (dCurrent / dMHz))) + BENCH_WS2812_RESET_US;
+	double dWireUs = (uiLEDs * 3.0 * BENCH_WS2812_BYTE_US) + BENCH_WS2812_RESET_US;
+
+	printf("  %4u LEDs: legacy %7.1f fps   current %7.1f fps   wire limit %7.1f fps\n",
+		uiLEDs, 1e6 / dLegacyUs, 1e6 / dCurrentUs, 1e6 / dWireUs);
+}
+
+
+/** ***************************************************************************
+ * @brief Completion hook of the API check: chains the second transfer once
+ *
+ * @param [void] no input
+ * @return no return value
+ *****************************************************************************/
+static void Bench_TransferDone(void)
+{
+	uiDoneCalls++;
+	if(uiDoneCalls == 1)
+	{
+		RGBooster_Start(&aucTransfer[BENCH_TRANSFER_FIRST], BENCH_TRANSFER_SECOND);
+	}
+}
+
+
+/** ***************************************************************************
+ * @brief Check the asynchronous transfer API
+ *
+ * The firmware is booted again afterwards to restore its completion hook.
+ *
+ * @param [void] no input
+ * @return 0 if all checks passed
+ *****************************************************************************/
+static int Bench_Transfer(void)
+{
+	unsigned int i;
+	int iResult = 0;
+
+	Sim_Reset();
+	systemInit();
+	if((!RGBooster_IsBusy()) || (sSim.uiStripCount != 1))
+	{
+		printf("  FAIL: boot waited for the strip (%u bytes sent)\n", sSim.uiStripCount);
+		iResult = 1;
+	}
+	Sim_RunRGBooster();
+	for(i=0;i<(LED_COUNT_DEFAULT*3);i++)
+	{
+		if(sSim.aucStrip[i] != 0)
+		{
+			break;
+		}
+	}
+	if((RGBooster_IsBusy()) || (sSim.uiStripCount != LED_COUNT_DEFAULT*3) || (i != LED_COUNT_DEFAULT*3))
+	{
+		printf("  FAIL: strip not cleared at boot\n");
+		iResult = 1;
+	}
+
+	for(i=0;i<(BENCH_TRANSFER_FIRST + BENCH_TRANSFER_SECOND);i++)
+	{
+		aucTransfer[i] = (unsigned char)((i * 7) + 3);
+	}
+	Sim_ClearStrip();
+	uiDoneCalls = 0;
+	RGBooster_SetDoneHook(Bench_TransferDone);
+	if((!RGBooster_Start(aucTransfer, BENCH_TRANSFER_FIRST)) || (RGBooster_Start(aucTransfer, 1)) || (!RGBooster_IsBusy()))
+	{
+		printf("  FAIL: start of a transfer while idle/busy\n");
+		iResult = 1;
+	}
+	Sim_RunRGBooster();
+	for(i=0;i<sSim.uiStripCount;i++)
+	{
+		if(sSim.aucStrip[i] != aucTransfer[i])
+		{
+			break;
+		}
+	}
+	if((sSim.uiStripCount != BENCH_TRANSFER_FIRST + BENCH_TRANSFER_SECOND) || (i != sSim.uiStripCount) || (uiDoneCalls != 2) || (RGBooster_IsBusy()))
+	{
+		printf("  FAIL: %u bytes sent, %u completions\n", sSim.uiStripCount, uiDoneCalls);
+		iResult = 1;
+	}
+	if((!RGBooster_Start(aucTransfer, 0)) || (RGBooster_IsBusy()) || (uiDoneCalls != 2))
+	{
+		printf("  FAIL: empty transfer\n");
+		iResult = 1;
+	}
+	if(!iResult)
+	{
+		printf("  %-44s %u + %u bytes chained by the hook, boot clear in background\n", "RGBooster_Start()", BENCH_TRANSFER_FIRST, BENCH_TRANSFER_SECOND);
+	}
+
+	Sim_Reset();
+	systemInit();
+	Sim_RunRGBooster();
+	Sim_ClearStrip();
+	return iResult;
+}
+
+
+/** ***************************************************************************
+ * @brief RGBooster benchmark suite
+ *
+ * @param [void] no input
+ * @return 0 if all checks passed
+ *****************************************************************************/
+int Bench_RGBooster(void)
+{
+	BENCH_STAT sLegacy = {"legacy ISR(INT1_vect) per byte", 0, 0, 0};
+	BENCH_STAT sCurrent = {"ISR(INT1_vect) per byte", 0, 0, 0};
+	BENCH_STAT sPalette = {"ISR(INT1_vect) per byte, 4bit palette", 0, 0, 0};
+	unsigned long n;
+	unsigned int i;
+	double dLegacy;
+	double dCurrent;
+	double dPalette;
+	unsigned char ucIndex;
+
+	printf("RGBooster handshake\n");
+
+	if(Bench_Transfer())
+	{
+		return 1;
+	}
+
+	for(i=0;i<PALETTE4_SIZE;i++)
+	{
+		aucPalette[i] = (unsigned char)((i * 29) + 5);
+	}
+	for(i=0;i<LED_COUNT_DEFAULT;i++)
+	{
+		aucPaletteIndex[i/2] |= (unsigned char)(((i * 5) & 0x0F) << ((i & 0x01) * 4));
+		aucLegacyRed[i] = (unsigned char)i;
+		aucLegacyGreen[i] = (unsigned char)(i + 0x40);
+		aucLegacyBlue[i] = (unsigned char)(i + 0x80);
+	}
+
+	Sim_Reset();
+	systemInit();
+	Sim_RunRGBooster();
+	Sim_ClearStrip();
+
+	for(n=0;n<BENCH_FRAMES;n++)
+	{
+		Bench_LegacyFrame(&sLegacy);
+		Bench_CurrentFrame(&sCurrent);
+		Sim_ClearStrip();
+		Bench_PaletteFrame(&sPalette);
+		if(n<(BENCH_FRAMES-1))
+		{
+			Sim_ClearStrip();
+		}
+	}
+
+	for(i=0;i<(LED_COUNT_DEFAULT*3);i++)
+	{
+		ucIndex = (unsigned char)((aucPaletteIndex[i/6] >> (((i/3) & 0x01) * 4)) & 0x0F);
+		if(sSim.aucStrip[i] != aucPalette[(ucIndex*3)+(i%3)])
+		{
+			printf("  FAIL: palette frame wrong at byte %u\n", i);
+			return 1;
+		}
+	}
+	Sim_ClearStrip();
+
+	if((sLegacy.ulCalls != sCurrent.ulCalls + BENCH_FRAMES) || (sCurrent.ulCalls != BENCH_FRAMES * LED_COUNT_DEFAULT * 3) || (sPalette.ulCalls != sCurrent.ulCalls))
+	{
+		printf("  FAIL: %lu/%lu handshakes measured, expected %lu\n", sLegacy.ulCalls, sCurrent.ulCalls,
+			(unsigned long)(BENCH_FRAMES * LED_COUNT_DEFAULT * 3));
+		return 1;
+	}
+
+	Bench_Print(&sLegacy);
+	Bench_Print(&sCurrent);
+	Bench_Print(&sPalette);
+
+	dLegacy = (double)sLegacy.ullTotal / (double)sLegacy.ulCalls;
+	dCurrent = (double)sCurrent.ullTotal / (double)sCurrent.ulCalls;
+	printf("  per byte ISR cost: host %+.1f%% (host only, AVR cycles: see the file header)\n",
+		100.0 * ((dCurrent / dLegacy) - 1.0));
+	dPalette = (double)sPalette.ullTotal / (double)sPalette.ulCalls;
+	printf("  per byte ISR cost of the 4bit palette: host %+.1f%% against the wire order frame\n",
+		100.0 * ((dPalette / dCurrent) - 1.0));
+
+	printf("  frame rate with the measured cycles per byte at %.0f MHz:\n", (double)F_CPU / 1e6);
+	Bench_PrintFrameRate(20, dLegacy, dCurrent);
+	Bench_PrintFrameRate(150, dLegacy, dCurrent);
+	Bench_PrintFrameRate(300, dLegacy, dCurrent);
+	printf("\n");
+
+	return 0;
+}
@@ -0,0 +1,250 @@
+/** ***************************************************************************
+ * @file bench_ringbuffer.c
+ * @brief Benchmark of the locked and the lock-free (RINGBUFFER_SPSC) ringbuffer
+ *
+ * The mode of ringbuffer.h is selected at compile time, so this file is
+ * compiled twice (see Makefile): once as it is and once with RINGBUFFER_SPSC
+ * defined. Each object measures its own variant, the locked one also runs
+ * the suite and compares both.
+ *
+ * - operations per second
+ * @n Blocks of BENCH_RING_BLOCK bytes are inserted and removed again, byte
+ * by byte and with the block functions. The block transfers are shifted by
+ * a few bytes, so they wrap around the end of the buffer. The consumer of the
+ * block transfer reads through RingBuffer_GetReadSpan().
+ *
+ * - cost per operation and interrupt disabled time
+ * @n Every RingBuffer_Insert() and RingBuffer_Remove() is measured on its
+ * own. The atomic blocks are traced through util/atomic.h (BENCH_IRQ_TRACE).
+ * The host maximum also contains preemptions by the operating system, the
+ * amount of disabled sections is the reliable figure.
+ * On the AVR the locked variant disables the interrupts for about 6 cycles
+ * per operation (cli, count update, SREG restore), the SPSC variant
+ * never disables them.
+ *
+ * - overflow
+ * @n RingBuffer_TryInsert() and RingBuffer_TryInsertBlock() must reject
+ * data which does not fit without changing the stored elements or the count.
+ *
+ * @author agent
+ * @date 16.10.2026
+ *****************************************************************************/
+
+
+#define BENCH_IRQ_TRACE
+
+#include <stdio.h>
+#include <string.h>
+#include <avr/io.h>
+#include "ringbuffer.h"
+#include "bench.h"
+
+
+#define BENCH_RING_ROUNDS	100000		///< amount of blocks per measurement
+#define BENCH_RING_BLOCK	64			///< bytes per block
+
+#if defined(RINGBUFFER_SPSC)
+#define BENCH_RING_RUN		Bench_RingBufferSPSC
+#define BENCH_RING_NAME		"SPSC"
+#else
+#define BENCH_RING_RUN		Bench_RingBufferLocked
+#define BENCH_RING_NAME		"locked"
+#endif
+
+
+/** Results of one ringbuffer variant */
+typedef struct
+{
+	double dOpsPerSecond;		///< insert and remove operations per second
+	double dBlockPerSecond;		///< bytes per second inserted and removed as blocks
+	BENCH_STAT sInsert;			///< cost of RingBuffer_Insert()
+	BENCH_STAT sRemove;			///< cost of RingBuffer_Remove()
+	BENCH_STAT sIrq;			///< interrupt disabled sections
+} BENCH_RING;
+
+int Bench_RingBufferLocked(BENCH_RING* psResult);
+int Bench_RingBufferSPSC(BENCH_RING* psResult);
+
+
+static RingBuff_t sRing;		///< buffer under test
+
+
+/** ***************************************************************************
+ * @brief Measure the ringbuffer variant of this object
+ *
+ * @param [out] psResult: measurements
+ * @return 0 if all bytes were removed in the right order
+ *****************************************************************************/
+int BENCH_RING_RUN(BENCH_RING* psResult)
+{
+	unsigned long n;
+	unsigned int i;
+	unsigned char ucData;
+	unsigned char ucError = 0;
+	unsigned char aucBlock[BENCH_RING_BLOCK];
+	RingBuff_Data_t* pucSpan;
+	RingBuff_Count_t uiSpan;
+	uint64_t ullStart;
+	double dStart;
+	double dSeconds;
+
+	psResult->sInsert = (BENCH_STAT){"RingBuffer_Insert() " BENCH_RING_NAME, 0, 0, 0};
+	psResult->sRemove = (BENCH_STAT){"RingBuffer_Remove() " BENCH_RING_NAME, 0, 0, 0};
+	psResult->sIrq = (BENCH_STAT){"interrupts disabled " BENCH_RING_NAME, 0, 0, 0};
+
+	SREG |= 0x80; // main loop context
+	RingBuffer_InitBuffer(&sRing);
+
+	// throughput, nothing traced
+	dStart = Bench_Seconds();
+	for(n=0;n<BENCH_RING_ROUNDS;n++)
+	{
+		for(i=0;i<BENCH_RING_BLOCK;i++)
+		{
+			RingBuffer_Insert(&sRing, (RingBuff_Data_t)(n + i));
+		}
+		i = 0;
+		while(!RingBuffer_IsEmpty(&sRing))
+		{
+			ucError |= (unsigned char)(RingBuffer_Remove(&sRing) ^ (RingBuff_Data_t)(n + i));
+			i++;
+		}
+	}
+	dSeconds = Bench_Seconds() - dStart;
+	psResult->dOpsPerSecond = (2.0 * BENCH_RING_ROUNDS * BENCH_RING_BLOCK) / dSeconds;
+
+	// block operations, buffer content shifted by 3 bytes
+	RingBuffer_Insert(&sRing, 0);
+	RingBuffer_Insert(&sRing, 0);
+	RingBuffer_Insert(&sRing, 0);
+	dStart = Bench_Seconds();
+	for(n=0;n<BENCH_RING_ROUNDS;n++)
+	{
+		for(i=0;i<BENCH_RING_BLOCK;i++)
+		{
+			aucBlock[i] = (unsigned char)(n + i);
+		}
+		RingBuffer_InsertBlock(&sRing, aucBlock, BENCH_RING_BLOCK);
+		RingBuffer_RemoveBlock(&sRing, aucBlock, 3);
+		i = 3;
+		while(i < BENCH_RING_BLOCK)
+		{
+			uiSpan = RingBuffer_GetReadSpan(&sRing, &pucSpan);
+			if(uiSpan > (BENCH_RING_BLOCK - i))
+			{
+				uiSpan = BENCH_RING_BLOCK - i;
+			}
+			memcpy(&aucBlock[i], pucSpan, uiSpan);
+			RingBuffer_CommitRead(&sRing, uiSpan);
+			i += uiSpan;
+		}
+		for(i=3;i<BENCH_RING_BLOCK;i++)
+		{
+			ucError |= (unsigned char)(aucBlock[i] ^ (RingBuff_Data_t)(n + i - 3));
+		}
+	}
+	dSeconds = Bench_Seconds() - dStart;
+	psResult->dBlockPerSecond = (2.0 * BENCH_RING_ROUNDS * BENCH_RING_BLOCK) / dSeconds;
+	RingBuffer_RemoveBlock(&sRing, aucBlock, 3);
+
+	// single operations, interrupt disabled time traced
+	psBenchIrq = &psResult->sIrq;
+	ucBenchIrqTrace = 1;
+	for(n=0;n<(BENCH_RING_ROUNDS/10);n++)
+	{
+		for(i=0;i<BENCH_RING_BLOCK;i++)
+		{
+			ullStart = Bench_Cycles();
+			RingBuffer_Insert(&sRing, (RingBuff_Data_t)(n + i));
+			Bench_Add(&psResult->sInsert, ullStart, Bench_Cycles());
+		}
+		for(i=0;i<BENCH_RING_BLOCK;i++)
+		{
+			ullStart = Bench_Cycles();
+			ucData = RingBuffer_Remove(&sRing);
+			Bench_Add(&psResult->sRemove, ullStart, Bench_Cycles());
+			ucError |= (unsigned char)(ucData ^ (RingBuff_Data_t)(n + i));
+		}
+	}
+	ucBenchIrqTrace = 0;
+	psBenchIrq = 0;
+
+	if(ucError || !RingBuffer_IsEmpty(&sRing))
+	{
+		printf("  FAIL: %s ringbuffer returned wrong data\n", BENCH_RING_NAME);
+		return 1;
+	}
+
+	// overflow, buffer content shifted by 5 bytes
+	RingBuffer_InsertBlock(&sRing, aucBlock, 5);
+	RingBuffer_RemoveBlock(&sRing, aucBlock, 5);
+	for(i=0;RingBuffer_TryInsert(&sRing, (RingBuff_Data_t)i);i++)
+	{
+		if(i>BUFFER_SIZE)
+		{
+			break;
+		}
+	}
+	ucError |= (i!=BUFFER_SIZE) || (RingBuffer_GetCount(&sRing)!=BUFFER_SIZE);
+	RingBuffer_RemoveBlock(&sRing, aucBlock, 2);
+	ucError |= RingBuffer_TryInsertBlock(&sRing, aucBlock, 3);
+	ucError |= (RingBuffer_GetCount(&sRing)!=(BUFFER_SIZE-2));
+	aucBlock[0] = (unsigned char)BUFFER_SIZE;
+	aucBlock[1] = (unsigned char)(BUFFER_SIZE+1);
+	ucError |= !RingBuffer_TryInsertBlock(&sRing, aucBlock, 2);
+	for(i=2;i<(BUFFER_SIZE+2);i++)
+	{
+		ucError |= (unsigned char)(RingBuffer_Remove(&sRing) ^ (RingBuff_Data_t)i);
+	}
+	if(ucError || !RingBuffer_IsEmpty(&sRing))
+	{
+		printf("  FAIL: %s ringbuffer overflow not rejected\n", BENCH_RING_NAME);
+		return 1;
+	}
+	return 0;
+}
+
+
+#if !defined(RINGBUFFER_SPSC)
+/** ***************************************************************************
+ * @brief Ringbuffer benchmark suite
+ *
+ * @param [void] no input
+ * @return 0 if all checks passed
+ *****************************************************************************/
+int Bench_RingBuffer(void)
+{
+	BENCH_RING sLocked;
+	BENCH_RING sSPSC;
+
+	printf("ringbuffer (BUFFER_SIZE = %u, blocks of %u bytes)\n", BUFFER_SIZE, BENCH_RING_BLOCK);
+
+	if(Bench_RingBufferLocked(&sLocked) || Bench_RingBufferSPSC(&sSPSC))
+	{
+		return 1;
+	}
+
+	Bench_Print(&sLocked.sInsert);
+	Bench_Print(&sSPSC.sInsert);
+	Bench_Print(&sLocked.sRemove);
+	Bench_Print(&sSPSC.sRemove);
+	Bench_Print(&sLocked.sIrq);
+	Bench_Print(&sSPSC.sIrq);
+	printf("  %-44s %10.0f ops/s\n", "locked insert/remove", sLocked.dOpsPerSecond);
+	printf("  %-44s %10.0f ops/s (%+.1f%%)\n", "SPSC insert/remove", sSPSC.dOpsPerSecond,
+		100.0 * ((sSPSC.dOpsPerSecond / sLocked.dOpsPerSecond) - 1.0));
+	printf("  %-44s %10.0f bytes/s (%.1fx byte by byte)\n", "locked block insert/remove", sLocked.dBlockPerSecond,
+		sLocked.dBlockPerSecond / sLocked.dOpsPerSecond);
+	printf("  %-44s %10.0f bytes/s (%.1fx byte by byte)\n", "SPSC block insert/remove", sSPSC.dBlockPerSecond,
+		sSPSC.dBlockPerSecond / sSPSC.dOpsPerSecond);
+
+	if(sSPSC.sIrq.ulCalls != 0)
+	{
+		printf("  FAIL: SPSC ringbuffer disabled the interrupts\n");
+		return 1;
+	}
+	printf("\n");
+
+	return 0;
+}
+#endif
@@ -0,0 +1,106 @@
+/** ***************************************************************************
+ * @file eeprom.h
+ * @brief Host replacement of <avr/eeprom.h>
+ *
+ * Variables "in the EEPROM" are ordinary variables which are accessed
+ * directly. They keep their values over Sim_Reset() and a new systemInit()
+ * like the real EEPROM keeps them over a reset. The initializer stands for
+ * the programmed .eep file. Every byte which is really written (erase and
+ * write cycle) is counted in ulSimEEPROMWrites.
+ *
+ * @author agent
+ * @date 16.10.2026
+ *****************************************************************************/
+
+
+#ifndef SIM_AVR_EEPROM_H_
+#define SIM_AVR_EEPROM_H_
+
+#include <stdint.h>
+
+#define EEMEM
+
+extern unsigned long ulSimEEPROMWrites;	///< amount of bytes written to the EEPROM (sim.c)
+
+
+/** ***************************************************************************
+ * @brief Read a byte from the EEPROM
+ *
+ * @param [in] pucAddress: address of the byte
+ * @return value
+ *****************************************************************************/
+static inline uint8_t eeprom_read_byte(const uint8_t* pucAddress)
+{
+	return *pucAddress;
+}
+
+
+/** ***************************************************************************
+ * @brief Read a word from the EEPROM
+ *
+ * @param [in] puiAddress: address of the word
+ * @return value
+ *****************************************************************************/
+static inline uint16_t eeprom_read_word(const uint16_t* puiAddress)
+{
+	return *puiAddress;
+}
+
+
+/** ***************************************************************************
+ * @brief Write a word to the EEPROM (only if it differs)
+ *
+ * @param [in] puiAddress: address of the word
+ * @param [in] uiValue: value
+ * @return no return value
+ *****************************************************************************/
+static inline void eeprom_update_word(uint16_t* puiAddress, uint16_t uiValue)
+{
+	ulSimEEPROMWrites += ((*puiAddress ^ uiValue) & 0xFF00) ? 1 : 0;
+	ulSimEEPROMWrites += ((*puiAddress ^ uiValue) & 0x00FF) ? 1 : 0;
+	*puiAddress = uiValue;
+}
+
+
+/** ***************************************************************************
+ * @brief Check if the EEPROM is ready for the next write
+ *
+ * Writes complete immediately on the host.
+ *
+ * @param [void] no input
+ * @return 1: ready
+ *****************************************************************************/
+static inline uint8_t eeprom_is_ready(void)
+{
+	return 1;
+}
+
+
+/** ***************************************************************************
+ * @brief Write a byte to the EEPROM
+ *
+ * @param [in] pucAddress: address of the byte
+ * @param [in] ucValue: value
+ * @return no return value
+ *****************************************************************************/
+static inline void eeprom_write_byte(uint8_t* pucAddress, uint8_t ucValue)
+{
+	ulSimEEPROMWrites++;
+	*pucAddress = ucValue;
+}
+
+
+/** ***************************************************************************
+ * @brief Write a byte to the EEPROM (only if it differs)
+ *
+ * @param [in] pucAddress: address of the byte
+ * @param [in] ucValue: value
+ * @return no return value
+ *****************************************************************************/
+static inline void eeprom_update_byte(uint8_t* pucAddress, uint8_t ucValue)
+{
+	ulSimEEPROMWrites += (*pucAddress!=ucValue) ? 1 : 0;
+	*pucAddress = ucValue;
+}
+
+#endif /* SIM_AVR_EEPROM_H_ */
@@ -0,0 +1,24 @@
+/** ***************************************************************************
+ * @file interrupt.h
+ * @brief Host replacement of <avr/interrupt.h>
+ *
+ * An ISR becomes an ordinary function with the name of its vector. The
+ * peripheral model (sim.c) calls it whenever the interrupt would fire and the
+ * firmware may still call it directly (e.g. "INT1_vect();").
+ *
+ * @author agent
+ * @date 16.10.2026
+ *****************************************************************************/
+
+
+#ifndef SIM_AVR_INTERRUPT_H_
+#define SIM_AVR_INTERRUPT_H_
+
+#include <avr/io.h>
+
+#define ISR(vector, ...)	void vector(void); void vector(void)
+
+#define sei()				(SREG |= 0x80)
+#define cli()				(SREG &= (uint8_t)~0x80)
+
+#endif /* SIM_AVR_INTERRUPT_H_ */
@@ -0,0 +1,224 @@
+/** ***************************************************************************
+ * @file io.h
+ * @brief Host replacement of <avr/io.h> (ATmega328 register file)
+ *
+ * Every register used by the firmware is an ordinary variable defined in
+ * sim.c. Registers whose access has a side effect on real hardware (conversion
+ * done flags, timer flags, the RGBooster send pulse, ...) are routed through
+ * an accessor of the peripheral model. The accessor is evaluated on every
+ * access and returns the storage of the register, so the firmware code stays
+ * unchanged: "PORTD |= x" and "while(!(ADCSRA & y))" behave like on the uC.
+ *
+ * @author agent
+ * @date 16.10.2026
+ *****************************************************************************/
+
+
+#ifndef SIM_AVR_IO_H_
+#define SIM_AVR_IO_H_
+
+#include <stdint.h>
+
+#define _BV(bit)	(1<<(bit))
+
+// status register (global interrupt flag)
+extern volatile uint8_t SREG;
+
+// GPIO
+extern volatile uint8_t PINB, DDRB, PORTB;
+extern volatile uint8_t PINC, DDRC, PORTC;
+extern volatile uint8_t PIND, DDRD;
+extern volatile uint8_t Sim_ucPORTD;
+extern uint8_t Sim_ucPORTDLatch;
+void Sim_LatchPORTD(void);
+static inline volatile uint8_t* Sim_PORTD(void)
+{
+	if(Sim_ucPORTD & Sim_ucPORTDLatch)
+	{
+		Sim_LatchPORTD();
+	}
+	return &Sim_ucPORTD;
+}
+#define PORTD		(*Sim_PORTD())		///< detects the RGBooster send pulse
+
+// timer0
+extern volatile uint8_t TCCR0A, TCCR0B, TCNT0, OCR0A, OCR0B, TIMSK0, TIFR0;	///< compare matches: Sim_RunTicks()
+
+// timer1
+extern volatile uint8_t TCCR1A, TCCR1B, TCCR1C, TIMSK1, TIFR1;
+extern volatile uint16_t TCNT1, OCR1A, OCR1B, ICR1;
+
+// timer2
+extern volatile uint8_t TCCR2A, TCCR2B, OCR2A, OCR2B, TIMSK2, TIFR2, ASSR;
+extern volatile uint8_t Sim_ucTCNT2;
+void Sim_OverflowTimer2(void);
+static inline volatile uint8_t* Sim_TCNT2(void)
+{
+	Sim_ucTCNT2++;
+	if(Sim_ucTCNT2==0)
+	{
+		Sim_OverflowTimer2();
+	}
+	return &Sim_ucTCNT2;
+}
+#define TCNT2		(*Sim_TCNT2())		///< advances by one tick per access
+
+// ADC
+extern volatile uint8_t ADMUX, ADCSRB, ADCL, ADCH, DIDR0;
+extern volatile uint16_t ADCW;
+volatile uint8_t* Sim_ADCSRA(void);
+#define ADCSRA		(*Sim_ADCSRA())		///< a started conversion completes on the next access
+#define ADC			ADCW
+
+// external interrupts
+extern volatile uint8_t EICRA, EIMSK, EIFR;
+
+// SPI
+extern volatile uint8_t SPCR, SPSR, SPDR;
+
+// USART
+extern volatile uint8_t UCSR0B, UCSR0C, UDR0;
+extern volatile uint16_t UBRR0;
+volatile uint8_t* Sim_UCSR0A(void);
+#define UCSR0A		(*Sim_UCSR0A())		///< transmit buffer is always empty
+
+// sleep mode control
+extern volatile uint8_t SMCR;
+
+
+// port pins
+#define PINB0	0
+#define PINB1	1
+#define PINB2	2
+#define PINB3	3
+#define PINB4	4
+#define PINB5	5
+#define PIND0	0
+#define PIND1	1
+#define PIND2	2
+#define PIND3	3
+
+// TCCR0A, TCCR0B, TIMSK0, TIFR0
+#define WGM00	0
+#define WGM01	1
+#define COM0B0	4
+#define COM0B1	5
+#define COM0A0	6
+#define COM0A1	7
+#define CS00	0
+#define CS01	1
+#define CS02	2
+#define WGM02	3
+#define TOIE0	0
+#define OCIE0A	1
+#define OCIE0B	2
+#define TOV0	0
+#define OCF0A	1
+#define OCF0B	2
+
+// TCCR1A, TCCR1B, TIMSK1, TIFR1
+#define WGM10	0
+#define WGM11	1
+#define COM1B0	4
+#define COM1B1	5
+#define COM1A0	6
+#define COM1A1	7
+#define CS10	0
+#define CS11	1
+#define CS12	2
+#define WGM12	3
+#define WGM13	4
+#define TOIE1	0
+#define OCIE1A	1
+#define OCIE1B	2
+#define ICIE1	5
+#define TOV1	0
+#define OCF1A	1
+#define OCF1B	2
+#define ICF1	5
+
+// TCCR2A, TCCR2B, TIMSK2, TIFR2
+#define WGM20	0
+#define WGM21	1
+#define CS20	0
+#define CS21	1
+#define CS22	2
+#define WGM22	3
+#define TOIE2	0
+#define OCIE2A	1
+#define OCIE2B	2
+#define TOV2	0
+#define OCF2A	1
+#define OCF2B	2
+
+// ADMUX, ADCSRA, ADCSRB
+#define MUX0	0
+#define MUX1	1
+#define MUX2	2
+#define MUX3	3
+#define ADLAR	5
+#define REFS0	6
+#define REFS1	7
+#define ADPS0	0
+#define ADPS1	1
+#define ADPS2	2
+#define ADIE	3
+#define ADIF	4
+#define ADATE	5
+#define ADSC	6
+#define ADEN	7
+#define ADTS0	0
+#define ADTS1	1
+#define ADTS2	2
+
+// EICRA, EIMSK, EIFR
+#define ISC00	0
+#define ISC01	1
+#define ISC10	2
+#define ISC11	3
+#define INT0	0
+#define INT1	1
+#define INTF0	0
+#define INTF1	1
+
+// SPCR, SPSR
+#define SPR0	0
+#define SPR1	1
+#define CPHA	2
+#define CPOL	3
+#define MSTR	4
+#define DORD	5
+#define SPE		6
+#define SPIE	7
+#define SPI2X	0
+#define WCOL	6
+#define SPIF	7
+
+// UCSR0A, UCSR0B, UCSR0C
+#define MPCM0	0
+#define U2X0	1
+#define UPE0	2
+#define DOR0	3
+#define FE0		4
+#define UDRE0	5
+#define TXC0	6
+#define RXC0	7
+#define TXB80	0
+#define RXB80	1
+#define UCSZ02	2
+#define TXEN0	3
+#define RXEN0	4
+#define UDRIE0	5
+#define TXCIE0	6
+#define RXCIE0	7
+#define UCPOL0	0
+#define UCSZ00	1
+#define UCSZ01	2
+
+// SMCR
+#define SE		0
+#define SM0		1
+#define SM1		2
+#define SM2		3
+
+#endif /* SIM_AVR_IO_H_ */
@@ -0,0 +1,41 @@
+/** ***************************************************************************
+ * @file pgmspace.h
+ * @brief Host replacement of <avr/pgmspace.h>
+ *
+ * The host has a single address space, data "in the flash memory" is an
+ * ordinary constant and is read directly. Words are copied bytewise because
+ * tables of unsigned int have 4 byte entries on the host (little endian:
+ * the low word comes first).
+ *
+ * @author agent
+ * @date 16.10.2026
+ *****************************************************************************/
+
+
+#ifndef SIM_AVR_PGMSPACE_H_
+#define SIM_AVR_PGMSPACE_H_
+
+#include <stdint.h>
+#include <string.h>
+
+#define PROGMEM
+
+#define pgm_read_byte(address)		(*(const uint8_t*)(address))
+#define pgm_read_word(address)		Sim_ReadWord(address)
+
+
+/** ***************************************************************************
+ * @brief Read the low 16bit of a word "in the flash memory"
+ *
+ * @param [in] pAddress: address of the word
+ * @return value
+ *****************************************************************************/
+static inline uint16_t Sim_ReadWord(const void* pAddress)
+{
+	uint16_t uiValue;
+
+	memcpy(&uiValue, pAddress, sizeof(uiValue));
+	return uiValue;
+}
+
+#endif /* SIM_AVR_PGMSPACE_H_ */
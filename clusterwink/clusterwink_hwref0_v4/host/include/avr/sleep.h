@@ -0,0 +1,31 @@
+/** ***************************************************************************
+ * @file sleep.h
+ * @brief Host replacement of <avr/sleep.h>
+ *
+ * The sleep mode and the sleep enable bit are kept in SMCR. Sleeping with
+ * SE set is handed to the peripheral model, which delivers the next
+ * interrupt (see Sim_Sleep()). Without SE the sleep instruction does nothing,
+ * like on the uC.
+ *
+ * @author agent
+ * @date 16.10.2026
+ *****************************************************************************/
+
+
+#ifndef SIM_AVR_SLEEP_H_
+#define SIM_AVR_SLEEP_H_
+
+#include <avr/io.h>
+
+#define SLEEP_MODE_IDLE			0
+#define SLEEP_MODE_ADC			(1<<SM0)
+#define SLEEP_MODE_PWR_DOWN		(1<<SM1)
+
+void Sim_Sleep(void);
+
+#define set_sleep_mode(mode)	(SMCR = (uint8_t)((SMCR & ~((1<<SM0) | (1<<SM1) | (1<<SM2))) | (mode)))
+#define sleep_enable()			(SMCR |= (1<<SE))
+#define sleep_disable()			(SMCR &= (uint8_t)~(1<<SE))
+#define sleep_cpu()				Sim_Sleep()
+
+#endif /* SIM_AVR_SLEEP_H_ */
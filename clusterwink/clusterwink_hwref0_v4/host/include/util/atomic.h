@@ -0,0 +1,59 @@
+/** ***************************************************************************
+ * @file atomic.h
+ * @brief Host replacement of <util/atomic.h>
+ *
+ * Same construction as avr-libc: the for loop runs its body exactly once with
+ * the global interrupt flag cleared and restores SREG afterwards.
+ *
+ * A translation unit that defines BENCH_IRQ_TRACE before the include reports
+ * every enable -> disable and disable -> enable transition of the global
+ * interrupt flag to Bench_IrqOff() and Bench_IrqOn() (bench.c) while
+ * ucBenchIrqTrace is set. They record the time the interrupts were disabled.
+ *
+ * @author agent
+ * @date 16.10.2026
+ *****************************************************************************/
+
+
+#ifndef SIM_UTIL_ATOMIC_H_
+#define SIM_UTIL_ATOMIC_H_
+
+#include <avr/io.h>
+
+#if defined(BENCH_IRQ_TRACE)
+extern volatile uint8_t ucBenchIrqTrace;
+void Bench_IrqOff(void);
+void Bench_IrqOn(void);
+#define __IRQ_TRACE_OFF()		do { if(ucBenchIrqTrace && (SREG & 0x80)) { Bench_IrqOff(); } } while(0)
+#define __IRQ_TRACE_ON(s)		do { if(ucBenchIrqTrace && ((s) & 0x80) && !(SREG & 0x80)) { Bench_IrqOn(); } } while(0)
+#else
+#define __IRQ_TRACE_OFF()
+#define __IRQ_TRACE_ON(s)
+#endif
+
+static inline uint8_t __iCliRetVal(void)
+{
+	__IRQ_TRACE_OFF();
+	SREG &= (uint8_t)~0x80;
+	return 1;
+}
+
+static inline void __iRestore(const uint8_t *__s)
+{
+	__IRQ_TRACE_ON(*__s);
+	SREG = *__s;
+}
+
+static inline void __iSeiParam(const uint8_t *__s)
+{
+	(void)__s;
+	__IRQ_TRACE_ON(0x80);
+	SREG |= 0x80;
+}
+
+#define ATOMIC_RESTORESTATE		uint8_t sreg_save __attribute__((__cleanup__(__iRestore))) = SREG
+#define ATOMIC_FORCEON			uint8_t sreg_save __attribute__((__cleanup__(__iSeiParam))) = 0
+
+#define ATOMIC_BLOCK(type)		for ( type, __ToDo = __iCliRetVal(); __ToDo ; __ToDo = 0 )
+
+#endif /* SIM_UTIL_ATOMIC_H_ */
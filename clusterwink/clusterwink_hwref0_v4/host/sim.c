@@ -0,0 +1,426 @@
+/** ***************************************************************************
+ * @file sim.c
+ * @brief Simulated ATmega328 peripherals for the host (Linux) build
+ *
+ * @author agent
+ * @date 16.10.2026
+ *****************************************************************************/
+
+
+#include <string.h>
+#include <avr/io.h>
+#include "rgbooster.h"
+#include "sim.h"
+
+
+///////////////////////////////////////////////////////////////////////////////
+// REGISTER FILE
+///////////////////////////////////////////////////////////////////////////////
+
+volatile uint8_t SREG;
+volatile uint8_t PINB, DDRB, PORTB;
+volatile uint8_t PINC, DDRC, PORTC;
+volatile uint8_t PIND, DDRD;
+volatile uint8_t TCCR0A, TCCR0B, TCNT0, OCR0A, OCR0B, TIMSK0, TIFR0;
+volatile uint8_t TCCR1A, TCCR1B, TCCR1C, TIMSK1, TIFR1;
+volatile uint16_t TCNT1, OCR1A, OCR1B, ICR1;
+volatile uint8_t TCCR2A, TCCR2B, OCR2A, OCR2B, TIMSK2, TIFR2, ASSR;
+volatile uint8_t ADMUX, ADCSRB, ADCL, ADCH, DIDR0;
+volatile uint16_t ADCW;
+volatile uint8_t EICRA, EIMSK, EIFR;
+volatile uint8_t SPCR, SPSR, SPDR;
+volatile uint8_t UCSR0B, UCSR0C, UDR0;
+volatile uint16_t UBRR0;
+volatile uint8_t SMCR;
+
+volatile uint8_t Sim_ucPORTD;			///< storage of PORTD
+uint8_t Sim_ucPORTDLatch = (1<<SEND);	///< PORTD pin which latches the RGBooster data
+static volatile uint8_t ucADCSRA;		///< storage of ADCSRA
+static volatile uint8_t ucUCSR0A;		///< storage of UCSR0A
+volatile uint8_t Sim_ucTCNT2;			///< storage of TCNT2
+
+SIM sSim;								///< state of the peripheral model
+unsigned long ulSimEEPROMWrites = 0;	///< amount of bytes written to the EEPROM (kept over Sim_Reset() like the EEPROM)
+
+
+///////////////////////////////////////////////////////////////////////////////
+// REGISTERS WITH SIDE EFFECTS
+///////////////////////////////////////////////////////////////////////////////
+
+
+/** ***************************************************************************
+ * @brief Send pulse on PORTD
+ *
+ * The send pin is set and cleared with two consecutive accesses. If the pin
+ * is still high at the time of an access (Sim_PORTD() in avr/io.h), the
+ * rising edge has happened and the RGBooster latches the data lines.
+ *
+ * @param [void] no input
+ * @return no return value
+ *****************************************************************************/
+void Sim_LatchPORTD(void)
+{
+	if(sSim.uiStripCount < SIM_STRIP_SIZE)
+	{
+		sSim.aucStrip[sSim.uiStripCount] = (Sim_ucPORTD & DATA_HIGH_BITMASK) | (PORTC & DATA_LOW_BITMASK);
+		sSim.uiStripCount++;
+	}
+	sSim.ulBytesSent++;
+	sSim.ucHandshakePending = 1;
+	Sim_ucPORTD &= ~(1<<SEND);
+}
+
+
+/** ***************************************************************************
+ * @brief Access to ADCSRA
+ *
+ * A started single conversion completes immediately with sSim.uiADCValue.
+ * Auto triggered conversions (ADATE) are completed by Sim_RunADC().
+ *
+ * @param [void] no input
+ * @return pointer to the register storage
+ *****************************************************************************/
+volatile uint8_t* Sim_ADCSRA(void)
+{
+	if((ucADCSRA & (1<<ADEN)) && (ucADCSRA & (1<<ADSC)) && !(ucADCSRA & (1<<ADATE)))
+	{
+		ADCW = sSim.uiADCValue & 0x3FF;
+		if(ADMUX & (1<<ADLAR))
+		{
+			ADCW = (uint16_t)(ADCW << 6);
+		}
+		ADCL = (uint8_t)ADCW;
+		ADCH = (uint8_t)(ADCW >> 8);
+		ucADCSRA = (ucADCSRA & ~(1<<ADSC)) | (1<<ADIF);
+	}
+	return &ucADCSRA;
+}
+
+
+/** ***************************************************************************
+ * @brief Access to UCSR0A
+ *
+ * Transmitted bytes are discarded, the data register is always empty.
+ *
+ * @param [void] no input
+ * @return pointer to the register storage
+ *****************************************************************************/
+volatile uint8_t* Sim_UCSR0A(void)
+{
+	ucUCSR0A |= (1<<UDRE0);
+	return &ucUCSR0A;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+// PERIPHERAL MODEL
+///////////////////////////////////////////////////////////////////////////////
+
+
+/** ***************************************************************************
+ * @brief Reset all registers and the peripheral model
+ *
+ * @param [void] no input
+ * @return no return value
+ *****************************************************************************/
+void Sim_Reset(void)
+{
+	SREG = 0;
+	PINB = DDRB = PORTB = 0;
+	PINC = DDRC = PORTC = 0;
+	PIND = DDRD = Sim_ucPORTD = 0;
+	TCCR0A = TCCR0B = TCNT0 = OCR0A = OCR0B = TIMSK0 = TIFR0 = 0;
+	TCCR1A = TCCR1B = TCCR1C = TIMSK1 = TIFR1 = 0;
+	TCNT1 = OCR1A = OCR1B = ICR1 = 0;
+	TCCR2A = TCCR2B = Sim_ucTCNT2 = OCR2A = OCR2B = TIMSK2 = TIFR2 = ASSR = 0;
+	ADMUX = ADCSRB = ADCL = ADCH = DIDR0 = ucADCSRA = 0;
+	ADCW = 0;
+	EICRA = EIMSK = EIFR = 0;
+	SPCR = SPSR = SPDR = 0;
+	ucUCSR0A = UCSR0B = UCSR0C = UDR0 = 0;
+	UBRR0 = 0;
+	SMCR = 0;
+
+	memset(&sSim, 0, sizeof(sSim));
+	sSim.uiADCValue = 0x200;
+}
+
+
+/** ***************************************************************************
+ * @brief Transfer one byte from the master (RPi)
+ *
+ * ISR(SPI_STC_vect) is called if the SPI interrupt and the global interrupt
+ * flag are enabled.
+ *
+ * @param [in] ucMOSI: byte sent by the master
+ * @return byte received by the master (SPDR of the previous transfer)
+ *****************************************************************************/
+unsigned char Sim_SPITransfer(unsigned char ucMOSI)
+{
+	unsigned char ucMISO = sSim.ucSPIShift;
+
+	SPDR = ucMOSI;
+	if((SPCR & (1<<SPIE)) && (SPCR & (1<<SPE)) && (SREG & 0x80))
+	{
+		SPI_STC_vect();
+	}
+	sSim.ucSPIShift = SPDR;
+
+	return ucMISO;
+}
+
+
+/** ***************************************************************************
+ * @brief Transfer multiple bytes from the master (RPi)
+ *
+ * @param [in] pucData: bytes sent by the master
+ * @param [in] uiLength: amount of bytes
+ * @return no return value
+ *****************************************************************************/
+void Sim_SPISend(const unsigned char* pucData, unsigned int uiLength)
+{
+	unsigned int i;
+
+	for(i=0;i<uiLength;i++)
+	{
+		Sim_SPITransfer(pucData[i]);
+	}
+}
+
+
+/** ***************************************************************************
+ * @brief Deliver RGBooster handshakes to ISR(INT1_vect) until the strip is idle
+ *
+ * @param [void] no input
+ * @return amount of handshakes delivered
+ *****************************************************************************/
+unsigned int Sim_RunRGBooster(void)
+{
+	unsigned int uiCount = 0;
+
+	while(sSim.ucHandshakePending)
+	{
+		sSim.ucHandshakePending = 0;
+		if((EIMSK & (1<<INT1)) && (SREG & 0x80))
+		{
+			INT1_vect();
+			uiCount++;
+		}
+	}
+	return uiCount;
+}
+
+
+/** ***************************************************************************
+ * @brief Deliver a single RGBooster handshake to ISR(INT1_vect)
+ *
+ * @param [void] no input
+ * @return 1 if a handshake was pending, 0 if the strip is idle
+ *****************************************************************************/
+unsigned char Sim_StepRGBooster(void)
+{
+	if(!sSim.ucHandshakePending)
+	{
+		return 0;
+	}
+	sSim.ucHandshakePending = 0;
+	if((EIMSK & (1<<INT1)) && (SREG & 0x80))
+	{
+		INT1_vect();
+	}
+	return 1;
+}
+
+
+/** ***************************************************************************
+ * @brief Complete conversions of the free running ADC
+ *
+ * Every conversion stores sSim.uiADCValue (plus sSim.pcADCNoise[], if set)
+ * and calls ISR(ADC_vect) if the ADC interrupt and the global interrupt flag
+ * are enabled.
+ *
+ * @param [in] uiConversions: amount of conversions
+ * @return no return value
+ *****************************************************************************/
+void Sim_RunADC(unsigned int uiConversions)
+{
+	unsigned int i;
+	int iValue;
+
+	for(i=0;i<uiConversions;i++)
+	{
+		if(!(ucADCSRA & (1<<ADEN)) || !(ucADCSRA & (1<<ADSC)))
+		{
+			return;
+		}
+		iValue = (int)sSim.uiADCValue;
+		if(sSim.pcADCNoise)
+		{
+			iValue += sSim.pcADCNoise[sSim.ulADCSample % sSim.uiADCNoiseLength];
+		}
+		sSim.ulADCSample++;
+		iValue = (iValue < 0) ? 0 : ((iValue > 0x3FF) ? 0x3FF : iValue);
+		ADCW = (uint16_t)iValue;
+		if(ADMUX & (1<<ADLAR))
+		{
+			ADCW = (uint16_t)(ADCW << 6);
+		}
+		ADCL = (uint8_t)ADCW;
+		ADCH = (uint8_t)(ADCW >> 8);
+		ucADCSRA |= (1<<ADIF);
+		if((ucADCSRA & (1<<ADIE)) && (SREG & 0x80))
+		{
+			ucADCSRA &= ~(1<<ADIF); // cleared when the vector is executed
+			ADC_vect();
+		}
+	}
+}
+
+
+/** ***************************************************************************
+ * @brief Advance the running timer0 by compare matches (system ticks)
+ *
+ * Every compare match calls ISR(TIMER0_COMPA_vect) if the compare match
+ * interrupt and the global interrupt flag are enabled, otherwise it sets
+ * OCF0A.
+ *
+ * @param [in] uiTicks: amount of compare matches
+ * @return no return value
+ *****************************************************************************/
+void Sim_RunTicks(unsigned int uiTicks)
+{
+	unsigned int i;
+
+	for(i=0;i<uiTicks;i++)
+	{
+		if(!(TCCR0B & 0x07)) // timer stopped
+		{
+			return;
+		}
+		sSim.ulTicks++;
+		if((TIMSK0 & (1<<OCIE0A)) && (SREG & 0x80))
+		{
+			TIMER0_COMPA_vect();
+		}
+		else
+		{
+			TIFR0 |= (1<<OCF0A);
+		}
+	}
+}
+
+
+/** ***************************************************************************
+ * @brief Run PWM periods of timer1
+ *
+ * The OCR1A value of every period is added to sSim.ulPWMSum. At the end of
+ * the period ISR(TIMER1_OVF_vect) is called if the overflow interrupt and
+ * the global interrupt flag are enabled, otherwise TOV1 is set.
+ *
+ * @param [in] uiPeriods: amount of PWM periods
+ * @return no return value
+ *****************************************************************************/
+void Sim_RunPWM(unsigned int uiPeriods)
+{
+	unsigned int i;
+
+	for(i=0;i<uiPeriods;i++)
+	{
+		if(!(TCCR1B & 0x07)) // timer stopped
+		{
+			return;
+		}
+		sSim.ulPWMSum += OCR1A;
+		sSim.ulPWMPeriods++;
+		if((TIMSK1 & (1<<TOIE1)) && (SREG & 0x80))
+		{
+			TIMER1_OVF_vect();
+		}
+		else
+		{
+			TIFR1 |= (1<<TOV1);
+		}
+	}
+}
+
+
+/** ***************************************************************************
+ * @brief Timer2 overflow
+ *
+ * Calls ISR(TIMER2_OVF_vect) if the overflow interrupt is enabled, otherwise
+ * it sets TOV2.
+ *
+ * @param [void] no input
+ * @return no return value
+ *****************************************************************************/
+void Sim_OverflowTimer2(void)
+{
+#ifdef INSTRUMENTATION
+	if(TIMSK2 & (1<<TOIE2))
+	{
+		TIMER2_OVF_vect();
+		return;
+	}
+#endif
+	TIFR2 |= (1<<TOV2);
+}
+
+
+/** ***************************************************************************
+ * @brief Advance the running timer2 by ticks
+ *
+ * Overflows are handled by Sim_OverflowTimer2().
+ *
+ * @param [in] uiTicks: amount of timer2 ticks
+ * @return no return value
+ *****************************************************************************/
+void Sim_RunTimer2(unsigned int uiTicks)
+{
+	unsigned int i;
+
+	for(i=0;i<uiTicks;i++)
+	{
+		if(!(TCCR2B & 0x07)) // timer stopped
+		{
+			return;
+		}
+		Sim_ucTCNT2++;
+		if(Sim_ucTCNT2==0)
+		{
+			Sim_OverflowTimer2();
+		}
+	}
+}
+
+
+/** ***************************************************************************
+ * @brief Discard the recorded RGBooster bytes
+ *
+ * @param [void] no input
+ * @return no return value
+ *****************************************************************************/
+void Sim_ClearStrip(void)
+{
+	sSim.uiStripCount = 0;
+}
+
+
+/** ***************************************************************************
+ * @brief Sleep instruction
+ *
+ * With the sleep enable bit set the CPU sleeps until the next interrupt. The
+ * model delivers the next system tick. The interrupts have to be enabled,
+ * otherwise the CPU would never wake up.
+ *
+ * @param [void] no input
+ * @return no return value
+ *****************************************************************************/
+void Sim_Sleep(void)
+{
+	if(!(SMCR & (1<<SE)))
+	{
+		return;
+	}
+	sSim.ulSleeps++;
+	Sim_RunTicks(1);
+}
@@ -0,0 +1,98 @@
+/** ***************************************************************************
+ * @file sim.h
+ * @brief Simulated ATmega328 peripherals for the host (Linux) build
+ *
+ * The register file of <avr/io.h> is replaced by variables (see
+ * include/avr/io.h). This file models the behavior behind them:
+ *
+ * - SPI
+ * @n The RPi (master) side of a transfer. The received byte is written to
+ * SPDR, ISR(SPI_STC_vect) is called and the byte left in SPDR is shifted out
+ * during the next transfer.
+ *
+ * - RGBooster
+ * @n Every send pulse latches the byte on the data lines (PORTD high nibble,
+ * PORTC low nibble) and raises a handshake which is delivered to
+ * ISR(INT1_vect) by Sim_RunRGBooster().
+ *
+ * - ADC
+ * @n Single conversions complete on the next poll of the flag. Free running
+ * conversions are delivered to ISR(ADC_vect) by Sim_RunADC().
+ *
+ * - timer0
+ * @n Compare matches (1ms system ticks) are delivered to
+ * ISR(TIMER0_COMPA_vect) by Sim_RunTicks().
+ *
+ * - timer1
+ * @n PWM periods are run by Sim_RunPWM(). The OCR1A value of every period is
+ * summed up and the overflow is delivered to ISR(TIMER1_OVF_vect).
+ *
+ * - sleep
+ * @n The only interrupt source that runs on its own is the system tick, so a
+ * sleeping CPU is woken up by the next tick (Sim_Sleep()). SPI bytes and
+ * RGBooster handshakes are delivered by the benchmark between two sleeps.
+ *
+ * - timer2
+ * @n Advances by one tick per access of TCNT2. Reading the host cycle
+ * counter in every ISR would distort the measured costs, so an instrumented
+ * section of the firmware without nested timestamps lasts exactly one tick.
+ * Longer sections are simulated with Sim_RunTimer2(). The overflow calls
+ * ISR(TIMER2_OVF_vect) at once, also inside a critical section: the
+ * timestamp is the same as with a pending overflow (instrumentation only).
+ *
+ * @author agent
+ * @date 16.10.2026
+ *****************************************************************************/
+
+
+#ifndef SIM_H_
+#define SIM_H_
+
+#include <stdint.h>
+
+#define SIM_STRIP_SIZE		4096	///< amount of RGBooster bytes recorded
+
+
+/** State of the simulated peripherals which is not part of the register file */
+typedef struct
+{
+	unsigned char aucStrip[SIM_STRIP_SIZE];	///< bytes latched by the RGBooster (wire order)
+	unsigned int uiStripCount;				///< amount of bytes in aucStrip
+	unsigned long ulBytesSent;				///< total amount of latched bytes
+	unsigned char ucHandshakePending;		///< RGBooster finished a byte, INT1 not serviced yet
+	unsigned char ucSPIShift;				///< byte shifted out to the master on the next transfer
+	unsigned int uiADCValue;				///< 10bit result of the next conversion
+	const signed char* pcADCNoise;			///< noise added to the conversions (cyclic), 0: none
+	unsigned int uiADCNoiseLength;			///< amount of entries of pcADCNoise
+	unsigned long ulADCSample;				///< amount of free running conversions
+	unsigned long ulTicks;					///< amount of timer0 compare matches
+	unsigned long ulPWMSum;					///< sum of OCR1A over the PWM periods
+	unsigned long ulPWMPeriods;				///< amount of timer1 PWM periods
+	unsigned long ulSleeps;					///< amount of sleep instructions with SE set
+} SIM;
+
+extern SIM sSim;
+
+void Sim_Reset(void);
+unsigned char Sim_SPITransfer(unsigned char ucMOSI);
+void Sim_SPISend(const unsigned char* pucData, unsigned int uiLength);
+unsigned int Sim_RunRGBooster(void);
+unsigned char Sim_StepRGBooster(void);
+void Sim_ClearStrip(void);
+void Sim_RunADC(unsigned int uiConversions);
+void Sim_RunTicks(unsigned int uiTicks);
+void Sim_RunPWM(unsigned int uiPeriods);
+void Sim_RunTimer2(unsigned int uiTicks);
+void Sim_Sleep(void);
+
+// interrupt vectors implemented by the firmware
+void SPI_STC_vect(void);
+void INT1_vect(void);
+void ADC_vect(void);
+void TIMER0_COMPA_vect(void);
+void TIMER1_OVF_vect(void);
+#ifdef INSTRUMENTATION
+void TIMER2_OVF_vect(void);
+#endif
+
+#endif /* SIM_H_ */
@@ -0,0 +1,130 @@
+/** ***************************************************************************
+ * @file instrument.c
+ * @brief Optional timing and load instrumentation readable over SPI
+ *
+ * Enabled with the compiler symbol INSTRUMENTATION (Debug configuration and
+ * host build). Without it all macros are empty and no timer is used.
+ *
+ * Timer2 is not used by anything else. It runs in normal mode, only its
+ * overflow interrupt is enabled to count the high byte of the timestamps.
+ *
+ * @author agent
+ * @date 16.10.2026
+ *****************************************************************************/
+
+
+#include <avr/interrupt.h>
+#include <util/atomic.h>
+#include "instrument.h"
+
+#ifdef INSTRUMENTATION
+
+volatile INSTR sInstr;			///< instrumentation data (ISR)
+
+
+/** ***************************************************************************
+ * @brief Clear the instrumentation data and start the free running timer2
+ *
+ * @param [void] no input
+ * @return no return value
+ *****************************************************************************/
+void Instr_Init(void)
+{
+	unsigned char i;
+
+	for(i=0;i<INSTR_TIMINGS;i++)
+	{
+		sInstr.asTiming[i].ucMax = 0;
+		sInstr.asTiming[i].uiAverage = 0;
+	}
+	sInstr.ucQueueMax = 0;
+	sInstr.ucDropped = 0;
+	sInstr.ucOverrun = 0;
+	sInstr.ucFrames = 0;
+	sInstr.ucSaturated = 0;
+	sInstr.ucOverflows = 0;
+
+	TCCR2A = 0;				// normal mode, no outputs
+	TCCR2B = 0;
+	TCNT2 = 0;
+	TIMSK2 = (1<<TOIE2);	// overflow interrupt
+	TCCR2B = (1<<CS21);		// set prescaler to 8
+}
+
+
+/** ***************************************************************************
+ * @brief Timer2 overflow, counts the high byte of the timestamps
+ *
+ * @param [in] TIMER2_OVF_vect: "Timer/Counter2 Overflow" vector
+ * @return no return value
+ *****************************************************************************/
+ISR(TIMER2_OVF_vect)
+{
+	sInstr.ucOverflows++;
+}
+
+
+/** ***************************************************************************
+ * @brief Read an instrumentation register
+ *
+ * Called by ISR(SPI_STC_vect). Maximum, high-water mark and saturation flags
+ * restart with the read, so every read returns the peak since the previous
+ * one.
+ *
+ * @param [in] ucRegister: INSTR_REG_*
+ * @return register value, 0 for unknown registers
+ *****************************************************************************/
+unsigned char Instr_Read(unsigned char ucRegister)
+{
+	unsigned char ucValue = 0;
+	unsigned char ucSection = ucRegister>>1;
+
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+	{
+		if(ucRegister<=INSTR_REG_COMMANDS_AVG)	// pairs of maximum and average
+		{
+			if(ucRegister & 0x01)
+			{
+				ucValue = (unsigned char)(sInstr.asTiming[ucSection].uiAverage>>4);
+			}
+			else
+			{
+				ucValue = sInstr.asTiming[ucSection].ucMax;
+				sInstr.asTiming[ucSection].ucMax = 0;
+			}
+		}
+		else
+		{
+			switch(ucRegister)
+			{
+				case INSTR_REG_QUEUE_MAX:
+				ucValue = sInstr.ucQueueMax;
+				sInstr.ucQueueMax = 0;
+				break;
+
+				case INSTR_REG_DROPPED:
+				ucValue = sInstr.ucDropped;
+				break;
+
+				case INSTR_REG_OVERRUN:
+				ucValue = sInstr.ucOverrun;
+				break;
+
+				case INSTR_REG_FRAMES:
+				ucValue = sInstr.ucFrames;
+				break;
+
+				case INSTR_REG_SATURATED:
+				ucValue = sInstr.ucSaturated;
+				sInstr.ucSaturated = 0;
+				break;
+
+				default:
+				break;
+			}
+		}
+	}
+	return ucValue;
+}
+
+#endif /* INSTRUMENTATION */
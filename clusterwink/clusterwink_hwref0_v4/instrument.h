@@ -0,0 +1,156 @@
+/** ***************************************************************************
+ * @file instrument.h
+ * @brief Optional timing and load instrumentation readable over SPI
+ *
+ * Enabled with the compiler symbol INSTRUMENTATION (Debug configuration and
+ * host build). Without it all macros are empty and no timer is used.
+ *
+ * - Timing
+ * @n Timer2 runs free with prescaler 8 (1 tick = 8 cycles = 0.4us), its
+ * overflow interrupt counts the high byte of a 16bit timestamp (one short
+ * ISR every 102us). The ISRs and processCommands() take a timestamp at entry
+ * and exit, the difference is kept as maximum and moving average (1/16
+ * weight). Durations above 255 ticks (102us) are saturated at 255 and
+ * flagged in INSTR_REG_SATURATED. The prologue/epilogue of the ISRs is not
+ * included.
+ *
+ * - Load
+ * @n High-water mark of the command queue, commands dropped because the queue
+ * was full, data bytes without a receiving command (dropped commands, surplus
+ * bytes, rejected uploads) and frames sent to the strip.
+ *
+ * The registers are read with [0x8C, RR, 0x00] (RR: INSTR_REG_*). Maximum,
+ * high-water mark and saturation flags restart with every read, the event
+ * counters wrap around (the RPi evaluates the difference between two reads).
+ *
+ * @author agent
+ * @date 16.10.2026
+ *****************************************************************************/
+
+
+#ifndef INSTRUMENT_H_
+#define INSTRUMENT_H_
+
+#define INSTR_SPI				0		///< timing: ISR(SPI_STC_vect)
+#define INSTR_INT1				1		///< timing: ISR(INT1_vect)
+#define INSTR_COMMANDS			2		///< timing: processCommands() (including interrupts)
+#define INSTR_TIMINGS			3		///< amount of measured sections
+
+#define INSTR_REG_SPI_MAX		0x00	///< register: ISR(SPI_STC_vect) maximum [ticks]
+#define INSTR_REG_SPI_AVG		0x01	///< register: ISR(SPI_STC_vect) average [ticks]
+#define INSTR_REG_INT1_MAX		0x02	///< register: ISR(INT1_vect) maximum [ticks]
+#define INSTR_REG_INT1_AVG		0x03	///< register: ISR(INT1_vect) average [ticks]
+#define INSTR_REG_COMMANDS_MAX	0x04	///< register: processCommands() maximum [ticks]
+#define INSTR_REG_COMMANDS_AVG	0x05	///< register: processCommands() average [ticks]
+#define INSTR_REG_QUEUE_MAX		0x06	///< register: command queue high-water mark [records]
+#define INSTR_REG_DROPPED		0x07	///< register: dropped commands (wrapping)
+#define INSTR_REG_OVERRUN		0x08	///< register: discarded data bytes (wrapping)
+#define INSTR_REG_FRAMES		0x09	///< register: frames sent to the strip (wrapping)
+#define INSTR_REG_SATURATED		0x0A	///< register: sections whose maximum was saturated (bit 1<<INSTR_*)
+#define INSTR_REGISTERS			0x0B	///< amount of registers, others read 0
+
+
+#ifdef INSTRUMENTATION
+
+#include <avr/io.h>
+#include <avr/interrupt.h>
+
+/** Timing of one section */
+typedef struct
+{
+	unsigned char ucMax;		///< maximum since the last read [ticks]
+	unsigned int uiAverage;		///< moving average [1/16 ticks]
+} INSTR_TIMING;
+
+/** Instrumentation data (written by the ISRs and the main loop) */
+typedef struct
+{
+	INSTR_TIMING asTiming[INSTR_TIMINGS];	///< timing of the sections
+	unsigned char ucQueueMax;				///< command queue high-water mark since the last read
+	unsigned char ucDropped;				///< dropped commands
+	unsigned char ucOverrun;				///< discarded data bytes
+	unsigned char ucFrames;					///< frames sent
+	unsigned char ucSaturated;				///< sections saturated since the last read (bit 1<<INSTR_*)
+	unsigned char ucOverflows;				///< timer2 overflows (high byte of the timestamp)
+} INSTR;
+
+extern volatile INSTR sInstr;
+
+void Instr_Init(void);
+unsigned char Instr_Read(unsigned char ucRegister);
+
+
+/** ***************************************************************************
+ * @brief Take a 16bit timestamp
+ *
+ * An overflow which is pending (TOV2 set, ISR(TIMER2_OVF_vect) not executed
+ * yet, e.g. inside another ISR) is added if the counter has already wrapped.
+ *
+ * @param [void] no input
+ * @return timestamp [ticks]
+ *****************************************************************************/
+static inline unsigned int Instr_Now(void)
+{
+	unsigned char ucSREG = SREG;
+	unsigned char ucLow;
+	unsigned char ucHigh;
+
+	cli();
+	ucLow = TCNT2;
+	ucHigh = sInstr.ucOverflows;
+	if((TIFR2 & (1<<TOV2)) && (ucLow<0x80))
+	{
+		ucHigh++;
+	}
+	SREG = ucSREG;
+	return ((unsigned int)ucHigh << 8) | ucLow;
+}
+
+
+/** ***************************************************************************
+ * @brief Add a duration to the timing of a section
+ *
+ * Called with interrupts disabled (ISRs) or from the main loop, an ISR
+ * measures its own sections only. Durations above 255 ticks are saturated.
+ *
+ * @param [in] ucSection: INSTR_SPI, INSTR_INT1 or INSTR_COMMANDS
+ * @param [in] uiStart: timestamp at the start of the section (Instr_Now())
+ * @return no return value
+ *****************************************************************************/
+static inline void Instr_Record(unsigned char ucSection, unsigned int uiStart)
+{
+	volatile INSTR_TIMING* sTiming_ptr = &sInstr.asTiming[ucSection];
+	unsigned int uiTicks = Instr_Now() - uiStart;
+	unsigned char ucTicks = (unsigned char)uiTicks;
+
+	if(uiTicks>0xFF)
+	{
+		ucTicks = 0xFF;
+		sInstr.ucSaturated |= (1<<ucSection);
+	}
+	if(ucTicks>sTiming_ptr->ucMax)
+	{
+		sTiming_ptr->ucMax = ucTicks;
+	}
+	sTiming_ptr->uiAverage = sTiming_ptr->uiAverage - (sTiming_ptr->uiAverage>>4) + ucTicks;
+}
+
+#define INSTR_INIT()				Instr_Init()							///< clear the data and start timer2
+#define INSTR_READ(reg)				Instr_Read(reg)							///< read a register (ISR)
+#define INSTR_ENTRY()				unsigned int uiInstrStart = Instr_Now()	///< timestamp at the start of a section (declaration)
+#define INSTR_EXIT(section)			Instr_Record((section), uiInstrStart)	///< record the section started by INSTR_ENTRY()
+#define INSTR_COUNT(counter)		(sInstr.counter++)						///< count an event (ucDropped, ucOverrun, ucFrames)
+#define INSTR_QUEUE(count)			do { if((count)>sInstr.ucQueueMax) { sInstr.ucQueueMax = (count); } } while(0)	///< update the high-water mark
+
+#else
+
+#define INSTR_INIT()
+#define INSTR_READ(reg)				0
+#define INSTR_ENTRY()
+#define INSTR_EXIT(section)
+#define INSTR_COUNT(counter)
+#define INSTR_QUEUE(count)
+
+#endif /* INSTRUMENTATION */
+
+#endif /* INSTRUMENT_H_ */
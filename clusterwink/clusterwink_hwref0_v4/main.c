@@ -187,30 +187,450 @@
 
 #include <avr/io.h>
 #include <avr/interrupt.h>
+#include <util/atomic.h>
+#include <avr/eeprom.h>
 #include "utils.h"
 #include "spi.h"
 #include "usart.h"
-#include "ringbuffer.h"
+#include "cmdqueue.h"
+#include "crc8.h"
+#include "thermal.h"
+#include "scheduler.h"
+#include "sunrise.h"
+#include "effects.h"
+#include "color.h"
+#include "scene.h"
+#include "gamma.h"
+#include "instrument.h"
 #include "rgbooster.h"
+#include "main.h"
 
 
-#define LED_COUNT		20		///< RGB LED strip length
+#define RX_LEGACY		0		///< receive state: legacy protocol, bit 7 marks a command
+#define RX_OPCODE		1		///< receive state: frame started, opcode expected
+#define RX_LENGTH		2		///< receive state: payload length expected
+#define RX_PAYLOAD		3		///< receive state: payload bytes expected
+#define RX_CRC			4		///< receive state: checksum expected
 
-volatile unsigned char aucRed[LED_COUNT] =		{0xFF,0xFF,0xFF,0xFF,0xFF,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0xFF,0xFF,0xFF,0xFF,0xFF}; ///< red data buffer used by ISR for RGB LEDs
-volatile unsigned char aucGreen[LED_COUNT] =	{0x00,0x00,0x00,0x00,0x00,0xFF,0xFF,0xFF,0xFF,0xFF,0x00,0x00,0x00,0x00,0x00,0xFF,0xFF,0xFF,0xFF,0xFF}; ///< green data buffer used by ISR for RGB LEDs
-volatile unsigned char aucBlue[LED_COUNT] =		{0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF}; ///< blue data buffer used by ISR for RGB LEDs
+#define BACK_FREE		0		///< back frame owner: nobody is writing
+#define BACK_MAIN		1		///< back frame owner: main loop (commands, effects)
+#define BACK_UPLOAD		2		///< back frame owner: frame upload of the SPI ISR
 
-volatile unsigned char ucRGBIdx = LED_COUNT;		///< RGB LED counter variable (ISR)
-volatile unsigned char ucByteIdx = 0;				///< byte counter for color (ISR)
+#define UPLOAD_RED			0		///< next byte of a frame upload: red of a LED
+#define UPLOAD_GREEN		1		///< next byte of a frame upload: green of a LED
+#define UPLOAD_BLUE			2		///< next byte of a frame upload: blue of a LED
+#define UPLOAD_PAL8			3		///< next byte of a frame upload: 8bit palette index
+#define UPLOAD_PAL4_LOW		4		///< next byte of a frame upload: 4bit palette index, low nibble
+#define UPLOAD_PAL4_HIGH	5		///< next byte of a frame upload: 4bit palette index, high nibble
+
+static unsigned char aucFramePool[FRAME_POOL_SIZE];	///< framebuffers: palette (if any), then the frames (wire order G,R,B,... or palette indices)
+static unsigned char* volatile ucFront_ptr = aucFramePool;	///< frame sent to the RGB LEDs (ISR)
+static unsigned char* volatile ucBack_ptr = aucFramePool;	///< frame written by the commands (main loop), same as the front frame with STORAGE_SINGLE
+static volatile unsigned int uiLEDCount = 0;				///< strip length [LEDs] (ISR)
+static volatile unsigned int uiFrameSize = 0;				///< bytes per frame (ISR)
+static volatile unsigned int uiUploadSize = 0;				///< payload bytes of a full frame upload (ISR)
+static volatile unsigned char ucStorage = STORAGE_DOUBLE;	///< storage mode of the framebuffers (ISR)
+static volatile unsigned char ucFormat = FORMAT_GRB;		///< framebuffer format (ISR)
+static uint16_t EEMEM uiLEDCountEE = LED_COUNT_DEFAULT;		///< stored strip length (EEPROM)
+static uint8_t EEMEM ucFormatEE = FORMAT_GRB;				///< stored framebuffer format (EEPROM)
+static unsigned char ucLayoutStore = 0;						///< bytes of the layout still to be stored in the EEPROM (see storeLayout())
+
+/** Maximum strip length per format and storage mode [FORMAT_*][STORAGE_*] */
+static const unsigned int auiLengthMax[FORMATS][2] =
+{
+	{LED_COUNT_MAX_GRB/2, LED_COUNT_MAX_GRB},
+	{LED_COUNT_MAX_PAL8/2, LED_COUNT_MAX_PAL8},
+	{LED_COUNT_MAX/2, LED_COUNT_MAX}
+};
+
+volatile unsigned char ucSwapPending = 0;			///< back frame latched, swap at the next frame boundary (ISR)
+volatile unsigned char ucBackStale = 1;				///< back frame does not contain the last latched frame (ISR)
+static volatile unsigned char ucBackOwner = BACK_FREE;	///< writer of the back frame (ISR)
+static unsigned char* ucUpload_ptr = 0;				///< LED of the back frame being uploaded (ISR)
+static unsigned char* ucUploadEnd_ptr = 0;			///< end of the back frame being uploaded (ISR)
+static unsigned char ucUploadColor = UPLOAD_RED;	///< next byte of the upload (UPLOAD_*) (ISR)
+static unsigned int uiUploadLeft = 0;				///< palette indices left to upload (ISR)
 
 volatile unsigned char ucSPIData = 0;				///< received SPI data (ISR)
 volatile unsigned char ucCommandBuffer = 0;			///< last received SPI data (ISR)
 volatile unsigned char ucDataCounter = 0;			///< SPI data counter (ISR)
+volatile unsigned char ucDataLength = 0;			///< amount of data bytes expected for the last command (ISR)
 volatile unsigned char ucDutyBuffer = 0;			///< dutycycle buffer register. (readable by RPi)
 volatile unsigned char ucTemperatureBuffer = 0;		///< temperature buffer register. (readable by RPi)
 volatile unsigned char ucStatusBuffer = 0;			///< status buffer register. (readable by RPi)
+volatile unsigned char ucFrameErrorBuffer = 0;		///< rejected frames (checksum, length, busy back frame), saturating. (readable by RPi)
+
+static CMDQUEUE COMMANDQUEUE;						///< queue of complete commands for the main loop (ISR)
+static COMMAND* sRxCommand_ptr = 0;					///< command currently being received, 0 if none (ISR)
+static unsigned char ucRxState = RX_LEGACY;			///< state of the frame receiver (ISR)
+static unsigned char ucRxOpcode = 0;				///< opcode of the frame being received, 0 if rejected (ISR)
+static unsigned char ucRxFirst = 0;					///< first payload byte of the frame being received (ISR)
+static unsigned char ucRxCRC = CRC8_INIT;			///< checksum of the frame being received (ISR)
+static unsigned char ucRxUpload = 0;				///< frame being received is streamed into the back frame (ISR)
+
+static SUNRISE_OUTPUT sSunrise;						///< last output of the sunrise engine
+static unsigned char ucSunriseColorPending = 0;		///< sunrise color not written yet (back frame was locked)
+static volatile unsigned char ucScene = SCENE_NONE;	///< last saved or recalled scene, restored at boot (copy of the EEPROM for the SPI ISR)
+static unsigned int uiRunLED = 0;					///< next LED of the front frame to run length encode (see nextRun())
+
+
+/** ***************************************************************************
+ * @brief Report a command dropped because the command queue was full (ISR)
+ * 
+ * @param [void] no input
+ * @return no return value
+ *****************************************************************************/
+static inline void dropCommand(void)
+{
+	ucStatusBuffer |= (1<<STATUS_DROPPED);
+	INSTR_COUNT(ucDropped);
+}
+
+
+/** ***************************************************************************
+ * @brief Count a rejected frame or frame upload (ISR)
+ * 
+ * @param [void] no input
+ * @return no return value
+ *****************************************************************************/
+static inline void rejectFrame(void)
+{
+	ucStatusBuffer |= (1<<STATUS_DROPPED);
+	if(ucFrameErrorBuffer<0xFF)
+	{
+		ucFrameErrorBuffer++;
+	}
+}
+
+
+/** ***************************************************************************
+ * @brief Get the record for a legacy command being received (ISR)
+ * 
+ * @param [void] no input
+ * @return record of the command queue, 0 if the queue is full (command dropped)
+ *****************************************************************************/
+static inline COMMAND* getRecord(void)
+{
+	COMMAND* sCommand_ptr = CmdQueue_GetWriteSlot(&COMMANDQUEUE);
+
+	if(!sCommand_ptr)
+	{
+		dropCommand();
+	}
+	return sCommand_ptr;
+}
+
+
+/** ***************************************************************************
+ * @brief Start streaming a full frame into the back frame (ISR)
+ *
+ * The upload takes the back frame over if nobody writes it, no latched frame
+ * waits for its swap and no queued command is waiting (they have to be
+ * executed first to keep the order). With STORAGE_SINGLE the strip has to be
+ * idle as well. Otherwise the upload is rejected (the caller counts it) and
+ * the RPi has to repeat it. A running effect is stopped in both cases, so
+ * the repeated upload does not compete with its frames.
+ * 
+ * @param [void] no input
+ * @return 1: upload started  0: back frame busy
+ *****************************************************************************/
+static inline unsigned char startUpload(void)
+{
+	Effect_Stop();
+	if((ucBackOwner!=BACK_FREE) || (ucSwapPending) || (CmdQueue_GetCount(&COMMANDQUEUE)) ||
+		((ucStorage==STORAGE_SINGLE) && (RGBooster_IsBusy())))
+	{
+		return 0;
+	}
+	ucBackOwner = BACK_UPLOAD;
+	ucUpload_ptr = ucBack_ptr;
+	ucUploadEnd_ptr = ucUpload_ptr + uiFrameSize;
+	uiUploadLeft = uiLEDCount;
+	switch(ucFormat)
+	{
+		case FORMAT_PAL8:
+		ucUploadColor = UPLOAD_PAL8;
+		break;
+		
+		case FORMAT_PAL4:
+		ucUploadColor = UPLOAD_PAL4_LOW;
+		break;
+		
+		default:
+		ucUploadColor = UPLOAD_RED;
+		break;
+	}
+	return 1;
+}
+
+
+/** ***************************************************************************
+ * @brief Write the next color of a frame upload into the back frame (ISR)
+ *
+ * FORMAT_GRB: colors arrive as red, green, blue and are written to their
+ * wire order position, corrected with the selected RGB gamma table.
+ * Palette formats: one palette index per LED, limited to the palette size.
+ * 4bit indices are packed two per byte (first LED in the low nibble).
+ * 
+ * @param [in] ucData: color value or palette index
+ * @return 1: last byte of the frame written  0: more bytes expected
+ *****************************************************************************/
+static inline unsigned char uploadByte(unsigned char ucData)
+{
+	unsigned char* ucLED_ptr = ucUpload_ptr;
+
+	switch(ucUploadColor)
+	{
+		case UPLOAD_RED:
+		ucLED_ptr[GRB_RED] = Gamma_RGB(ucData);
+		ucUploadColor = UPLOAD_GREEN;
+		break;
+		
+		case UPLOAD_GREEN:
+		ucLED_ptr[GRB_GREEN] = Gamma_RGB(ucData);
+		ucUploadColor = UPLOAD_BLUE;
+		break;
+		
+		case UPLOAD_BLUE:
+		ucLED_ptr[GRB_BLUE] = Gamma_RGB(ucData);
+		ucUploadColor = UPLOAD_RED;
+		ucUpload_ptr = ucLED_ptr + 3;
+		return (ucUpload_ptr==ucUploadEnd_ptr);
+		
+		case UPLOAD_PAL8:
+		*ucLED_ptr = ucData & (PALETTE8_ENTRIES-1);
+		ucUpload_ptr = ucLED_ptr + 1;
+		return (--uiUploadLeft==0);
+		
+		case UPLOAD_PAL4_LOW:
+		*ucLED_ptr = ucData & 0x0F;
+		ucUploadColor = UPLOAD_PAL4_HIGH;
+		return (--uiUploadLeft==0);
+		
+		default:
+		*ucLED_ptr |= (unsigned char)(ucData << 4);
+		ucUploadColor = UPLOAD_PAL4_LOW;
+		ucUpload_ptr = ucLED_ptr + 1;
+		return (--uiUploadLeft==0);
+	}
+	return 0;
+}
+
+
+/** ***************************************************************************
+ * @brief Release the back frame after a frame upload (ISR)
+ *
+ * An incomplete or invalid upload has overwritten parts of the back frame,
+ * so it gets marked stale (restored from the front frame before the next
+ * partial write or latch). Changes which were not latched are lost. With
+ * STORAGE_SINGLE there is no copy to restore, the partial upload stays in
+ * the frame until it is overwritten.
+ * 
+ * @param [in] ucComplete: 1: all colors received and valid  0: upload aborted
+ * @return no return value
+ *****************************************************************************/
+static inline void endUpload(unsigned char ucComplete)
+{
+	ucBackStale = !ucComplete;
+	ucBackOwner = BACK_FREE;
+}
+
+
+/** ***************************************************************************
+ * @brief Execute a received frame with a valid checksum
+ *
+ * Power LED commands are executed immediately, all other opcodes are
+ * published to the main loop like the legacy commands.
+ * 
+ * @param [void] no input
+ * @return no return value
+ *****************************************************************************/
+static inline void executeFrame(void)
+{
+	switch(ucRxOpcode)
+	{
+		case 0x80: // enable power led
+		enablePLED();
+		ucStatusBuffer |= (1<<STATUS_PLED);
+		break;
+		
+		case 0x81: // disable power led
+		disablePLED();
+		ucStatusBuffer &= ~(1<<STATUS_PLED);
+		break;
+		
+		case 0x82: // set dutycycle
+		if(ucDataLength==1)
+		{
+			ucDutyBuffer = (ucRxFirst>100) ? 100 : ucRxFirst;
+			setDuty(ucDutyBuffer);
+		}
+		break;
+		
+		case 0x89: // set temperature limit
+		if(ucDataLength==1)
+		{
+			Thermal_SetLimit(ucRxFirst);
+		}
+		break;
+		
+		case 0x87: // frame upload: already in the back frame
+		break;
+		
+		default: // executed by the main loop
+		if(sRxCommand_ptr)
+		{
+			sRxCommand_ptr->ucOpcode = ucRxOpcode;
+			sRxCommand_ptr->ucLength = ucDataLength;
+			CmdQueue_Publish(&COMMANDQUEUE);
+		}
+		else // queue was full
+		{
+			dropCommand();
+		}
+		break;
+	}
+}
+
+
+/** ***************************************************************************
+ * @brief Read a register of [0x8C, RR, 0x00] (ISR)
+ *
+ * Registers below REG_CONFIG are instrumentation registers (INSTR_REG_*,
+ * 0 if the firmware is built without INSTRUMENTATION). The configuration
+ * registers (REG_*) report the strip length, the storage mode, the format
+ * and the maximum length of each storage mode with the current format.
+ * 
+ * @param [in] ucRegister: register number
+ * @return register value, 0 for unknown registers
+ *****************************************************************************/
+static inline unsigned char readRegister(unsigned char ucRegister)
+{
+	switch(ucRegister)
+	{
+		case REG_LED_COUNT_HIGH:
+		return (unsigned char)(uiLEDCount >> 8);
+		
+		case REG_LED_COUNT_LOW:
+		return (unsigned char)uiLEDCount;
+		
+		case REG_STORAGE:
+		return ucStorage;
+		
+		case REG_MAX_DOUBLE_HIGH:
+		return (unsigned char)(auiLengthMax[ucFormat][STORAGE_DOUBLE] >> 8);
+		
+		case REG_MAX_DOUBLE_LOW:
+		return (unsigned char)auiLengthMax[ucFormat][STORAGE_DOUBLE];
+		
+		case REG_MAX_SINGLE_HIGH:
+		return (unsigned char)(auiLengthMax[ucFormat][STORAGE_SINGLE] >> 8);
+		
+		case REG_MAX_SINGLE_LOW:
+		return (unsigned char)auiLengthMax[ucFormat][STORAGE_SINGLE];
+		
+		case REG_FORMAT:
+		return ucFormat;
+		
+		case REG_SCENE:
+		return ucScene;
+		
+		default:
+		return (ucRegister<REG_CONFIG) ? INSTR_READ(ucRegister) : 0;
+	}
+}
 
-static RingBuff_t RINGBUFFER;						///< ringbuffer instance for storing long commands (ISR)
+
+/** ***************************************************************************
+ * @brief Receive one byte of a frame
+ *
+ * Frame: [0x8A, OPCODE, LENGTH, PAYLOAD..., CRC]. All bytes after the start
+ * byte are full 8bit values. The checksum (CRC-8, see crc8.c) covers the
+ * opcode, the length and the payload. The payload is written directly into a
+ * record of the command queue. The payload of 0x87 (full frame) is streamed
+ * directly into the back frame instead (see startUpload()). Frames with a
+ * wrong checksum, a payload longer than CMD_PAYLOAD_SIZE or an upload while
+ * the back frame is busy are counted and dropped.
+ * 
+ * @param [in] ucData: received byte
+ * @return no return value
+ *****************************************************************************/
+static inline void receiveFrame(unsigned char ucData)
+{
+	switch(ucRxState)
+	{
+		case RX_OPCODE:
+		ucRxOpcode = ucData;
+		ucRxCRC = CRC8_Update(CRC8_INIT, ucData);
+		sRxCommand_ptr = CmdQueue_GetWriteSlot(&COMMANDQUEUE);
+		ucRxState = RX_LENGTH;
+		break;
+		
+		case RX_LENGTH:
+		ucRxCRC = CRC8_Update(ucRxCRC, ucData);
+		ucDataCounter = 0;
+		ucDataLength = ucData;
+		if(ucRxOpcode==0x87) // full frame: streamed into the back frame
+		{
+			sRxCommand_ptr = 0;
+			ucRxUpload = (ucDataLength==uiUploadSize) && (startUpload());
+			if(!ucRxUpload) // wrong length or back frame busy: receive but reject
+			{
+				ucRxOpcode = 0;
+			}
+		}
+		else if(ucDataLength>CMD_PAYLOAD_SIZE) // payload does not fit: receive but reject
+		{
+			ucRxOpcode = 0;
+			sRxCommand_ptr = 0;
+		}
+		ucRxState = (ucDataLength>0) ? RX_PAYLOAD : RX_CRC;
+		break;
+		
+		case RX_PAYLOAD:
+		ucRxCRC = CRC8_Update(ucRxCRC, ucData);
+		if(ucDataCounter==0)
+		{
+			ucRxFirst = ucData;
+		}
+		if(ucRxUpload)
+		{
+			uploadByte(ucData);
+		}
+		else if(sRxCommand_ptr)
+		{
+			sRxCommand_ptr->aucPayload[ucDataCounter] = ucData;
+		}
+		ucDataCounter++;
+		if(ucDataCounter==ucDataLength)
+		{
+			ucRxState = RX_CRC;
+		}
+		break;
+		
+		case RX_CRC:
+		if(ucRxUpload)
+		{
+			endUpload(ucData==ucRxCRC);
+			ucRxUpload = 0;
+		}
+		if((ucRxOpcode) && (ucData==ucRxCRC))
+		{
+			executeFrame();
+		}
+		else
+		{
+			rejectFrame();
+		}
+		sRxCommand_ptr = 0;
+		ucRxState = RX_LEGACY;
+		break;
+		
+		default:
+		ucRxState = RX_LEGACY;
+		break;
+	}
+}
 
 
 /** ***************************************************************************
@@ -219,51 +639,187 @@ static RingBuff_t RINGBUFFER;						///< ringbuffer instance for storing long com
  * The received data is a command if the MSB (bit 7) is set. Otherwise it is
  * treated as data related to the last received command.
  * "Short commands" (short execution time) get executed immediately while all
- * other commands get stored into the ringbuffer for later execution inside of
- * the main loop.
+ * other commands get assembled in a record of the command queue. The record
+ * is published to the main loop as soon as the last data byte has arrived.
+ * A command that is interrupted by the next command byte is never published.
+ * Commands are dropped as a whole if the queue is full (STATUS_DROPPED). The
+ * RPi avoids this by pausing while STATUS_BUSY is set. Full frames (0x87)
+ * are written directly into the back frame without a copy (see
+ * startUpload()), an upload is rejected while the back frame is busy and
+ * counted in the rejected frames register.
+ *
+ * The legacy command 0x8A starts a frame of the framed protocol (see
+ * receiveFrame()). Bit 7 has no special meaning inside of a frame, so colors
+ * use the full 8bit range. Valid frames carry the same opcodes and payloads
+ * as the legacy commands below (without the 7bit limit) and get executed the
+ * same way. Reading registers is only possible with legacy commands.
+ * Opcodes above 0x8F are only available as frames.
  *
  * Command list (as seen from the RPi side):
  * - 0x80: enable power LED
  * - 0x81: disable power LED
  * - [0x82, XX]: set the dutycycle of the power LED to XX (percent -> XX = [0-100]) 
  * - 0x83: clear all RGB LEDs
- * - [0x84, RR, GG, BB]: set all RGB LEDs to a specified color [0-0x7F]
+ * - [0x84, RR, GG, BB]: set all RGB LEDs to a specified color [0-0x7F]. In
+ *   the palette formats (0x83 too) palette entry 0 gets the color and all
+ *   LEDs get index 0
+ * - [0x85, II, RR, GG, BB]: set RGB LED II to a specified color (no transfer)
+ * - [0x86, SS, NN, RR, GG, BB, ...]: set NN RGB LEDs starting at LED SS.
+ *   NN colors follow (3 bytes each, NN = [1-CMD_RANGE_MAX], no transfer).
+ *   0x85, 0x86 and 0x95 are ignored in the palette formats
+ * - [0x87, RR, GG, BB, ...]: upload all RGB LEDs. One color per LED of the
+ *   strip follows (3 bytes each, no transfer). In the palette formats one
+ *   palette index per LED follows instead. Rejected while the back frame
+ *   is busy (latched frame not swapped yet, queued commands, STORAGE_SINGLE
+ *   and strip not idle). As a frame only up to 85 LEDs (255 in the palette
+ *   formats, LENGTH is 8bit), longer strips use the legacy command or ranges
+ *   (0x95, 0x97)
+ * - 0x88: latch, send the RGB buffers to the strip
+ * - [0x89, TT]: set the temperature limit of the power LED to TT (degree C).
+ *   The dutycycle is reduced automatically near the limit (see thermal.h)
+ * - [0x8A, OPCODE, LENGTH, PAYLOAD..., CRC]: frame (framed protocol)
+ * - [0x8B, 0x00]: read the amount of rejected frames and frame uploads
+ * - [0x8C, RR, 0x00]: read register RR (see readRegister()): instrumentation
+ *   (INSTR_REG_*) and configuration (REG_*, strip length, storage mode,
+ *   format)
  * - [0x8D, 0x00]: read the dutycycle buffer register
  * - [0x8E, 0x00]: read the temperature buffer register
- * - [0x8F, 0x00]: read the status buffer register
+ * - [0x8F, 0x00]: read the status buffer register (bits: STATUS_* in main.h).
+ *   STATUS_BUSY: at most CMD_QUEUE_RESERVE free records, STATUS_DROPPED: a
+ *   command or frame was lost (queue full, rejected frame) since the last read,
+ *   STATUS_SAVING: a scene is being saved (commands wait, uploads are rejected)
+ *
+ * Framed only (opcode, payload):
+ * - 0x90, [DS, DE, RS, GS, BS, RE, GE, BE, TH, TL, CC]: start a sunrise
+ *   program (see Sunrise_Parse()), enables the power LED
+ * - 0x91, no payload: stop the sunrise program (outputs keep their values)
+ * - 0x92, [PP, RR]: select the brightness correction of the power LED (PP:
+ *   GAMMA_PLED_*) and of the RGB colors (RR: GAMMA_RGB_*), see gamma.h.
+ *   The RGB correction applies to colors written from now on
+ * - 0x93, [LH, LL]: set the brightness level of the power LED to LHLL
+ *   [0-0xFFFF] (fine version of 0x82, corrected like it)
+ * - 0x94, [LH, LL] or [LH, LL, FF]: set the strip length to LHLL LEDs and
+ *   the framebuffer format to FF (FORMAT_*, unchanged if omitted) and store
+ *   them in the EEPROM (one byte per pass, see storeLayout()). The strip is cleared, the storage mode follows from
+ *   the length and the format (see main.h). Lengths above the maximum of the
+ *   format are ignored
+ * - 0x95, [SH, SL, NN, RR, GG, BB, ...]: set NN RGB LEDs starting at LED SHSL
+ *   (0x86 for long strips, NN = [1-CMD_RANGE_MAX-1], no transfer)
+ * - 0x96, [FF, NN, RR, GG, BB, ...]: set NN palette entries starting at entry
+ *   FF (NN = [1-CMD_RANGE_MAX], no transfer). The palette is shared by the
+ *   front and back frame, a latch (0x88) recolours the whole strip. Commands
+ *   writing the palette (also 0x83, 0x84, 0x9B, 0x9C and 0x9E in the palette
+ *   formats) wait until a running transfer has ended
+ * - 0x97, [SH, SL, NN, II, ...]: set the palette index of NN LEDs starting at
+ *   LED SHSL (NN = [1-CMD_PAYLOAD_SIZE-3], no transfer)
+ * - 0x98, [SH, SL, NN, RR, GG, BB, NN, RR, GG, BB, ...]: run length encoded
+ *   RGB LEDs starting at LED SHSL. Each run sets NN LEDs [0-255] to one
+ *   color (up to CMD_RLE_RUNS_MAX runs, no transfer, ignored in the palette
+ *   formats). A scene is sent as one or more 0x98 and latched with 0x88
+ * - 0x99, [EE, SS, DD, RF, GF, BF, RB, GB, BB]: start effect EE (EFFECT_*)
+ *   with speed SS, density DD, foreground and background color (see
+ *   effects.h). The strip is animated by the effects task without further
+ *   commands (ignored in the palette formats). 0x83-0x88, 0x94, 0x95, 0x98,
+ *   0x9B and 0x9C stop the effect before they are executed
+ * - 0x9A, no payload: stop the effect (the strip keeps the last frame)
+ * - 0x9B, [HH, SS, VV] or [HH, HL, SS, VV]: set all RGB LEDs to the HSV
+ *   color with hue HH [0-255] or HHHL [0-359] degree, saturation SS and
+ *   value VV [0-255] (like 0x84, see Color_HSV())
+ * - 0x9C, [KH, KL, BB]: set all RGB LEDs to the color temperature KHKL
+ *   [COLOR_KELVIN_MIN-COLOR_KELVIN_MAX] Kelvin with the brightness BB [0-255]
+ *   (like 0x84, see Color_Kelvin())
+ * - 0x9D, [NN]: save the visible state as scene NN [0-SCENES-1] in the
+ *   EEPROM: strip (up to SCENE_RUNS_MAX runs of one color), power LED and
+ *   effect (see saveScene()). The save runs in the background for up to
+ *   about a second (STATUS_SAVING), the following commands wait for it
+ * - 0x9E, [NN]: recall scene NN (see recallScene()). The last saved or
+ *   recalled scene (register REG_SCENE) is restored at boot, SCENE_NONE
+ *   boots dark. Both set STATUS_DROPPED if the scene does not fit or the
+ *   slot is empty
  * 
  * @param [in] SPI_STC_vect: "Serial Transfer Complete" vector
  * @return no return value
  *****************************************************************************/
 ISR(SPI_STC_vect) // SPI receive complete
 {
+	INSTR_ENTRY();
+
 	ucSPIData = SPDR;
 	SPDR = 0;
 
+	if(ucRxState!=RX_LEGACY) // inside of a frame
+	{
+		receiveFrame(ucSPIData);
+		INSTR_EXIT(INSTR_SPI);
+		return;
+	}
+
 	if(ucSPIData & 0x80) // command
 	{
+		if(ucBackOwner==BACK_UPLOAD) // an incomplete frame upload is aborted
+		{
+			endUpload(0);
+		}
+		sRxCommand_ptr = 0; // an incomplete last command is discarded (its record gets reused)
 		ucDataCounter = 0;
+		ucDataLength = 0;
 		ucCommandBuffer = ucSPIData&0x0F;
 
-		switch(ucCommandBuffer) // "short commands" will be executed instantly. others get stored in the ringbuffer
+		switch(ucCommandBuffer) // "short commands" will be executed instantly. others get stored in the command queue
 		{
 			case 0: // enable power led
 			enablePLED();
-			ucStatusBuffer |= (1<<0);
+			ucStatusBuffer |= (1<<STATUS_PLED);
 			break;
 
 			case 1: // disable power led
 			disablePLED();
-			ucStatusBuffer &= ~(1<<0);
+			ucStatusBuffer &= ~(1<<STATUS_PLED);
 			break;
 			
 			case 3: // clear RGBs
-			RingBuffer_Insert(&RINGBUFFER,ucSPIData);
-			RingBuffer_Insert(&RINGBUFFER,0xFF);		//0xFF marks the end of a command sequence in the ringbuffer
+			case 8: // latch RGBs
+			sRxCommand_ptr = getRecord();
+			if(sRxCommand_ptr) // no data: complete command
+			{
+				sRxCommand_ptr->ucOpcode = ucSPIData;
+				sRxCommand_ptr->ucLength = 0;
+				CmdQueue_Publish(&COMMANDQUEUE);
+				sRxCommand_ptr = 0;
+			}
 			break;
 			
 			case 4: // display single color on all RGBs
-			RingBuffer_Insert(&RINGBUFFER,ucSPIData);
+			ucDataLength = 3;
+			sRxCommand_ptr = getRecord();
+			break;
+			
+			case 5: // set single RGB
+			ucDataLength = 4;
+			sRxCommand_ptr = getRecord();
+			break;
+			
+			case 6: // set range of RGBs (length gets updated with the amount of RGBs)
+			ucDataLength = 2;
+			sRxCommand_ptr = getRecord();
+			break;
+			
+			case 7: // set all RGBs: streamed into the back frame
+			if(!startUpload())
+			{
+				rejectFrame();
+			}
+			break;
+			
+			case 10: // start of a frame
+			ucRxState = RX_OPCODE;
+			break;
+			
+			case 11: // read rejected frames register
+			SPDR = ucFrameErrorBuffer;
+			break;
+			
+			case 12: // read instrumentation register (register number follows)
 			break;
 			
 			case 13: // read dutycycle register
@@ -275,7 +831,8 @@ ISR(SPI_STC_vect) // SPI receive complete
 			break;
 			
 			case 15: // read status register
-			SPDR = ucStatusBuffer;
+			SPDR = ucStatusBuffer | (CmdQueue_IsNearlyFull(&COMMANDQUEUE)<<STATUS_BUSY) | (Effect_IsRunning()<<STATUS_EFFECT) | (Scene_IsSaving()<<STATUS_SAVING);
+			ucStatusBuffer &= ~(1<<STATUS_DROPPED); // reported once
 			break;
 			
 			default: // unknown command
@@ -294,15 +851,50 @@ ISR(SPI_STC_vect) // SPI receive complete
 			setDuty(ucDutyBuffer);
 			break;
 			
+			case 9: // set temperature limit
+			Thermal_SetLimit(ucSPIData);
+			break;
+			
+			case 7: // set all RGBs
+			if(ucBackOwner!=BACK_UPLOAD) // rejected, aborted or surplus byte
+			{
+				INSTR_COUNT(ucOverrun);
+			}
+			else if(uploadByte(ucSPIData))
+			{
+				endUpload(1);
+			}
+			break;
+			
+			case 12: // read instrumentation register
+			if(ucDataCounter==1)
+			{
+				SPDR = readRegister(ucSPIData);
+			}
+			break;
+			
 			case 4: // display single color on all RGBs
-			if(ucDataCounter<=3)
+			case 5: // set single RGB
+			case 6: // set range of RGBs
+			if(sRxCommand_ptr) // command is being received (not complete, not dropped)
 			{
-				RingBuffer_Insert(&RINGBUFFER,ucSPIData);
-				if(ucDataCounter==3)
+				sRxCommand_ptr->aucPayload[ucDataCounter-1] = ucSPIData;
+				if((ucCommandBuffer==6) && (ucDataCounter==2)) // amount of RGBs received
+				{
+					ucDataLength = 2 + ((ucSPIData>CMD_RANGE_MAX) ? CMD_RANGE_MAX : ucSPIData)*3;
+				}
+				if(ucDataCounter==ucDataLength) // complete: publish to the main loop
 				{
-					RingBuffer_Insert(&RINGBUFFER,0xFF);
+					sRxCommand_ptr->ucOpcode = ucCommandBuffer|0x80;
+					sRxCommand_ptr->ucLength = ucDataLength;
+					CmdQueue_Publish(&COMMANDQUEUE);
+					sRxCommand_ptr = 0;
 				}
 			}
+			else // command dropped or complete
+			{
+				INSTR_COUNT(ucOverrun);
+			}
 			break;
 			
 			default: // last received command does not require any additional data. do nothing
@@ -311,156 +903,1321 @@ ISR(SPI_STC_vect) // SPI receive complete
 		
 		
 	}
+	INSTR_EXIT(INSTR_SPI);
 }
 
 
 /** ***************************************************************************
- * @brief External interrupt on INT1
+ * @brief Frame boundary: completion hook of the RGBooster transfers (ISR)
  *
- * This ISR outputs the next data byte according to the RGB LED counter and 
- * color counter. The handshake of the RGBooster board will bring the program
- * execution back to this ISR. After the last byte is sent this ISR will not
- * send any more data and thus no more handshakes will invoke this ISR.
- * The RGB LED counter (ucRGBIdx) and the color counter (ucByteIdx) need to be
- * set to zero and the ISR should be called manually with "INT1_vect();" to
- * start the protocol generation.
+ * Called by ISR(INT1_vect) after the last byte of a transfer. If a new frame
+ * has been latched in the meantime, the front and back frame are swapped and
+ * the transfer of the new front frame starts immediately. Otherwise the strip
+ * stays idle until the next latchFrame(). With STORAGE_SINGLE there is
+ * nothing to swap, the frame is simply sent. Palette indexed frames are
+ * expanded by ISR(INT1_vect) while they are sent.
  * 
- * @param [in] INT1_vect: External Interrupt Request 1
+ * @param [void] no input
  * @return no return value
  *****************************************************************************/
-ISR(INT1_vect)	// external interrupt (handshake from RGBooster board)
-{				// start RGBooster send sequence: reset "ucRGBIdx" and "ucByteIdx" to zero. then start with calling the ISR directly "INT1_vect();"
-	if(ucRGBIdx<(LED_COUNT))
+static void frameDone(void)
+{
+	unsigned char* ucSwap_ptr;
+
+	if(!ucSwapPending)
 	{
-		switch(ucByteIdx) // red green and blue are sent in 3 separate bytes. this variable remembers the next color to be sent
-		{
-			case 0:
-			PORT_DATA_HIGH = (PORT_DATA_HIGH & ~DATA_HIGH_BITMASK) | (aucGreen[ucRGBIdx] & DATA_HIGH_BITMASK);
-			PORT_DATA_LOW = (PORT_DATA_LOW & ~DATA_LOW_BITMASK) | (aucGreen[ucRGBIdx] & DATA_LOW_BITMASK);
-			PORT_CONTROL |= (1<<SEND); // generate send impulse
-			PORT_CONTROL &= ~(1<<SEND);
-			ucByteIdx++;
-			break;
+		return;
+	}
+	if(ucStorage==STORAGE_DOUBLE)
+	{
+		ucSwap_ptr = ucFront_ptr; // swap the framebuffers (pointers only)
+		ucFront_ptr = ucBack_ptr;
+		ucBack_ptr = ucSwap_ptr;
+		ucBackStale = 1;
+	}
+	ucSwapPending = 0;
+	switch(ucFormat)
+	{
+		case FORMAT_PAL8:
+		RGBooster_StartPalette(aucFramePool, ucFront_ptr, uiLEDCount, 8);
+		break;
+		
+		case FORMAT_PAL4:
+		RGBooster_StartPalette(aucFramePool, ucFront_ptr, uiLEDCount, 4);
+		break;
+		
+		default:
+		RGBooster_Start(ucFront_ptr, uiFrameSize);
+		break;
+	}
+	INSTR_COUNT(ucFrames);
+}
 
-			case 1:
-			PORT_DATA_HIGH = (PORT_DATA_HIGH & ~DATA_HIGH_BITMASK) | (aucRed[ucRGBIdx] & DATA_HIGH_BITMASK);
-			PORT_DATA_LOW = (PORT_DATA_LOW & ~DATA_LOW_BITMASK) | (aucRed[ucRGBIdx] & DATA_LOW_BITMASK);
-			PORT_CONTROL |= (1<<SEND); // generate send impulse
-			PORT_CONTROL &= ~(1<<SEND);
-			ucByteIdx++;
-			break;
 
-			case 2:
-			PORT_DATA_HIGH = (PORT_DATA_HIGH & ~DATA_HIGH_BITMASK) | (aucBlue[ucRGBIdx] & DATA_HIGH_BITMASK);
-			PORT_DATA_LOW = (PORT_DATA_LOW & ~DATA_LOW_BITMASK) | (aucBlue[ucRGBIdx] & DATA_LOW_BITMASK);
-			PORT_CONTROL |= (1<<SEND); // generate send impulse
-			PORT_CONTROL &= ~(1<<SEND);
-			ucByteIdx=0;
-			ucRGBIdx++;
-			break;
-		}
+/** ***************************************************************************
+ * @brief Get the amount of palette entries of a format
+ * 
+ * @param [in] ucLayout: framebuffer format (FORMAT_*)
+ * @return palette entries, 0 for FORMAT_GRB
+ *****************************************************************************/
+static unsigned char paletteEntries(unsigned char ucLayout)
+{
+	switch(ucLayout)
+	{
+		case FORMAT_PAL8:
+		return PALETTE8_ENTRIES;
+		
+		case FORMAT_PAL4:
+		return PALETTE4_ENTRIES;
+		
+		default:
+		return 0;
 	}
 }
 
 
 /** ***************************************************************************
- * @brief Main function - Entry point
- *
- * All initialization functions get called first and interrupts are globally
- * enabled. The RGB buffers already contain data to check the strip at the
- * beginning. Data is manually inserted into the ringbuffer to test how the
- * main programm handles received commands (through SPI).
+ * @brief Get the size of a frame
  * 
- * The main loop constantly measures the temperature and then checks if the
- * ringbuffer is empty. If not, the contained commands are executed.
+ * @param [in] uiCount: strip length
+ * @param [in] ucLayout: framebuffer format (FORMAT_*)
+ * @return bytes per frame (without the palette)
+ *****************************************************************************/
+static unsigned int frameSize(unsigned int uiCount, unsigned char ucLayout)
+{
+	switch(ucLayout)
+	{
+		case FORMAT_PAL8:
+		return uiCount;
+		
+		case FORMAT_PAL4:
+		return (uiCount+1)/2;
+		
+		default:
+		return uiCount*3;
+	}
+}
+
+
+/** ***************************************************************************
+ * @brief Set the strip length and the format and lay the framebuffers out
+ *
+ * The palette (if any) is placed at the start of the pool, the frames follow.
+ * Selects STORAGE_DOUBLE if two frames fit into the pool, STORAGE_SINGLE
+ * otherwise. The pool is cleared and sent with the longer of the old and the
+ * new length, so LEDs behind a shortened strip are turned off too (a 4bit
+ * palette transfer of the cleared pool sends black to every LED). The strip
+ * has to be idle and the back frame must not be written at the same time.
  * 
- * @param [void] no input
+ * @param [in] uiCount: strip length [1-maximum of the format]
+ * @param [in] ucLayout: framebuffer format (FORMAT_*)
  * @return no return value
  *****************************************************************************/
-void main(void)
+static void setStripLayout(unsigned int uiCount, unsigned char ucLayout)
 {
-	unsigned char ucTemp;
 	unsigned int i;
-	unsigned char aucCommandString[64];
-	
-	// INITIALIZATION
-	portInit();
-	RingBuffer_InitBuffer(&RINGBUFFER);
-	AD8bit_Init();
-	initRGBooster();
-	INT1_Init();
-	SendStrip_Off(LED_COUNT);
-	SPISlave_Init();
-	USART_Init();
-	disablePLED();
-	initPWM(ucDutyBuffer);
-	startPWM();
+	unsigned int uiClear = uiLEDCount;
 
-	sei();
-	
-	wait_1ms(1000);
-	
-	//RGB TEST
-	ucByteIdx = 0;
-	ucRGBIdx = 0;
-	INT1_vect();
-	
-	wait_1ms(2000);
-	
-	//RING BUFFER TEST (INSERTING COMMANDS)
-	RingBuffer_Insert(&RINGBUFFER,0x83);
-	RingBuffer_Insert(&RINGBUFFER,0xFF);
-	
-	RingBuffer_Insert(&RINGBUFFER,0x84);
-	RingBuffer_Insert(&RINGBUFFER,0x00);
-	RingBuffer_Insert(&RINGBUFFER,0x20);
-	RingBuffer_Insert(&RINGBUFFER,0x00);
-	RingBuffer_Insert(&RINGBUFFER,0xFF);
-	
-	
-	while(1)
+	for(i=0;i<FRAME_POOL_SIZE;i++)
 	{
-		ucTemp = AD8bit_Measurement();
-		ucTemperatureBuffer = (unsigned char)(((double)ucTemp*100/51-50)+0.5); // round data to integer
+		aucFramePool[i] = 0;
+	}
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE) // read by the ISRs
+	{
+		uiLEDCount = uiCount;
+		ucFormat = ucLayout;
+		uiFrameSize = frameSize(uiCount, ucLayout);
+		uiUploadSize = (ucLayout==FORMAT_GRB) ? (uiCount*3) : uiCount;
+		ucStorage = (uiCount<=auiLengthMax[ucLayout][STORAGE_DOUBLE]) ? STORAGE_DOUBLE : STORAGE_SINGLE;
+		ucFront_ptr = aucFramePool + paletteEntries(ucLayout)*3;
+		ucBack_ptr = (ucStorage==STORAGE_DOUBLE) ? (ucFront_ptr + uiFrameSize) : ucFront_ptr;
+		ucBackStale = 0;
+	}
+	if(uiClear<uiCount)
+	{
+		uiClear = uiCount;
+	}
+	RGBooster_StartPalette(aucFramePool, aucFramePool, uiClear, 4);
+}
+
+
+/** ***************************************************************************
+ * @brief Store the strip layout in the EEPROM in the background
+ *
+ * Called with every pass of processCommands(). Stores one byte of the
+ * current strip length and format per call (format last), only if the
+ * EEPROM is ready and only if the byte changed, so the main loop never
+ * waits for a write (3.4ms). A new layout restarts the store.
+ * 
+ * @param [void] no input
+ * @return no return value
+ *****************************************************************************/
+static void storeLayout(void)
+{
+	if((ucLayoutStore==0) || (!eeprom_is_ready()))
+	{
+		return;
+	}
+	ucLayoutStore--;
+	switch(ucLayoutStore)
+	{
+		case 2:
+		eeprom_update_byte((uint8_t*)&uiLEDCountEE, (unsigned char)uiLEDCount); // little endian like eeprom_read_word()
+		break;
+		
+		case 1:
+		eeprom_update_byte(((uint8_t*)&uiLEDCountEE)+1, (unsigned char)(uiLEDCount >> 8));
+		break;
+		
+		default:
+		eeprom_update_byte(&ucFormatEE, ucFormat);
+		break;
+	}
+}
+
+
+/** ***************************************************************************
+ * @brief Initialize all peripherals and enable interrupts
+ *
+ * The strip length and the format are read from the EEPROM
+ * (LED_COUNT_DEFAULT and FORMAT_GRB if they are not valid) and the RGB strip
+ * is cleared. The transfer runs in the background,
+ * frames latched in the meantime follow it.
+ * 
+ * @param [void] no input
+ * @return no return value
+ *****************************************************************************/
+void systemInit(void)
+{
+	unsigned int uiCount;
+	unsigned char ucLayout;
+
+	portInit();
+	Tick_Init();
+	INSTR_INIT();
+	CmdQueue_Init(&COMMANDQUEUE);
+	ADC_Init();
+	initRGBooster();
+	INT1_Init();
+	RGBooster_SetDoneHook(frameDone);
+	ucLayout = eeprom_read_byte(&ucFormatEE);
+	if(ucLayout>=FORMATS) // erased or never written
+	{
+		ucLayout = FORMAT_GRB;
+	}
+	uiCount = eeprom_read_word(&uiLEDCountEE);
+	if((uiCount==0) || (uiCount>auiLengthMax[ucLayout][STORAGE_SINGLE]))
+	{
+		uiCount = LED_COUNT_DEFAULT;
+	}
+	setStripLayout(uiCount, ucLayout);
+	SPISlave_Init();
+	USART_Init();
+	disablePLED();
+	initPWM(ucDutyBuffer);
+	startPWM();
+
+	sei();
+}
+
+
+/** ***************************************************************************
+ * @brief Take the back frame over for the main loop
+ *
+ * Fails while ISR(SPI_STC_vect) streams a frame upload into the back frame.
+ * As long as the main loop owns the back frame, uploads are rejected. The
+ * owner still has to check backFrameWritable() before every write.
+ * 
+ * @param [void] no input
+ * @return 1: back frame owned by the main loop  0: upload in progress
+ *****************************************************************************/
+static unsigned char lockBackFrame(void)
+{
+	unsigned char ucResult = 0;
+
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+	{
+		if(ucBackOwner==BACK_FREE)
+		{
+			ucBackOwner = BACK_MAIN;
+			ucResult = 1;
+		}
+	}
+	return ucResult;
+}
+
+
+/** ***************************************************************************
+ * @brief Check if the back frame may be written
+ *
+ * Not after a latch until the swap has happened (ucSwapPending). With
+ * STORAGE_SINGLE the back frame is the front frame, so it is only written
+ * while the strip is idle.
+ * 
+ * @param [void] no input
+ * @return 1: back frame writable  0: wait
+ *****************************************************************************/
+static inline unsigned char backFrameWritable(void)
+{
+	return (!ucSwapPending) && ((ucStorage==STORAGE_DOUBLE) || (!RGBooster_IsBusy()));
+}
+
+
+/** ***************************************************************************
+ * @brief Check if the palette may be written
+ *
+ * The palette is shared by the front and back frame and read by
+ * ISR(INT1_vect) while a palette indexed frame is sent. It is only written
+ * while the strip is idle, so a frame never shows two palettes.
+ * 
+ * @param [void] no input
+ * @return 1: palette writable (or FORMAT_GRB)  0: wait
+ *****************************************************************************/
+static inline unsigned char paletteWritable(void)
+{
+	return (ucFormat==FORMAT_GRB) || (!RGBooster_IsBusy());
+}
+
+
+/** ***************************************************************************
+ * @brief Release the back frame taken over by lockBackFrame()
+ * 
+ * @param [void] no input
+ * @return no return value
+ *****************************************************************************/
+static void unlockBackFrame(void)
+{
+	ucBackOwner = BACK_FREE;
+}
+
+
+/** ***************************************************************************
+ * @brief Get the back frame for writing
+ *
+ * After a swap the back frame contains the frame before the last one. It is
+ * updated with the front frame unless the caller overwrites the whole frame
+ * anyway. The front frame is only read by the ISR, so copying it is safe.
+ * The caller has to own the back frame (see lockBackFrame()).
+ * 
+ * @param [in] ucOverwrite: 1: caller writes all LEDs  0: caller writes some LEDs
+ * @return pointer to the back frame (uiFrameSize bytes, wire order or palette indices)
+ *****************************************************************************/
+static unsigned char* getBackFrame(unsigned char ucOverwrite)
+{
+	unsigned int i;
+	unsigned int uiSize = uiFrameSize;
+	unsigned char* ucTo_ptr = ucBack_ptr;
+	const unsigned char* ucFrom_ptr = ucFront_ptr;
+
+	if(ucBackStale)
+	{
+		if((!ucOverwrite) && (ucTo_ptr!=ucFrom_ptr))
+		{
+			for(i=0;i<uiSize;i++)
+			{
+				ucTo_ptr[i] = ucFrom_ptr[i];
+			}
+		}
+		ucBackStale = 0;
+	}
+	return ucTo_ptr;
+}
+
+
+/** ***************************************************************************
+ * @brief Latch the back frame
+ *
+ * The frame gets swapped and sent by frameDone() at the next frame boundary.
+ * If the strip is idle, frameDone() is called directly to start the
+ * transfer. The back frame must not be written until the swap has happened
+ * (ucSwapPending cleared by frameDone()).
+ * 
+ * @param [void] no input
+ * @return no return value
+ *****************************************************************************/
+static void latchFrame(void)
+{
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+	{
+		ucSwapPending = 1;
+		if(!RGBooster_IsBusy())
+		{
+			frameDone(); // swap and start transmission
+		}
+	}
+}
+
+
+/** ***************************************************************************
+ * @brief Insert a complete command into the command queue
+ *
+ * Allows the main program to queue commands like the SPI master does. An
+ * SPI command being received at the same time is discarded because its
+ * record is used here.
+ * 
+ * @param [in] ucOpcode: command byte (e.g. 0x84)
+ * @param [in] aucPayload: data bytes of the command
+ * @param [in] ucLength: amount of data bytes [0-CMD_PAYLOAD_SIZE]
+ * @return 1 if the command was queued, 0 if the queue is full
+ *****************************************************************************/
+static unsigned char insertCommand(unsigned char ucOpcode, const unsigned char* aucPayload, unsigned char ucLength)
+{
+	unsigned char i;
+	unsigned char ucResult = 0;
+	COMMAND* sCommand_ptr;
+
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+	{
+		sRxCommand_ptr = 0;
+		sCommand_ptr = CmdQueue_GetWriteSlot(&COMMANDQUEUE);
+		if(sCommand_ptr)
+		{
+			sCommand_ptr->ucOpcode = ucOpcode;
+			sCommand_ptr->ucLength = ucLength;
+			for(i=0;i<ucLength;i++)
+			{
+				sCommand_ptr->aucPayload[i] = aucPayload[i];
+			}
+			CmdQueue_Publish(&COMMANDQUEUE);
+			ucResult = 1;
+		}
+	}
+	return ucResult;
+}
+
+
+/** ***************************************************************************
+ * @brief Update the sunrise bit of the status register
+ *
+ * @param [in] ucSet: additional status bits to set (e.g. 1<<STATUS_PLED)
+ * @return no return value
+ *****************************************************************************/
+static void setSunriseStatus(unsigned char ucSet)
+{
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE) // the SPI ISR modifies the status register too
+	{
+		ucStatusBuffer = (ucStatusBuffer & ~(1<<STATUS_SUNRISE)) | (Sunrise_IsRunning()<<STATUS_SUNRISE) | ucSet;
+	}
+}
+
+
+/** ***************************************************************************
+ * @brief Write consecutive LEDs of the back frame
+ *
+ * LEDs behind the end of the strip are ignored. The colors are corrected
+ * with the selected RGB gamma table. Ignored in the palette formats.
+ * 
+ * @param [in] uiFirst: first LED
+ * @param [in] ucCount: amount of LEDs
+ * @param [in] aucColors: colors (red, green, blue per LED)
+ * @return no return value
+ *****************************************************************************/
+static void setRange(unsigned int uiFirst, unsigned char ucCount, const unsigned char* aucColors)
+{
+	unsigned char i;
+	unsigned char* ucLED_ptr;
+	unsigned int uiCount = uiLEDCount;
+
+	if((uiFirst>=uiCount) || (ucFormat!=FORMAT_GRB))
+	{
+		return;
+	}
+	ucLED_ptr = getBackFrame(0);
+	if(ucCount>(uiCount-uiFirst))
+	{
+		ucCount = (unsigned char)(uiCount-uiFirst);
+	}
+	ucLED_ptr += uiFirst*3;
+	for(i=0;i<ucCount;i++)
+	{
+		ucLED_ptr[GRB_GREEN] = Gamma_RGB(aucColors[1]);
+		ucLED_ptr[GRB_RED] = Gamma_RGB(aucColors[0]);
+		ucLED_ptr[GRB_BLUE] = Gamma_RGB(aucColors[2]);
+		ucLED_ptr += 3;
+		aucColors += 3;
+	}
+}
+
+
+/** ***************************************************************************
+ * @brief Write run length encoded LEDs into the back frame
+ *
+ * Every run writes its color (corrected with the selected RGB gamma table
+ * once per run) to the given amount of LEDs. Runs behind the end of the strip
+ * are ignored. Ignored in the palette formats.
+ * 
+ * @param [in] uiFirst: first LED
+ * @param [in] ucRuns: amount of runs
+ * @param [in] aucRuns: runs (amount of LEDs, red, green, blue per run)
+ * @return no return value
+ *****************************************************************************/
+static void setRuns(unsigned int uiFirst, unsigned char ucRuns, const unsigned char* aucRuns)
+{
+	unsigned char i;
+	unsigned char ucCount;
+	unsigned char ucRed;
+	unsigned char ucGreen;
+	unsigned char ucBlue;
+	unsigned char* ucLED_ptr;
+	unsigned int uiLeft;
+
+	if((uiFirst>=uiLEDCount) || (ucFormat!=FORMAT_GRB))
+	{
+		return;
+	}
+	uiLeft = uiLEDCount - uiFirst;
+	ucLED_ptr = getBackFrame(0) + (uiFirst*3);
+	for(i=0;(i<ucRuns) && (uiLeft);i++)
+	{
+		ucCount = (aucRuns[0]>uiLeft) ? (unsigned char)uiLeft : aucRuns[0];
+		uiLeft -= ucCount;
+		ucRed = Gamma_RGB(aucRuns[1]);
+		ucGreen = Gamma_RGB(aucRuns[2]);
+		ucBlue = Gamma_RGB(aucRuns[3]);
+		while(ucCount--)
+		{
+			ucLED_ptr[GRB_GREEN] = ucGreen;
+			ucLED_ptr[GRB_RED] = ucRed;
+			ucLED_ptr[GRB_BLUE] = ucBlue;
+			ucLED_ptr += 3;
+		}
+		aucRuns += 4;
+	}
+}
+
+
+/** ***************************************************************************
+ * @brief Write consecutive palette entries
+ *
+ * Entries behind the end of the palette are ignored. The colors are
+ * corrected with the selected RGB gamma table. The palette is shared by the
+ * front and back frame, the strip has to be idle (see paletteWritable()).
+ * 
+ * @param [in] ucFirst: first palette entry
+ * @param [in] ucCount: amount of entries
+ * @param [in] aucColors: colors (red, green, blue per entry)
+ * @return no return value
+ *****************************************************************************/
+static void setPalette(unsigned char ucFirst, unsigned char ucCount, const unsigned char* aucColors)
+{
+	unsigned char i;
+	unsigned char ucEntries = paletteEntries(ucFormat);
+	unsigned char* ucEntry_ptr = aucFramePool;
+
+	if(ucFirst>=ucEntries)
+	{
+		return;
+	}
+	if(ucCount>(ucEntries-ucFirst))
+	{
+		ucCount = ucEntries-ucFirst;
+	}
+	ucEntry_ptr += ucFirst*3;
+	for(i=0;i<ucCount;i++)
+	{
+		ucEntry_ptr[GRB_GREEN] = Gamma_RGB(aucColors[1]);
+		ucEntry_ptr[GRB_RED] = Gamma_RGB(aucColors[0]);
+		ucEntry_ptr[GRB_BLUE] = Gamma_RGB(aucColors[2]);
+		ucEntry_ptr += 3;
+		aucColors += 3;
+	}
+}
+
+
+/** ***************************************************************************
+ * @brief Write the palette indices of consecutive LEDs of the back frame
+ *
+ * LEDs behind the end of the strip are ignored, the indices are limited to
+ * the palette size. Ignored in FORMAT_GRB.
+ * 
+ * @param [in] uiFirst: first LED
+ * @param [in] ucCount: amount of LEDs
+ * @param [in] aucIndex: palette indices (one per LED)
+ * @return no return value
+ *****************************************************************************/
+static void setIndices(unsigned int uiFirst, unsigned char ucCount, const unsigned char* aucIndex)
+{
+	unsigned char i;
+	unsigned char* ucFrame_ptr;
+	unsigned int uiCount = uiLEDCount;
+	unsigned int uiLED;
+
+	if((uiFirst>=uiCount) || (ucFormat==FORMAT_GRB))
+	{
+		return;
+	}
+	if(ucCount>(uiCount-uiFirst))
+	{
+		ucCount = (unsigned char)(uiCount-uiFirst);
+	}
+	ucFrame_ptr = getBackFrame(0);
+	for(i=0;i<ucCount;i++)
+	{
+		uiLED = uiFirst + i;
+		if(ucFormat==FORMAT_PAL8)
+		{
+			ucFrame_ptr[uiLED] = aucIndex[i] & (PALETTE8_ENTRIES-1);
+		}
+		else if(uiLED & 0x01) // high nibble
+		{
+			ucFrame_ptr[uiLED>>1] = (ucFrame_ptr[uiLED>>1] & 0x0F) | (unsigned char)(aucIndex[i] << 4);
+		}
+		else
+		{
+			ucFrame_ptr[uiLED>>1] = (ucFrame_ptr[uiLED>>1] & 0xF0) | (aucIndex[i] & 0x0F);
+		}
+	}
+}
+
+
+/** ***************************************************************************
+ * @brief Set all LEDs of the back frame to one color and latch it
+ *
+ * The color is corrected with the selected RGB gamma table. In the palette
+ * formats palette entry 0 gets the color and all LEDs get index 0.
+ * 
+ * @param [in] ucRed: red
+ * @param [in] ucGreen: green
+ * @param [in] ucBlue: blue
+ * @return no return value
+ *****************************************************************************/
+static void fillColor(unsigned char ucRed, unsigned char ucGreen, unsigned char ucBlue)
+{
+	unsigned int i;
+	unsigned int uiSize = uiFrameSize;
+	unsigned char* ucFrame_ptr = getBackFrame(1);
+	const unsigned char aucColor[3] = {ucRed, ucGreen, ucBlue};
+
+	if(ucFormat==FORMAT_GRB)
+	{
+		ucRed = Gamma_RGB(ucRed);
+		ucGreen = Gamma_RGB(ucGreen);
+		ucBlue = Gamma_RGB(ucBlue);
+		for(i=0;i<uiSize;i+=3)
+		{
+			ucFrame_ptr[i+GRB_GREEN] = ucGreen;
+			ucFrame_ptr[i+GRB_RED] = ucRed;
+			ucFrame_ptr[i+GRB_BLUE] = ucBlue;
+		}
+	}
+	else
+	{
+		setPalette(0, 1, aucColor);
+		for(i=0;i<uiSize;i++)
+		{
+			ucFrame_ptr[i] = 0;
+		}
+	}
+	latchFrame(); //start transmission
+}
+
+/** ***************************************************************************
+ * @brief Report a command that could not be executed (STATUS_DROPPED)
+ * 
+ * @param [void] no input
+ * @return no return value
+ *****************************************************************************/
+static void failCommand(void)
+{
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE) // the SPI ISR modifies the status register too
+	{
+		ucStatusBuffer |= (1<<STATUS_DROPPED);
+	}
+}
+
+
+/** ***************************************************************************
+ * @brief Get the color of a LED of the front frame
+ *
+ * In the palette formats the color of its palette entry.
+ * 
+ * @param [in] uiLED: LED [0-uiLEDCount-1]
+ * @param [out] aucColor: color in wire order (green, red, blue), corrected
+ * @return no return value
+ *****************************************************************************/
+static void getLED(unsigned int uiLED, unsigned char* aucColor)
+{
+	const unsigned char* ucColor_ptr;
+
+	switch(ucFormat)
+	{
+		case FORMAT_PAL8:
+		ucColor_ptr = aucFramePool + (ucFront_ptr[uiLED]*3);
+		break;
+		
+		case FORMAT_PAL4:
+		ucColor_ptr = aucFramePool + ((((uiLED & 0x01) ? (ucFront_ptr[uiLED>>1] >> 4) : ucFront_ptr[uiLED>>1]) & 0x0F)*3);
+		break;
+		
+		default:
+		ucColor_ptr = ucFront_ptr + (uiLED*3);
+		break;
+	}
+	aucColor[0] = ucColor_ptr[0];
+	aucColor[1] = ucColor_ptr[1];
+	aucColor[2] = ucColor_ptr[2];
+}
+
+
+/** ***************************************************************************
+ * @brief Run length encode the next run of the front frame
+ *
+ * Consecutive LEDs of the same color form a run (up to 255 LEDs). The runs
+ * are encoded from LED uiRunLED on, which is advanced behind the run.
+ * 
+ * @param [out] aucColor: color of the run in wire order (green, red, blue)
+ * @return amount of LEDs of the run, 0 behind the last LED
+ *****************************************************************************/
+static unsigned char nextRun(unsigned char* aucColor)
+{
+	unsigned char ucCount = 0;
+	unsigned char aucNext[3];
+
+	if(uiRunLED<uiLEDCount)
+	{
+		getLED(uiRunLED, aucColor);
+		uiRunLED++;
+		ucCount = 1;
+	}
+	while((ucCount) && (ucCount<255) && (uiRunLED<uiLEDCount))
+	{
+		getLED(uiRunLED, aucNext);
+		if((aucNext[0]!=aucColor[0]) || (aucNext[1]!=aucColor[1]) || (aucNext[2]!=aucColor[2]))
+		{
+			break;
+		}
+		uiRunLED++;
+		ucCount++;
+	}
+	return ucCount;
+}
+
+
+/** ***************************************************************************
+ * @brief Source of the runs of a scene being saved (see SCENE_NEXT_RUN)
+ *
+ * @param [in] ucRun: run, 0 starts again at the first LED
+ * @param [out] aucColor: color of the run in wire order (green, red, blue)
+ * @return amount of LEDs of the run
+ *****************************************************************************/
+static unsigned char saveRun(unsigned char ucRun, unsigned char* aucColor)
+{
+	if(ucRun==0)
+	{
+		uiRunLED = 0;
+	}
+	return nextRun(aucColor);
+}
+
+
+/** ***************************************************************************
+ * @brief Save the visible state as a scene
+ *
+ * The front frame (run length encoded), the power LED and the running effect
+ * are saved into the slot, which becomes the scene restored at boot. With a
+ * running effect the frame is left out (no runs), the recall renders the
+ * effect again. The save runs in the background (see Scene_Step()): processCommands() keeps
+ * the back frame locked and executes no commands until the scene is saved,
+ * so the front frame does not change meanwhile (STATUS_SAVING).
+ * 
+ * @param [in] ucSlot: scene slot [0-SCENES-1]
+ * @return 1: save started  0: unknown slot or more than SCENE_RUNS_MAX runs
+ *****************************************************************************/
+static unsigned char saveScene(unsigned char ucSlot)
+{
+	SCENE sScene;
+	unsigned int uiRuns = 0;
+	unsigned char aucColor[3];
+
+	uiRunLED = 0;
+	while((!Effect_IsRunning()) && (nextRun(aucColor))) // a running effect is rendered again by recallScene()
+	{
+		uiRuns++;
+	}
+	if((ucSlot>=SCENES) || (uiRuns>SCENE_RUNS_MAX))
+	{
+		return 0;
+	}
+	sScene.ucRuns = (unsigned char)uiRuns;
+	sScene.ucFlags = ((ucStatusBuffer & (1<<STATUS_PLED)) ? SCENE_PLED : 0) | ((Effect_IsRunning()) ? SCENE_EFFECT : 0);
+	sScene.uiDuty = getDutyLevel();
+	Effect_GetPayload(sScene.aucEffect);
+	Scene_Save(ucSlot, &sScene, saveRun);
+	return 1;
+}
+
+
+/** ***************************************************************************
+ * @brief Recall a scene
+ *
+ * The runs are written into the back frame (LEDs behind the last run are
+ * turned off) and latched. In the palette formats every run gets its own
+ * palette entry, runs behind the end of the palette share the last one. The
+ * power LED gets its state and brightness level, a running sunrise is
+ * stopped and the effect of the scene is started (FORMAT_GRB only). The
+ * recalled scene is restored at boot. The back frame has to be locked and
+ * writable. SCENE_NONE only clears the scene restored at boot.
+ * 
+ * @param [in] ucSlot: scene slot [0-SCENES-1] or SCENE_NONE
+ * @return 1: recalled  0: unknown slot, empty or corrupted
+ *****************************************************************************/
+static unsigned char recallScene(unsigned char ucSlot)
+{
+	SCENE sScene;
+	EFFECT sEffect;
+	unsigned char i;
+	unsigned char ucCount;
+	unsigned char ucEntry;
+	unsigned char aucColor[3];
+	unsigned char* ucFrame_ptr;
+	unsigned int uiLED;
+
+	if(ucSlot==SCENE_NONE)
+	{
+		Scene_SetLast(SCENE_NONE);
+		ucScene = SCENE_NONE;
+		return 1;
+	}
+	if(!Scene_Read(ucSlot, &sScene))
+	{
+		return 0;
+	}
+
+	Effect_Stop();
+	ucFrame_ptr = getBackFrame(1);
+	for(uiLED=0;uiLED<uiFrameSize;uiLED++)
+	{
+		ucFrame_ptr[uiLED] = 0;
+	}
+	uiLED = 0;
+	for(i=0;(i<sScene.ucRuns) && (uiLED<uiLEDCount);i++)
+	{
+		ucCount = Scene_ReadRun(ucSlot, i, aucColor);
+		if(ucFormat==FORMAT_GRB)
+		{
+			while((ucCount--) && (uiLED<uiLEDCount))
+			{
+				ucFrame_ptr[(uiLED*3)+0] = aucColor[0];
+				ucFrame_ptr[(uiLED*3)+1] = aucColor[1];
+				ucFrame_ptr[(uiLED*3)+2] = aucColor[2];
+				uiLED++;
+			}
+		}
+		else
+		{
+			ucEntry = (i<paletteEntries(ucFormat)) ? i : (paletteEntries(ucFormat)-1);
+			aucFramePool[(ucEntry*3)+0] = aucColor[0];
+			aucFramePool[(ucEntry*3)+1] = aucColor[1];
+			aucFramePool[(ucEntry*3)+2] = aucColor[2];
+			while((ucCount--) && (uiLED<uiLEDCount))
+			{
+				setIndices(uiLED, 1, &ucEntry);
+				uiLED++;
+			}
+		}
+	}
+	latchFrame();
+
+	Sunrise_Stop();
+	setDutyLevel(sScene.uiDuty);
+	ucDutyBuffer = levelToPercent(sScene.uiDuty);
+	if(sScene.ucFlags & SCENE_PLED)
+	{
+		enablePLED();
+	}
+	else
+	{
+		disablePLED();
+	}
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE) // the SPI ISR modifies the status register too
+	{
+		ucStatusBuffer = (ucStatusBuffer & ~((1<<STATUS_PLED) | (1<<STATUS_SUNRISE))) | ((sScene.ucFlags & SCENE_PLED) ? (1<<STATUS_PLED) : 0);
+	}
+	if((sScene.ucFlags & SCENE_EFFECT) && (ucFormat==FORMAT_GRB) && (Effect_Parse(&sEffect, sScene.aucEffect, EFFECT_PAYLOAD_SIZE)))
+	{
+		Effect_Start(&sEffect);
+	}
+
+	Scene_SetLast(ucSlot);
+	ucScene = ucSlot;
+	return 1;
+}
+
+
+/** ***************************************************************************
+ * @brief Restore the last saved or recalled scene after a reset
+ *
+ * The recall (0x9E) is queued and executed by the first pass of the command
+ * task as soon as the back frame is writable (STORAGE_SINGLE: after the
+ * boot clear of the strip), i.e. within milliseconds of the reset.
+ * 
+ * @param [void] no input
+ * @return no return value
+ *****************************************************************************/
+void restoreScene(void)
+{
+	unsigned char ucSlot = Scene_GetLast();
+
+	ucScene = ucSlot;
+	if(ucSlot!=SCENE_NONE)
+	{
+		insertCommand(0x9E, &ucSlot, 1);
+	}
+}
+
+
+/** ***************************************************************************
+ * @brief Execute all complete commands of the command queue
+ *
+ * Commands are assembled and published by ISR(SPI_STC_vect). Execution stops
+ * if the queue is empty or if the back frame is not writable (latched frame
+ * waiting for its swap, STORAGE_SINGLE and strip not idle) or if a command
+ * writing the palette meets a running transfer (see paletteWritable()). The remaining
+ * commands are executed by the next call. Nothing is executed
+ * while a frame upload is being received. Commands write into the
+ * back frame, the front frame is sent to the strip at the same time. Colors
+ * are corrected with the selected RGB gamma table while they are written.
+ * Commands with a payload length that does not match the opcode are ignored.
+ * While a scene is being saved (0x9D), every call writes its next byte
+ * instead, the back frame stays locked and the commands wait.
+ * 
+ * @param [void] no input
+ * @return no return value
+ *****************************************************************************/
+void processCommands(void)
+{
+	unsigned char ucFirst;
+	unsigned char ucCount;
+	unsigned char ucLayout;
+	unsigned int uiLevel;
+	unsigned int uiCount;
+	COMMAND* sCommand_ptr;
+	unsigned char* ucPayload_ptr;
+	SUNRISE sSunriseProgram;
+	EFFECT sEffect;
+	unsigned char aucColor[3];
+	unsigned char ucWait;
+	INSTR_ENTRY();
+
+	INSTR_QUEUE(CmdQueue_GetCount(&COMMANDQUEUE));
+	storeLayout();
+	if(Scene_IsSaving()) // back frame locked by saveScene()
+	{
+		if(!Scene_Step())
+		{
+			ucScene = Scene_GetLast();
+			unlockBackFrame();
+		}
+		INSTR_EXIT(INSTR_COMMANDS);
+		return;
+	}
+	if(!lockBackFrame()) // frame upload in progress
+	{
+		INSTR_EXIT(INSTR_COMMANDS);
+		return;
+	}
+	while((backFrameWritable()) && (!Scene_IsSaving())) // back frame is locked until the next frame boundary
+	{
+		sCommand_ptr = CmdQueue_Peek(&COMMANDQUEUE);
+		if(!sCommand_ptr) // no complete command
+		{
+			break;
+		}
+		ucPayload_ptr = sCommand_ptr->aucPayload;
+		
+		switch(sCommand_ptr->ucOpcode)
+		{
+			case 0x83: case 0x84: case 0x96: case 0x9B: case 0x9C: case 0x9E: // write the palette in the palette formats
+			ucWait = !paletteWritable();
+			break;
+			
+			default:
+			ucWait = 0;
+			break;
+		}
+		if(ucWait) // palette still read by the running transfer
+		{
+			break;
+		}
+		
+		switch(sCommand_ptr->ucOpcode)
+		{
+			case 0x83: case 0x84: case 0x85: case 0x86: case 0x88: case 0x94: case 0x95: case 0x98: case 0x9B: case 0x9C:
+			Effect_Stop(); // the RPi takes the strip over
+			break;
+			
+			default:
+			break;
+		}
 		
-		if(RingBuffer_GetCount(&RINGBUFFER) > 0) // data in ringbuffer
+		switch(sCommand_ptr->ucOpcode)
 		{
-			if(RingBuffer_CountChar(&RINGBUFFER,0xFF)>0) // complete commands in ringbuffer
+			case 0x83: // clear RGB leds
+			fillColor(0, 0, 0);
+			break;
+			
+			case 0x84: //single color for all RGB leds
+			if(sCommand_ptr->ucLength==3)
 			{
-				RingBuffer_RemoveUntilChar(&RINGBUFFER,aucCommandString,0xFF,false); // get command
-				
-				switch(aucCommandString[0])
-				{
-					case 0x83: // clear RGB leds
-					for(i=0;i<LED_COUNT;i++)
-					{
-						aucRed[i] = 0;
-						aucGreen[i] = 0;
-						aucBlue[i] = 0;
-					}
-					ucRGBIdx = 0;
-					ucRGBIdx = 0;
-					INT1_vect(); //start transmission
-					break;
-					
-					case 0x84: //single color for all RGB leds
-					for(i=0;i<LED_COUNT;i++)
-					{
-						aucRed[i] = aucCommandString[1];
-						aucGreen[i] = aucCommandString[2];
-						aucBlue[i] = aucCommandString[3];
-					}
-					
-					ucRGBIdx = 0;
-					ucRGBIdx = 0;
-					INT1_vect(); //start transmission
-					break;
-					
-					default:
-					break;
-				}
+				fillColor(ucPayload_ptr[0], ucPayload_ptr[1], ucPayload_ptr[2]);
+			}
+			break;
+			
+			case 0x85: //single RGB led
+			if(sCommand_ptr->ucLength!=4)
+			{
+				break;
+			}
+			setRange(ucPayload_ptr[0], 1, &ucPayload_ptr[1]);
+			break;
+			
+			case 0x86: //range of RGB leds
+			if(sCommand_ptr->ucLength<2)
+			{
+				break;
+			}
+			ucFirst = ucPayload_ptr[0];
+			ucCount = (sCommand_ptr->ucLength-2)/3; // colors received (the ISR limits NN to CMD_RANGE_MAX)
+			if(ucPayload_ptr[1]<ucCount)
+			{
+				ucCount = ucPayload_ptr[1];
+			}
+			setRange(ucFirst, ucCount, &ucPayload_ptr[2]);
+			break;
+			
+			case 0x88: //latch
+			getBackFrame(0); // an empty back frame must not be latched
+			latchFrame(); //start transmission
+			break;
+			
+			case 0x90: //start sunrise
+			if(Sunrise_Parse(&sSunriseProgram, ucPayload_ptr, sCommand_ptr->ucLength))
+			{
+				Sunrise_Start(&sSunriseProgram, TASK_PERIOD_EFFECTS);
+				enablePLED();
+				setSunriseStatus(1<<STATUS_PLED);
+			}
+			break;
+			
+			case 0x91: //stop sunrise
+			Sunrise_Stop();
+			setSunriseStatus(0);
+			break;
+			
+			case 0x92: //select brightness correction
+			if((sCommand_ptr->ucLength==2) && (Gamma_Select(ucPayload_ptr[0], ucPayload_ptr[1])))
+			{
+				refreshDuty();
+			}
+			break;
+			
+			case 0x93: //set brightness level (16bit)
+			if(sCommand_ptr->ucLength==2)
+			{
+				uiLevel = ((unsigned int)ucPayload_ptr[0] << 8) | ucPayload_ptr[1];
+				setDutyLevel(uiLevel);
+				ucDutyBuffer = levelToPercent(uiLevel);
+			}
+			break;
+			
+			case 0x94: //set strip length and format
+			if((sCommand_ptr->ucLength!=2) && (sCommand_ptr->ucLength!=3))
+			{
+				break;
+			}
+			uiCount = ((unsigned int)ucPayload_ptr[0] << 8) | ucPayload_ptr[1];
+			ucLayout = (sCommand_ptr->ucLength==3) ? ucPayload_ptr[2] : ucFormat;
+			if((ucLayout>=FORMATS) || (uiCount==0) || (uiCount>auiLengthMax[ucLayout][STORAGE_SINGLE]))
+			{
+				break;
+			}
+			if(RGBooster_IsBusy()) // the framebuffers are being sent: retry with the next call
+			{
+				unlockBackFrame();
+				INSTR_EXIT(INSTR_COMMANDS);
+				return;
+			}
+			setStripLayout(uiCount, ucLayout);
+			ucLayoutStore = 3; // stored by the next passes (see storeLayout())
+			break;
+			
+			case 0x95: //range of RGB leds (16bit start)
+			if(sCommand_ptr->ucLength<3)
+			{
+				break;
+			}
+			ucCount = (sCommand_ptr->ucLength-3)/3; // colors received
+			if(ucPayload_ptr[2]<ucCount)
+			{
+				ucCount = ucPayload_ptr[2];
+			}
+			setRange(((unsigned int)ucPayload_ptr[0] << 8) | ucPayload_ptr[1], ucCount, &ucPayload_ptr[3]);
+			break;
+			
+			case 0x96: //palette entries
+			if(sCommand_ptr->ucLength<2)
+			{
+				break;
 			}
+			ucCount = (sCommand_ptr->ucLength-2)/3; // colors received
+			if(ucPayload_ptr[1]<ucCount)
+			{
+				ucCount = ucPayload_ptr[1];
+			}
+			setPalette(ucPayload_ptr[0], ucCount, &ucPayload_ptr[2]);
+			break;
+			
+			case 0x97: //palette indices of a range of RGB leds
+			if(sCommand_ptr->ucLength<3)
+			{
+				break;
+			}
+			ucCount = sCommand_ptr->ucLength-3; // indices received
+			if(ucPayload_ptr[2]<ucCount)
+			{
+				ucCount = ucPayload_ptr[2];
+			}
+			setIndices(((unsigned int)ucPayload_ptr[0] << 8) | ucPayload_ptr[1], ucCount, &ucPayload_ptr[3]);
+			break;
+			
+			case 0x98: //run length encoded RGB leds
+			if(sCommand_ptr->ucLength<2)
+			{
+				break;
+			}
+			setRuns(((unsigned int)ucPayload_ptr[0] << 8) | ucPayload_ptr[1], (sCommand_ptr->ucLength-2)/4, &ucPayload_ptr[2]);
+			break;
+			
+			case 0x99: //start effect
+			if((ucFormat==FORMAT_GRB) && (Effect_Parse(&sEffect, ucPayload_ptr, sCommand_ptr->ucLength)))
+			{
+				Effect_Start(&sEffect);
+			}
+			break;
+			
+			case 0x9A: //stop effect
+			Effect_Stop();
+			break;
+			
+			case 0x9B: //HSV color for all RGB leds
+			if(sCommand_ptr->ucLength==3)
+			{
+				Color_HSV(ucPayload_ptr[0], ucPayload_ptr[1], ucPayload_ptr[2], aucColor);
+			}
+			else if(sCommand_ptr->ucLength==4)
+			{
+				Color_HSV(Color_Degree(((unsigned int)ucPayload_ptr[0] << 8) | ucPayload_ptr[1]), ucPayload_ptr[2], ucPayload_ptr[3], aucColor);
+			}
+			else
+			{
+				break;
+			}
+			fillColor(aucColor[0], aucColor[1], aucColor[2]);
+			break;
+			
+			case 0x9C: //color temperature for all RGB leds
+			if(sCommand_ptr->ucLength==3)
+			{
+				Color_Kelvin(((unsigned int)ucPayload_ptr[0] << 8) | ucPayload_ptr[1], ucPayload_ptr[2], aucColor);
+				fillColor(aucColor[0], aucColor[1], aucColor[2]);
+			}
+			break;
+			
+			case 0x9D: //save scene
+			if((sCommand_ptr->ucLength!=1) || (!saveScene(ucPayload_ptr[0])))
+			{
+				failCommand();
+			}
+			break;
+			
+			case 0x9E: //recall scene
+			if((sCommand_ptr->ucLength!=1) || (!recallScene(ucPayload_ptr[0])))
+			{
+				failCommand();
+			}
+			break;
+			
+			default:
+			break;
+		}
+		
+		CmdQueue_Pop(&COMMANDQUEUE); // release the record for the ISR
+	}
+	if(!Scene_IsSaving()) // a save keeps the front frame until it is done
+	{
+		unlockBackFrame();
+	}
+	INSTR_EXIT(INSTR_COMMANDS);
+}
+
+
+/** ***************************************************************************
+ * @brief Update the temperature and the thermal derating of the power LED
+ *
+ * Nothing is done until the ADC has a new oversampled measurement. The
+ * temperature buffer register gets the rounded temperature in degree C
+ * [0-255], the dutycycle scale and the status bits follow the thermal state.
+ * 
+ * @param [void] no input
+ * @return no return value
+ *****************************************************************************/
+void updateTemperature(void)
+{
+	unsigned char ucUpdated;
+	unsigned char ucStatus = 0;
+	unsigned int uiRaw;
+	int iTemperature;
+
+	uiRaw = ADC_GetFiltered(&ucUpdated);
+	if(!ucUpdated)
+	{
+		return;
+	}
+
+	iTemperature = Thermal_Convert(uiRaw);
+	if(iTemperature<0)
+	{
+		ucTemperatureBuffer = 0;
+	}
+	else if(iTemperature>=2550)
+	{
+		ucTemperatureBuffer = 255;
+	}
+	else
+	{
+		ucTemperatureBuffer = (unsigned char)((iTemperature+5)/10); // round to degree C
+	}
+
+	setDutyScale(Thermal_Update(iTemperature));
+	switch(Thermal_GetState())
+	{
+		case THERMAL_OVERTEMP:
+		ucStatus = (1<<STATUS_DERATING) | (1<<STATUS_OVERTEMP);
+		break;
+		
+		case THERMAL_DERATING:
+		ucStatus = (1<<STATUS_DERATING);
+		break;
+		
+		default:
+		break;
+	}
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE) // the SPI ISR modifies the status register too
+	{
+		ucStatusBuffer = (ucStatusBuffer & ~((1<<STATUS_DERATING) | (1<<STATUS_OVERTEMP))) | ucStatus;
+	}
+}
+
+
+/** ***************************************************************************
+ * @brief Advance the running light effects
+ *
+ * Effects advance by one step per call and write into the back frame like
+ * the commands do. The sunrise engine sets the brightness level of the
+ * power LED and fills the strip with its color. Only changed
+ * outputs are applied, the color is written as soon as the back frame is
+ * unlocked and no frame upload is being received. The dutycycle buffer register follows in percent.
+ *
+ * A running effect (see effects.h) owns the strip: every step is rendered
+ * into the back frame and latched, the sunrise only drives the power LED.
+ * A step whose frame cannot be written (previous frame still waiting for
+ * its swap) is skipped, the effect keeps its speed.
+ * 
+ * @param [void] no input
+ * @return no return value
+ *****************************************************************************/
+void updateEffects(void)
+{
+	unsigned char ucChanged;
+
+	ucChanged = Sunrise_Step(&sSunrise);
+	if(ucChanged & SUNRISE_DUTY_CHANGED)
+	{
+		setDutyLevel(sSunrise.uiDuty);
+		ucDutyBuffer = levelToPercent(sSunrise.uiDuty);
+	}
+	if(ucChanged & SUNRISE_COLOR_CHANGED)
+	{
+		ucSunriseColorPending = 1;
+	}
+	if(ucChanged & SUNRISE_FINISHED)
+	{
+		setSunriseStatus(0);
+	}
+
+	if(Effect_IsRunning())
+	{
+		if((ucFormat==FORMAT_GRB) && (backFrameWritable()) && (lockBackFrame()))
+		{
+			if((Effect_IsRunning()) && (backFrameWritable())) // not stopped by a frame upload meanwhile
+			{
+				Effect_Render(getBackFrame(0), uiLEDCount);
+				latchFrame();
+			}
+			unlockBackFrame();
 		}
-		wait_1ms(1000);
+		Effect_Step();
+		return;
+	}
+
+	if((ucSunriseColorPending) && (backFrameWritable()) && (paletteWritable()) && (lockBackFrame()))
+	{
+		fillColor(sSunrise.aucColor[0], sSunrise.aucColor[1], sSunrise.aucColor[2]);
+		unlockBackFrame();
+		ucSunriseColorPending = 0;
+	}
+}
+
+
+/** ***************************************************************************
+ * @brief Register the tasks of the main loop
+ *
+ * - commands: every TASK_PERIOD_COMMANDS, a received command is executed
+ *   within a millisecond
+ * - temperature: every TASK_PERIOD_TEMPERATURE, the ADC measures in the
+ *   background
+ * - effects: every TASK_PERIOD_EFFECTS, steps of the sunrise program and
+ *   the frames of the running effect (fixed frame rate)
+ * 
+ * @param [void] no input
+ * @return no return value
+ *****************************************************************************/
+void initTasks(void)
+{
+	Scheduler_Init();
+	Scheduler_AddTask(processCommands, TASK_PERIOD_COMMANDS);
+	Scheduler_AddTask(updateTemperature, TASK_PERIOD_TEMPERATURE);
+	Scheduler_AddTask(updateEffects, TASK_PERIOD_EFFECTS);
+}
+
+
+/** ***************************************************************************
+ * @brief Main function - Entry point
+ *
+ * All initialization functions get called first and interrupts are globally
+ * enabled. The last saved or recalled scene is restored by the first pass of
+ * the command task (see restoreScene()), the light is back within
+ * milliseconds of a reset without waiting for the RPi.
+ * 
+ * The main loop runs the tasks of the cooperative scheduler (see initTasks()):
+ * complete commands of the command queue are executed on every 1ms tick, the
+ * temperature and the thermal derating of the power LED are updated
+ * periodically. Between the ticks the CPU sleeps in idle mode, every
+ * interrupt wakes it up to check for due tasks.
+ * 
+ * @param [void] no input
+ * @return no return value
+ *****************************************************************************/
+void main(void)
+{
+	// INITIALIZATION
+	systemInit();
+	restoreScene();
+	initTasks();
+	
+	while(1)
+	{
+		Scheduler_Run();
+		Scheduler_Sleep(); // until the next interrupt
 	}
 }
\ No newline at end of file
@@ -0,0 +1,97 @@
+/** ***************************************************************************
+ * @file main.h
+ * @brief Configuration and entry points of the main file
+ *
+ * The initialization and the command execution of the main loop are split
+ * into separate functions. This allows the host build (see host/Makefile) to
+ * link the real ISRs and command logic against the simulated peripherals.
+ *
+ * The strip length and the framebuffer format are set at runtime (framed
+ * command 0x94, stored in the EEPROM). The framebuffers share a pool of
+ * FRAME_POOL_SIZE bytes of SRAM. A frame holds the colors in wire order
+ * (FORMAT_GRB) or a palette index per LED (FORMAT_PAL8, FORMAT_PAL4). The
+ * palette is stored once at the start of the pool and shared by both frames.
+ * The storage mode follows from the size of a frame:
+ *
+ * | format           | storage mode   | SRAM                      | maximum length |
+ * |------------------|----------------|---------------------------|----------------|
+ * | FORMAT_GRB       | STORAGE_DOUBLE | 2 x 3 bytes per LED       | 170 LEDs       |
+ * | FORMAT_GRB       | STORAGE_SINGLE | 3 bytes per LED           | 341 LEDs       |
+ * | FORMAT_PAL8 (64) | STORAGE_DOUBLE | 192 + 2 x 1 byte per LED  | 416 LEDs       |
+ * | FORMAT_PAL8 (64) | STORAGE_SINGLE | 192 + 1 byte per LED      | 832 LEDs       |
+ * | FORMAT_PAL4 (16) | STORAGE_DOUBLE | 48 + 2 x 1/2 byte per LED | 976 LEDs       |
+ * | FORMAT_PAL4 (16) | STORAGE_SINGLE | 48 + 1/2 byte per LED     | 1952 LEDs      |
+ *
+ * Double buffering writes the next frame while the current one is sent.
+ * With a single buffer, commands and frame uploads wait until the transfer
+ * of the strip has ended (about 35us per LED).
+ *
+ * SRAM budget of the ATmega328 (2048 bytes): the other static variables
+ * take about 460 bytes, counted from the declarations with the avr-gcc
+ * sizes (2 byte int and pointers). The command queue needs 258 of them, the
+ * Debug configuration adds 15 for the instrumentation. This leaves about 560
+ * bytes for the stack. The deepest path is processCommands() recalling or
+ * saving a scene plus one ISR and needs roughly 200 bytes, so the margin is
+ * more than 300 bytes. Check .data + .bss with avr-size after changing
+ * FRAME_POOL_SIZE or the queue. The sum must stay below 1850 bytes.
+ *
+ * @author agent
+ * @date 16.10.2026
+ *****************************************************************************/
+
+
+#ifndef MAIN_H_
+#define MAIN_H_
+
+#define LED_COUNT_DEFAULT		20						///< RGB LED strip length until it is set with 0x94
+#define FRAME_POOL_SIZE			1024					///< SRAM for the framebuffers [bytes], see the SRAM budget above
+
+#define FORMAT_GRB		0		///< framebuffer format: green, red, blue per LED (wire order)
+#define FORMAT_PAL8		1		///< framebuffer format: palette of PALETTE8_ENTRIES colors, 8bit index per LED
+#define FORMAT_PAL4		2		///< framebuffer format: palette of PALETTE4_ENTRIES colors, 4bit index per LED
+#define FORMATS			3		///< amount of framebuffer formats
+
+#define PALETTE8_ENTRIES	64							///< colors of the FORMAT_PAL8 palette (power of two)
+#define PALETTE4_ENTRIES	16							///< colors of the FORMAT_PAL4 palette
+#define PALETTE8_SIZE		(PALETTE8_ENTRIES*3)		///< bytes of the FORMAT_PAL8 palette
+#define PALETTE4_SIZE		(PALETTE4_ENTRIES*3)		///< bytes of the FORMAT_PAL4 palette
+
+#define LED_COUNT_MAX_GRB	(FRAME_POOL_SIZE/3)							///< maximum strip length with FORMAT_GRB (single buffer)
+#define LED_COUNT_MAX_PAL8	(FRAME_POOL_SIZE-PALETTE8_SIZE)				///< maximum strip length with FORMAT_PAL8 (single buffer)
+#define LED_COUNT_MAX		((FRAME_POOL_SIZE-PALETTE4_SIZE)*2)			///< maximum strip length (FORMAT_PAL4, single buffer)
+
+#define STORAGE_DOUBLE	0		///< storage mode: front and back frame
+#define STORAGE_SINGLE	1		///< storage mode: one frame, written while the strip is idle
+
+#define REG_CONFIG			0x10	///< first configuration register, registers below are instrumentation (instrument.h)
+#define REG_LED_COUNT_HIGH	0x10	///< register: strip length, high byte
+#define REG_LED_COUNT_LOW	0x11	///< register: strip length, low byte
+#define REG_STORAGE			0x12	///< register: storage mode (STORAGE_*)
+#define REG_MAX_DOUBLE_HIGH	0x13	///< register: maximum length of the format with STORAGE_DOUBLE, high byte
+#define REG_MAX_DOUBLE_LOW	0x14	///< register: maximum length of the format with STORAGE_DOUBLE, low byte
+#define REG_MAX_SINGLE_HIGH	0x15	///< register: maximum length of the format with STORAGE_SINGLE, high byte
+#define REG_MAX_SINGLE_LOW	0x16	///< register: maximum length of the format with STORAGE_SINGLE, low byte
+#define REG_FORMAT			0x17	///< register: framebuffer format (FORMAT_*)
+#define REG_SCENE			0x18	///< register: scene restored at boot (SCENE_NONE: none, see scene.h)
+
+#define STATUS_PLED		0		///< status register bit: power LED enabled
+#define STATUS_DERATING	1		///< status register bit: power LED dutycycle reduced (temperature)
+#define STATUS_OVERTEMP	2		///< status register bit: power LED temperature limit reached
+#define STATUS_SUNRISE	3		///< status register bit: sunrise program running
+#define STATUS_BUSY		4		///< status register bit: command queue nearly full, wait before sending more commands
+#define STATUS_DROPPED	5		///< status register bit: command or frame lost since the last status read
+#define STATUS_EFFECT	6		///< status register bit: effect running (see effects.h)
+#define STATUS_SAVING	7		///< status register bit: scene being saved, commands wait (see scene.h)
+
+#define TASK_PERIOD_COMMANDS		1		///< period of the command task [ms]
+#define TASK_PERIOD_TEMPERATURE		100		///< period of the temperature task [ms]
+#define TASK_PERIOD_EFFECTS			20		///< period of the effects task [ms]
+
+void systemInit(void);
+void restoreScene(void);
+void initTasks(void);
+void processCommands(void);
+void updateTemperature(void);
+void updateEffects(void);
+
+#endif /* MAIN_H_ */
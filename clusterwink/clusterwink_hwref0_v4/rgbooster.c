@@ -11,8 +11,16 @@
  * the !done/busy pin. Using an external interrupt pin for this !done/busy
  * greatly increases the speed and "multitasking" capability of the system.
  *
- * This file also includes the functions to send data to the RGBooster without
- * the interrupt functionality.
+ * A transfer sends a buffer in wire order (one byte per handshake) of any
+ * length. RGBooster_Start() outputs the first byte, ISR(INT1_vect) every
+ * following one. The handshake of the last byte ends the transfer and calls
+ * the completion hook, which may start the next transfer right away (e.g. the
+ * next frame) without a gap on the strip.
+ *
+ * A palette transfer (RGBooster_StartPalette()) sends a palette color per LED
+ * instead. The read pointer then runs over the 3 bytes of the palette entry
+ * of the current LED, the next index is only looked up at the end of an
+ * entry. The per byte path of the ISR is the same for both kinds.
  *
  * @author lopeslen, nosedmar
  * @date 14.11.2017
@@ -21,9 +29,22 @@
 
  #include <avr/io.h>
  #include <avr/interrupt.h>
+ #include <util/atomic.h>
  #include "utils.h"
+ #include "instrument.h"
  #include "rgbooster.h"
- 
+
+
+static const unsigned char* volatile ucTxData_ptr = 0;	///< next byte of the transfer (ISR)
+static const unsigned char* volatile ucTxEnd_ptr = 0;	///< end of the transfer (ISR)
+static volatile unsigned char ucTxBusy = 0;				///< transfer in progress, INT1 handshakes expected (ISR)
+static const unsigned char* volatile ucTxIndex_ptr = 0;	///< next palette index (ISR)
+static const unsigned char* volatile ucTxPalette_ptr = 0;	///< palette of the transfer (ISR)
+static volatile unsigned int uiTxLEDs = 0;				///< LEDs left to look up in the palette, 0: none or no palette (ISR)
+static volatile unsigned char ucTxBits = 8;				///< bits per palette index: 8 or 4 (ISR)
+static volatile unsigned char ucTxNibble = 0;			///< next 4bit index is in the high nibble (ISR)
+static volatile RGBOOSTER_DONE pfTxDone = 0;			///< completion hook, 0: none (ISR)
+
 
 /** ***************************************************************************
  * @brief Initializes the external interrupt pin INT1 on falling edges
@@ -64,70 +85,202 @@
 
 
 /** ***************************************************************************
- * @brief Send RGB data to one LED (polling the !done/busy pin)
+ * @brief Output one byte to the data lines and generate the send impulse
  * 
- * @param [in] ucRed: red data byte [0-255]
- * @param [in] ucGreen: green data byte [0-255]
- * @param [in] ucBlue: blue data byte [0-255]
+ * @param [in] ucData: data byte
  * @return no return value
  *****************************************************************************/
- void SendBit(unsigned char ucRed,unsigned char ucGreen, unsigned char ucBlue)
- {
-	 while(PIN_CONTROL & (1<<DONE_BUSY)); //WAIT FOR IDLE
+static inline void sendByte(unsigned char ucData)
+{
+	PORT_DATA_HIGH = (PORT_DATA_HIGH & ~DATA_HIGH_BITMASK) | (ucData & DATA_HIGH_BITMASK);
+	PORT_DATA_LOW = (PORT_DATA_LOW & ~DATA_LOW_BITMASK) | (ucData & DATA_LOW_BITMASK);
+	PORT_CONTROL |= (1<<SEND); // generate send impulse
+	PORT_CONTROL &= ~(1<<SEND);
+}
 
-	 PORT_DATA_HIGH = (PORT_DATA_HIGH & ~DATA_HIGH_BITMASK) | (ucGreen & DATA_HIGH_BITMASK);
-	 PORT_DATA_LOW = (PORT_DATA_LOW & ~DATA_LOW_BITMASK) | (ucGreen & DATA_LOW_BITMASK);
-	 PORT_CONTROL |= (1<<SEND); //SEND
-	 PORT_CONTROL &= ~(1<<SEND);
 
-	 while(PIN_CONTROL & (1<<DONE_BUSY)); //WAIT FOR IDLE
+/** ***************************************************************************
+ * @brief Look the color of the next LED of a palette transfer up
+ *
+ * 4bit indices are packed two per byte, the first LED in the low nibble.
+ * 
+ * @param [void] no input
+ * @return palette entry (green, red, blue)
+ *****************************************************************************/
+static inline const unsigned char* nextEntry(void)
+{
+	const unsigned char* ucIndex_ptr = ucTxIndex_ptr;
+	unsigned char ucIndex = *ucIndex_ptr;
 
-	 PORT_DATA_HIGH = (PORT_DATA_HIGH & ~DATA_HIGH_BITMASK) | (ucRed & DATA_HIGH_BITMASK);
-	 PORT_DATA_LOW = (PORT_DATA_LOW & ~DATA_LOW_BITMASK) | (ucRed & DATA_LOW_BITMASK);
-	 PORT_CONTROL |= (1<<SEND); //SEND
-	 PORT_CONTROL &= ~(1<<SEND);
+	if(ucTxBits==4)
+	{
+		if(ucTxNibble)
+		{
+			ucIndex >>= 4;
+			ucIndex_ptr++;
+		}
+		else
+		{
+			ucIndex &= 0x0F;
+		}
+		ucTxNibble ^= 1;
+	}
+	else
+	{
+		ucIndex_ptr++;
+	}
+	ucTxIndex_ptr = ucIndex_ptr;
+	uiTxLEDs--;
+	return ucTxPalette_ptr + (ucIndex*3);
+}
 
-	 while(PIN_CONTROL & (1<<DONE_BUSY)); //WAIT FOR IDLE
 
-	 PORT_DATA_HIGH = (PORT_DATA_HIGH & ~DATA_HIGH_BITMASK) | (ucBlue & DATA_HIGH_BITMASK);
-	 PORT_DATA_LOW = (PORT_DATA_LOW & ~DATA_LOW_BITMASK) | (ucBlue & DATA_LOW_BITMASK);
-	 PORT_CONTROL |= (1<<SEND); //SEND
-	 PORT_CONTROL &= ~(1<<SEND);
- }
+/** ***************************************************************************
+ * @brief Set the completion hook
+ *
+ * The hook is called by ISR(INT1_vect) (interrupts disabled) after the last
+ * handshake of every transfer. It has to be short and may call
+ * RGBooster_Start() to chain the next transfer.
+ * 
+ * @param [in] pfDone: completion hook, 0: none
+ * @return no return value
+ *****************************************************************************/
+void RGBooster_SetDoneHook(RGBOOSTER_DONE pfDone)
+{
+	pfTxDone = pfDone;
+}
 
 
 /** ***************************************************************************
- * @brief Send RGB data to multiple LEDs (polling the !done/busy pin)
+ * @brief Start the transfer of a buffer
+ *
+ * The first byte is sent immediately, the others by ISR(INT1_vect). The
+ * buffer is read until the end of the transfer and must not be changed in
+ * the meantime. Can be called from the main loop and from the completion
+ * hook. A buffer of length 0 is not sent and does not call the hook.
  * 
- * @param [in] ucRed_ptr: pointer to red char array
- * @param [in] ucGreen_ptr: pointer to green char array
- * @param [in] ucBlue_ptr: pointer to blue char array
- * @param [in] ucLength: length of the char arrays (all need to be the same length)
- * @return no return value
+ * @param [in] pucData: bytes in wire order (green, red, blue per LED)
+ * @param [in] uiLength: amount of bytes
+ * @return 1: transfer started  0: another transfer in progress
  *****************************************************************************/
- void SendStrip(unsigned char* ucRed_ptr, unsigned char* ucGreen_ptr, unsigned char* ucBlue_ptr, unsigned char ucLength)
- {
-	 unsigned int i;
+unsigned char RGBooster_Start(const unsigned char* pucData, unsigned int uiLength)
+{
+	unsigned char ucResult = 0;
 
-	 for(i=0;i<(ucLength);i++)
-	 {
-		 SendBit(*(ucRed_ptr+i),*(ucGreen_ptr+i),*(ucBlue_ptr+i));
-	 }
- }
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+	{
+		if(!ucTxBusy)
+		{
+			ucResult = 1;
+			if(uiLength)
+			{
+				ucTxBusy = 1;
+				uiTxLEDs = 0;
+				ucTxData_ptr = pucData + 1;
+				ucTxEnd_ptr = pucData + uiLength;
+				sendByte(*pucData);
+			}
+		}
+	}
+	return ucResult;
+}
+
+
+/** ***************************************************************************
+ * @brief Start the transfer of a palette indexed frame
+ *
+ * Every LED gets the palette entry selected by its index. The indices have
+ * to be smaller than the amount of palette entries. Palette and indices are
+ * read until the end of the transfer, a changed palette entry applies to the
+ * LEDs not sent yet. Otherwise like RGBooster_Start().
+ * 
+ * @param [in] pucPalette: palette entries (green, red, blue each)
+ * @param [in] pucIndex: palette indices, one byte per LED (8bit) or two LEDs per byte (4bit, low nibble first)
+ * @param [in] uiLEDs: amount of LEDs
+ * @param [in] ucBits: bits per index: 8 or 4
+ * @return 1: transfer started  0: another transfer in progress
+ *****************************************************************************/
+unsigned char RGBooster_StartPalette(const unsigned char* pucPalette, const unsigned char* pucIndex, unsigned int uiLEDs, unsigned char ucBits)
+{
+	unsigned char ucResult = 0;
+	const unsigned char* ucEntry_ptr;
+
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+	{
+		if(!ucTxBusy)
+		{
+			ucResult = 1;
+			if(uiLEDs)
+			{
+				ucTxBusy = 1;
+				ucTxPalette_ptr = pucPalette;
+				ucTxIndex_ptr = pucIndex;
+				ucTxBits = ucBits;
+				ucTxNibble = 0;
+				uiTxLEDs = uiLEDs;
+				ucEntry_ptr = nextEntry();
+				ucTxData_ptr = ucEntry_ptr + 1;
+				ucTxEnd_ptr = ucEntry_ptr + 3;
+				sendByte(*ucEntry_ptr);
+			}
+		}
+	}
+	return ucResult;
+}
 
 
 /** ***************************************************************************
- * @brief Turn off multiple LEDs (polling the !done/busy pin)
+ * @brief Check if a transfer is in progress
  * 
- * @param [in] ucLength: length of the strip to turn off
+ * @param [void] no input
+ * @return 1: transfer in progress  0: idle, the last transfer is done
+ *****************************************************************************/
+unsigned char RGBooster_IsBusy(void)
+{
+	return ucTxBusy;
+}
+
+
+/** ***************************************************************************
+ * @brief External interrupt on INT1
+ *
+ * This ISR outputs the next byte of the transfer. The buffer is stored in
+ * wire order, so every handshake only loads the byte at the read pointer,
+ * splits it onto the two data ports, generates the send impulse and advances
+ * the pointer. The handshake of the RGBooster board will bring the program
+ * execution back to this ISR.
+ * At the end of a palette entry the entry of the next LED is looked up.
+ * The handshake of the last byte ends the transfer and calls the completion
+ * hook. Unless the hook starts a new transfer, no more data is sent and thus
+ * no more handshakes will invoke this ISR.
+ * 
+ * @param [in] INT1_vect: External Interrupt Request 1
  * @return no return value
  *****************************************************************************/
- void SendStrip_Off(unsigned char ucLength)
- {
-	 unsigned int i;
+ISR(INT1_vect)	// external interrupt (handshake from RGBooster board)
+{
+	const unsigned char* ucData_ptr = ucTxData_ptr;
+	RGBOOSTER_DONE pfDone;
+	INSTR_ENTRY();
+
+	if(ucData_ptr==ucTxEnd_ptr) // end of the buffer or of a palette entry
+	{
+		if(!uiTxLEDs) // last handshake of the transfer
+		{
+			ucTxBusy = 0;
+			pfDone = pfTxDone;
+			if(pfDone)
+			{
+				pfDone();
+			}
+			INSTR_EXIT(INSTR_INT1);
+			return;
+		}
+		ucData_ptr = nextEntry();
+		ucTxEnd_ptr = ucData_ptr + 3;
+	}
 
-	 for(i=0;i<(ucLength);i++)
-	 {
-		 SendBit(0,0,0);
-	 }
- }
\ No newline at end of file
+	sendByte(*ucData_ptr);
+	ucTxData_ptr = ucData_ptr + 1;
+	INSTR_EXIT(INSTR_INT1);
+}
@@ -11,6 +11,11 @@
  * the !done/busy pin. Using an external interrupt pin for this !done/busy
  * greatly increases the speed and "multitasking" capability of the system.
  *
+ * A transfer of any buffer in wire order is started with RGBooster_Start()
+ * and runs in the background, driven by the handshakes. Its end is polled
+ * with RGBooster_IsBusy() or signalled by the completion hook. Palette
+ * indexed frames are expanded to wire order on the fly.
+ *
  * @author lopeslen, nosedmar
  * @date 14.11.2017
  *****************************************************************************/
@@ -36,10 +41,19 @@
 #define SEND				2 		///< send pin (output)
 #define DONE_BUSY			3 		///< !done/busy pin (input)
 
+#define GRB_GREEN			0		///< wire order: offset of the green byte of a LED
+#define GRB_RED				1		///< wire order: offset of the red byte of a LED
+#define GRB_BLUE			2		///< wire order: offset of the blue byte of a LED
+
+
+/** Completion hook, called by ISR(INT1_vect) after the last handshake of a transfer */
+typedef void (*RGBOOSTER_DONE)(void);
+
 void INT1_Init(void);
 void initRGBooster(void);
-void SendBit(unsigned char ucRed,unsigned char ucGreen, unsigned char ucBlue);
-void SendStrip(unsigned char* ucRed_ptr, unsigned char* ucGreen_ptr, unsigned char* ucBlue_ptr, unsigned char ucLength);
-void SendStrip_Off(unsigned char ucLength);
+void RGBooster_SetDoneHook(RGBOOSTER_DONE pfDone);
+unsigned char RGBooster_Start(const unsigned char* pucData, unsigned int uiLength);
+unsigned char RGBooster_StartPalette(const unsigned char* pucPalette, const unsigned char* pucIndex, unsigned int uiLEDs, unsigned char ucBits);
+unsigned char RGBooster_IsBusy(void);
 
 #endif /* RGBOOSTER_H_ */
\ No newline at end of file
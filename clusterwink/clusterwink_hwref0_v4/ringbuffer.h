@@ -38,6 +38,18 @@
  *  a multithreaded ISR based system) however the same kind of operation (two or more insertions
  *  or deletions) must not overlap. If there is possibility of two or more of the same kind of
  *  operating occuring at the same point in time, atomic (mutex) locking should be used.
+ *
+ *  By default the element count is a separate variable which is updated inside of an atomic
+ *  block on every insertion and removal. Defining RINGBUFFER_SPSC (before including this file
+ *  or in the project settings) selects a lock-free single producer, single consumer variant
+ *  with the same functions: the buffer is indexed by free running 8 bit head and tail indices
+ *  and the count is derived as head - tail. Each index is only written by one side and a byte
+ *  access is atomic on the AVR, so no interrupts are disabled. BUFFER_SIZE must be a power of
+ *  two up to 128 in this mode.
+ *
+ *  The firmware does not use this file any more: the SPI ISR assembles the commands directly in
+ *  the records of the command queue (cmdqueue.h). The lock-free mode, the block and span access
+ *  and the checked insertions are only exercised by the host benchmark (host/bench_ringbuffer.c).
  */
  
 #ifndef _ULW_RING_BUFF_H_
@@ -48,6 +60,7 @@
 
 #include <stdint.h>
 #include <stdbool.h>
+#include <string.h>
 
 /* Defines: */
 /** Size of each ring buffer, in data elements - must be between 1 and 255. */
@@ -59,7 +72,16 @@
 /** Datatype which may be used to store the count of data stored in a buffer, retrieved
  *  via a call to \ref RingBuffer_GetCount().
  */
-#if (BUFFER_SIZE <= 0xFF)
+#if defined(RINGBUFFER_SPSC)
+	#if ((BUFFER_SIZE & (BUFFER_SIZE - 1)) != 0) || (BUFFER_SIZE > 128)
+		#error "RINGBUFFER_SPSC: BUFFER_SIZE must be a power of two up to 128"
+	#endif
+	#define RingBuff_Count_t   uint8_t
+	#define RINGBUFFER_MASK    (BUFFER_SIZE - 1)	///< index mask of the free running indices
+
+	/** compiler barrier: data accesses are not moved across an index update */
+	#define RINGBUFFER_BARRIER()	__asm__ __volatile__ ("" ::: "memory")
+#elif (BUFFER_SIZE <= 0xFF)
 	#define RingBuff_Count_t   uint8_t
 #else
 	#define RingBuff_Count_t   uint16_t
@@ -69,6 +91,14 @@
 /** Type define for a new ring buffer object. Buffers should be initialized via a call to
  *  \ref RingBuffer_InitBuffer() before use.
  */
+#if defined(RINGBUFFER_SPSC)
+typedef struct
+{
+	RingBuff_Data_t  Buffer[BUFFER_SIZE]; 	///< Internal ring buffer data, referenced by the buffer indices. */
+	volatile uint8_t Head; 					///< Free running storage index, only written by the producer */
+	volatile uint8_t Tail; 					///< Free running retrieval index, only written by the consumer */
+} RingBuff_t;
+#else
 typedef struct
 {
 	RingBuff_Data_t  Buffer[BUFFER_SIZE]; 	///< Internal ring buffer data, referenced by the buffer pointers. */
@@ -76,6 +106,7 @@ typedef struct
 	RingBuff_Data_t* Out; 					///< Current retrieval location in the circular buffer */
 	RingBuff_Count_t Count;					///< Amount of elements currently stored in the ringbuffer
 } RingBuff_t;
+#endif
 
 /* Inline Functions: */
 /** Initializes a ring buffer ready for use. Buffers must be initialized via this function
@@ -89,9 +120,14 @@ static inline void RingBuffer_InitBuffer(RingBuff_t* const Buffer)
 {
 	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
 	{
+#if defined(RINGBUFFER_SPSC)
+		Buffer->Head  = 0;
+		Buffer->Tail  = 0;
+#else
 		Buffer->In    = Buffer->Buffer;
 		Buffer->Out   = Buffer->Buffer;
 		Buffer->Count = 0;
+#endif
 	}
 }
 
@@ -106,10 +142,16 @@ static inline void RingBuffer_InitBuffer(RingBuff_t* const Buffer)
  *        the returned number should be used only to determine how many successive reads may safely
  *        be performed on the buffer.
  *
+ *  \note In the RINGBUFFER_SPSC mode the count is the difference of the two indices. Both are
+ *        single bytes, so no atomic lock is necessary.
+ *
  *  \param[in] Buffer  Pointer to a ring buffer structure whose count is to be computed
  */
 static inline RingBuff_Count_t RingBuffer_GetCount(RingBuff_t* const Buffer)
 {
+#if defined(RINGBUFFER_SPSC)
+	return (RingBuff_Count_t)(Buffer->Head - Buffer->Tail);
+#else
 	RingBuff_Count_t Count;
 	
 	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
@@ -118,6 +160,7 @@ static inline RingBuff_Count_t RingBuffer_GetCount(RingBuff_t* const Buffer)
 	}
 	
 	return Count;
+#endif
 }
 
 /** Atomically determines if the specified ring buffer contains any free space. This should
@@ -150,7 +193,9 @@ static inline bool RingBuffer_IsEmpty(RingBuff_t* const Buffer)
 	return (RingBuffer_GetCount(Buffer) == 0);
 }
 
-/** Inserts an element into the ring buffer.
+/** Inserts an element into the ring buffer. The free space is not checked, an insertion into a
+ *  full buffer overwrites the oldest element and corrupts the count. Use \ref RingBuffer_TryInsert()
+ *  if the buffer may be full.
  *
  *  \note Only one execution thread (main program thread or an ISR) may insert into a single buffer
  *        otherwise data corruption may occur. Insertion and removal may occur from different execution
@@ -163,6 +208,11 @@ static inline bool RingBuffer_IsEmpty(RingBuff_t* const Buffer)
 static inline void RingBuffer_Insert(RingBuff_t* const Buffer,
                                      const RingBuff_Data_t Data)
 {
+#if defined(RINGBUFFER_SPSC)
+	Buffer->Buffer[Buffer->Head & RINGBUFFER_MASK] = Data;
+	RINGBUFFER_BARRIER(); // data is stored before the consumer can see it
+	Buffer->Head++;
+#else
 	*Buffer->In = Data;
 	
 	if (++Buffer->In == &Buffer->Buffer[BUFFER_SIZE])
@@ -172,6 +222,29 @@ static inline void RingBuffer_Insert(RingBuff_t* const Buffer,
 	{
 		Buffer->Count++;
 	}
+#endif
+}
+
+/** Inserts an element into the ring buffer if it is not full. The consumer can only free space,
+ *  so the check stays valid until the element is stored.
+ *
+ *  \note Only one execution thread (main program thread or an ISR) may insert into a single buffer
+ *        otherwise data corruption may occur. Insertion and removal may occur from different execution
+ *        threads.
+ *
+ *  \param[in,out] Buffer  Pointer to a ring buffer structure to insert into
+ *  \param[in]     Data    Data element to insert into the buffer
+ *
+ *  \return Boolean true if the element was inserted, false if the buffer is full (nothing changed)
+ */
+static inline bool RingBuffer_TryInsert(RingBuff_t* const Buffer,
+                                        const RingBuff_Data_t Data)
+{
+	if (RingBuffer_IsFull(Buffer))
+	  return false;
+
+	RingBuffer_Insert(Buffer, Data);
+	return true;
 }
 
 /** Removes an element from the ring buffer.
@@ -186,6 +259,14 @@ static inline void RingBuffer_Insert(RingBuff_t* const Buffer,
  */
 static inline RingBuff_Data_t RingBuffer_Remove(RingBuff_t* const Buffer)
 {
+#if defined(RINGBUFFER_SPSC)
+	RingBuff_Data_t Data;
+	
+	RINGBUFFER_BARRIER(); // data is not read before the count was checked
+	Data = Buffer->Buffer[Buffer->Tail & RINGBUFFER_MASK];
+	RINGBUFFER_BARRIER(); // data is read before the producer can overwrite it
+	Buffer->Tail++;
+#else
 	RingBuff_Data_t Data = *Buffer->Out;
 	
 	if (++Buffer->Out == &Buffer->Buffer[BUFFER_SIZE])
@@ -195,10 +276,214 @@ static inline RingBuff_Data_t RingBuffer_Remove(RingBuff_t* const Buffer)
 	{
 		Buffer->Count--;
 	}
+#endif
 	
 	return Data;
 }
 
+/** Returns the storage location of the next inserted element.
+ *
+ *  \param[in] Buffer  Pointer to a ring buffer structure
+ *
+ *  \return Pointer into the internal buffer
+ */
+static inline RingBuff_Data_t* RingBuffer_WritePosition(RingBuff_t* const Buffer)
+{
+#if defined(RINGBUFFER_SPSC)
+	return &Buffer->Buffer[Buffer->Head & RINGBUFFER_MASK];
+#else
+	return Buffer->In;
+#endif
+}
+
+/** Returns the retrieval location of the next removed element.
+ *
+ *  \param[in] Buffer  Pointer to a ring buffer structure
+ *
+ *  \return Pointer into the internal buffer
+ */
+static inline RingBuff_Data_t* RingBuffer_ReadPosition(RingBuff_t* const Buffer)
+{
+#if defined(RINGBUFFER_SPSC)
+	return &Buffer->Buffer[Buffer->Tail & RINGBUFFER_MASK];
+#else
+	return Buffer->Out;
+#endif
+}
+
+/** Retrieves the largest contiguous block of stored elements, starting at the next element to
+ *  be removed. If the stored data wraps around the end of the internal buffer, the block ends
+ *  there and the second segment is returned by the next call (after \ref RingBuffer_CommitRead()).
+ *
+ *  \param[in] Buffer  Pointer to a ring buffer structure to retrieve from
+ *  \param[out] Span  Start of the contiguous block
+ *
+ *  \return Amount of elements which may be read at Span
+ */
+static inline RingBuff_Count_t RingBuffer_GetReadSpan(RingBuff_t* const Buffer, RingBuff_Data_t** Span)
+{
+	RingBuff_Count_t Count = RingBuffer_GetCount(Buffer);
+	RingBuff_Count_t ToEnd;
+	
+	*Span = RingBuffer_ReadPosition(Buffer);
+	ToEnd = (RingBuff_Count_t)(&Buffer->Buffer[BUFFER_SIZE] - *Span);
+	
+	return (Count < ToEnd) ? Count : ToEnd;
+}
+
+/** Retrieves the largest contiguous block of free elements, starting at the next storage location.
+ *  If the free space wraps around the end of the internal buffer, the block ends there and the
+ *  second segment is returned by the next call (after \ref RingBuffer_CommitWrite()).
+ *
+ *  \param[in] Buffer  Pointer to a ring buffer structure to insert into
+ *  \param[out] Span  Start of the contiguous block
+ *
+ *  \return Amount of elements which may be written at Span
+ */
+static inline RingBuff_Count_t RingBuffer_GetWriteSpan(RingBuff_t* const Buffer, RingBuff_Data_t** Span)
+{
+	RingBuff_Count_t Free = (RingBuff_Count_t)(BUFFER_SIZE - RingBuffer_GetCount(Buffer));
+	RingBuff_Count_t ToEnd;
+	
+	*Span = RingBuffer_WritePosition(Buffer);
+	ToEnd = (RingBuff_Count_t)(&Buffer->Buffer[BUFFER_SIZE] - *Span);
+	
+	return (Free < ToEnd) ? Free : ToEnd;
+}
+
+/** Makes elements which have been written directly to the internal buffer (e.g. into the block
+ *  returned by \ref RingBuffer_GetWriteSpan()) available for removal. The count is updated once.
+ *
+ *  \note Only one execution thread (main program thread or an ISR) may insert into a single buffer
+ *        otherwise data corruption may occur.
+ *
+ *  \param[in,out] Buffer  Pointer to a ring buffer structure to insert into
+ *  \param[in]     Length  Amount of written elements
+ *  \return no return value
+ */
+static inline void RingBuffer_CommitWrite(RingBuff_t* const Buffer, const RingBuff_Count_t Length)
+{
+#if defined(RINGBUFFER_SPSC)
+	RINGBUFFER_BARRIER(); // data is stored before the consumer can see it
+	Buffer->Head += Length;
+#else
+	Buffer->In += Length;
+	if (Buffer->In >= &Buffer->Buffer[BUFFER_SIZE])
+	  Buffer->In -= BUFFER_SIZE;
+
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+	{
+		Buffer->Count += Length;
+	}
+#endif
+}
+
+/** Releases elements which have been read directly from the internal buffer (e.g. from the block
+ *  returned by \ref RingBuffer_GetReadSpan()). The count is updated once.
+ *
+ *  \note Only one execution thread (main program thread or an ISR) may remove from a single buffer
+ *        otherwise data corruption may occur.
+ *
+ *  \param[in,out] Buffer  Pointer to a ring buffer structure to retrieve from
+ *  \param[in]     Length  Amount of read elements
+ *  \return no return value
+ */
+static inline void RingBuffer_CommitRead(RingBuff_t* const Buffer, const RingBuff_Count_t Length)
+{
+#if defined(RINGBUFFER_SPSC)
+	RINGBUFFER_BARRIER(); // data is read before the producer can overwrite it
+	Buffer->Tail += Length;
+#else
+	Buffer->Out += Length;
+	if (Buffer->Out >= &Buffer->Buffer[BUFFER_SIZE])
+	  Buffer->Out -= BUFFER_SIZE;
+
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+	{
+		Buffer->Count -= Length;
+	}
+#endif
+}
+
+/** Inserts a block of elements into the ring buffer. The data is copied in at most two segments
+ *  and the count is updated once. The caller has to make sure that enough space is free.
+ *
+ *  \note Only one execution thread (main program thread or an ISR) may insert into a single buffer
+ *        otherwise data corruption may occur. Insertion and removal may occur from different execution
+ *        threads.
+ *
+ *  \param[in,out] Buffer  Pointer to a ring buffer structure to insert into
+ *  \param[in]     Source  Data elements to insert into the buffer
+ *  \param[in]     Length  Amount of elements to insert
+ *  \return no return value
+ */
+static inline void RingBuffer_InsertBlock(RingBuff_t* const Buffer, const RingBuff_Data_t* Source,
+                                          const RingBuff_Count_t Length)
+{
+	RingBuff_Data_t* Position = RingBuffer_WritePosition(Buffer);
+	RingBuff_Count_t First = (RingBuff_Count_t)(&Buffer->Buffer[BUFFER_SIZE] - Position);
+	
+	if (First > Length)
+	  First = Length;
+
+	memcpy(Position, Source, First);
+	memcpy(Buffer->Buffer, Source + First, Length - First);
+	RingBuffer_CommitWrite(Buffer, Length);
+}
+
+/** Inserts a block of elements (e.g. a complete command) into the ring buffer if all of them fit.
+ *  Otherwise nothing is inserted, so the consumer never sees a partial block.
+ *
+ *  \note Only one execution thread (main program thread or an ISR) may insert into a single buffer
+ *        otherwise data corruption may occur. Insertion and removal may occur from different execution
+ *        threads.
+ *
+ *  \param[in,out] Buffer  Pointer to a ring buffer structure to insert into
+ *  \param[in]     Source  Data elements to insert into the buffer
+ *  \param[in]     Length  Amount of elements to insert
+ *
+ *  \return Boolean true if the block was inserted, false if it does not fit (nothing changed)
+ */
+static inline bool RingBuffer_TryInsertBlock(RingBuff_t* const Buffer, const RingBuff_Data_t* Source,
+                                             const RingBuff_Count_t Length)
+{
+	if ((RingBuff_Count_t)(BUFFER_SIZE - RingBuffer_GetCount(Buffer)) < Length)
+	  return false;
+
+	RingBuffer_InsertBlock(Buffer, Source, Length);
+	return true;
+}
+
+/** Removes a block of elements from the ring buffer. The data is copied out in at most two
+ *  segments and the count is updated once. The caller has to make sure that enough elements
+ *  are stored.
+ *
+ *  \note Only one execution thread (main program thread or an ISR) may remove from a single buffer
+ *        otherwise data corruption may occur. Insertion and removal may occur from different execution
+ *        threads.
+ *
+ *  \param[in,out] Buffer  Pointer to a ring buffer structure to retrieve from
+ *  \param[out]    Destination  Array to store the data in
+ *  \param[in]     Length  Amount of elements to remove
+ *  \return no return value
+ */
+static inline void RingBuffer_RemoveBlock(RingBuff_t* const Buffer, RingBuff_Data_t* Destination,
+                                          const RingBuff_Count_t Length)
+{
+	RingBuff_Data_t* Position = RingBuffer_ReadPosition(Buffer);
+	RingBuff_Count_t First = (RingBuff_Count_t)(&Buffer->Buffer[BUFFER_SIZE] - Position);
+	
+	if (First > Length)
+	  First = Length;
+
+#if defined(RINGBUFFER_SPSC)
+	RINGBUFFER_BARRIER(); // data is not read before the count was checked
+#endif
+	memcpy(Destination, Position, First);
+	memcpy(Destination + First, Buffer->Buffer, Length - First);
+	RingBuffer_CommitRead(Buffer, Length);
+}
+
 /** Peak at the elements from the ring buffer without removing them.
  *
  *  \param[in,out] Buffer  Pointer to a ring buffer structure to retrieve from
@@ -210,6 +495,16 @@ static inline RingBuff_Data_t RingBuffer_Remove(RingBuff_t* const Buffer)
 static inline void RingBuffer_Peak(RingBuff_t* const Buffer, RingBuff_Data_t* Destination, RingBuff_Count_t PeakLength)
 {
 	int i;
+#if defined(RINGBUFFER_SPSC)
+	uint8_t currentRead = Buffer->Tail;
+
+	RINGBUFFER_BARRIER();
+	for(i=0;i<PeakLength;i++)
+	{
+		*(Destination+i) = Buffer->Buffer[currentRead & RINGBUFFER_MASK];
+		currentRead++;
+	}
+#else
 	RingBuff_Data_t* currentRead = Buffer->Out;
 
 	for(i=0;i<PeakLength;i++)
@@ -217,6 +512,7 @@ static inline void RingBuffer_Peak(RingBuff_t* const Buffer, RingBuff_Data_t* De
 		*(Destination+i) = *currentRead;
 		if (++currentRead == &Buffer->Buffer[BUFFER_SIZE]) currentRead = Buffer->Buffer;
 	}
+#endif
 	*(Destination+PeakLength) = 0;
 }
 
@@ -231,6 +527,20 @@ static inline RingBuff_Count_t RingBuffer_CountChar(RingBuff_t* const Buffer, ch
 {
 	RingBuff_Count_t count = 0;
 
+#if defined(RINGBUFFER_SPSC)
+	uint8_t currentRead = Buffer->Tail;
+	uint8_t currentHead = Buffer->Head;
+
+	RINGBUFFER_BARRIER();
+	while(currentRead != currentHead)
+	{
+		if(Buffer->Buffer[currentRead & RINGBUFFER_MASK]==charToCheck)
+		{
+			count++;
+		}
+		currentRead++;
+	}
+#else
 	RingBuff_Data_t* currentRead = Buffer->Out;
 
 	while(currentRead != Buffer->In)
@@ -241,10 +551,13 @@ static inline RingBuff_Count_t RingBuffer_CountChar(RingBuff_t* const Buffer, ch
 		}
 		if (++currentRead == &Buffer->Buffer[BUFFER_SIZE]) currentRead = Buffer->Buffer;
 	}
+#endif
 	return(count);
 }
 
-/** Removes all elements until a specified char from the ring buffer.
+/** Removes all elements until a specified char from the ring buffer. The elements are removed as
+ *  one block once the termination character has been located. If the buffer does not contain the
+ *  termination character, all stored elements are removed.
  *
  *  \note Only one execution thread (main program thread or an ISR) may remove from a single buffer
  *        otherwise data corruption may occur. Insertion and removal may occur from different execution
@@ -258,25 +571,32 @@ static inline RingBuff_Count_t RingBuffer_CountChar(RingBuff_t* const Buffer, ch
  */
 static inline void RingBuffer_RemoveUntilChar(RingBuff_t* const Buffer, RingBuff_Data_t* Destination, char endChar, uint8_t includingChar)
 {
-	RingBuff_Data_t tempData;
-	unsigned int uiDestinationOffset = 0;
+	RingBuff_Count_t Count = RingBuffer_GetCount(Buffer);
+	RingBuff_Count_t Length;
+	RingBuff_Data_t* currentRead = RingBuffer_ReadPosition(Buffer);
 	
-	while(1)
+	for(Length=0;Length<Count;Length++) // locate the termination character
 	{
-		tempData = RingBuffer_Remove(Buffer);
-		if(tempData == endChar)
+		if(*currentRead == endChar)
 		{
-			if(includingChar)
-			{
-				*(Destination+uiDestinationOffset) = tempData;
-				uiDestinationOffset++;
-			}
-			*(Destination+uiDestinationOffset) = 0;
 			break;
 		}
-		*(Destination+uiDestinationOffset) = tempData;
-		uiDestinationOffset++;
+		if (++currentRead == &Buffer->Buffer[BUFFER_SIZE]) currentRead = Buffer->Buffer;
+	}
+	
+	if(Length == Count) // no termination character: remove everything
+	{
+		RingBuffer_RemoveBlock(Buffer, Destination, Length);
+		*(Destination+Length) = 0;
+		return;
+	}
+	
+	RingBuffer_RemoveBlock(Buffer, Destination, Length+1); // one pass, one count update
+	if(includingChar)
+	{
+		Length++;
 	}
+	*(Destination+Length) = 0;
 }
 
 #endif
\ No newline at end of file
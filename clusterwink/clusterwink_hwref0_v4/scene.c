@@ -0,0 +1,375 @@
+/** ***************************************************************************
+ * @file scene.c
+ * @brief Scene store in the EEPROM
+ *
+ * Layout of a slot: [MAGIC, CRC, FLAGS, LH, LL, EFFECT..., RUNS, runs...].
+ * The CRC-8 covers everything behind it up to the last run. A save compares
+ * the scene with the slot first. Only if they differ, it writes the magic
+ * byte 0, then the header and the runs, the CRC and the magic byte last.
+ * The ring of the last scene follows in both cases. Scene_Step() handles one
+ * byte per call and writes it only if it changed, so saving the same scene
+ * again writes nothing but the wear-levelled ring. While the previous byte
+ * is still being written (3.4ms), Scene_Step() returns without waiting.
+ *
+ * Ring of the last scene: every byte holds a 5bit sequence number and the
+ * 3bit slot. The newest byte is the one whose successor does not continue
+ * the sequence. The ring is shorter than the sequence, so there is always
+ * exactly one such byte (an erased ring reads SCENE_NONE).
+ *
+ * All functions are called from the main loop only.
+ *
+ * @author agent
+ * @date 16.10.2026
+ *****************************************************************************/
+
+
+#include <avr/eeprom.h>
+#include "crc8.h"
+#include "scene.h"
+
+
+#define SCENE_MAGIC			0x5C	///< first byte of a valid slot
+#define SCENE_OFFSET_CRC	1		///< offset of the CRC in a slot
+#define SCENE_OFFSET_FLAGS	2		///< offset of the flags in a slot (start of the CRC)
+#define SCENE_OFFSET_RUNS	(SCENE_HEADER_SIZE-1)	///< offset of the amount of runs in a slot
+
+#define RING_SEQUENCE(entry)	((entry) >> 3)			///< sequence number of a ring byte
+#define RING_SLOT(entry)		((entry) & 0x07)		///< slot of a ring byte
+#define RING_SEQUENCE_MASK		0x1F					///< sequence numbers wrap around
+
+#define SAVE_IDLE			0		///< save state: no save in progress
+#define SAVE_COMPARE		1		///< save state: next byte is compared with the slot
+#define SAVE_INVALIDATE		2		///< save state: next byte is the magic byte 0
+#define SAVE_DATA			3		///< save state: next byte is a byte of the header or of a run
+#define SAVE_CRC			4		///< save state: next byte is the CRC
+#define SAVE_MAGIC			5		///< save state: next byte is the magic byte
+#define SAVE_LAST			6		///< save state: next byte is the ring of the last scene
+
+
+static uint8_t EEMEM aucSceneEE[SCENES][SCENE_SIZE];	///< scene slots (EEPROM)
+static uint8_t EEMEM aucLastEE[SCENE_RING_SIZE] =		///< ring of the last scene, erased (EEPROM)
+{
+	0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+	0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF
+};
+
+static volatile unsigned char ucSaveState = SAVE_IDLE;	///< state of the save (SAVE_*, read by the SPI ISR)
+static unsigned char ucSaveSlot = 0;					///< slot being saved
+static unsigned char ucSaveOffset = 0;					///< next byte of the slot (SAVE_COMPARE, SAVE_DATA)
+static unsigned char ucSaveEnd = 0;						///< end of the runs in the slot
+static unsigned char ucSaveCRC = CRC8_INIT;				///< CRC of the bytes compared or written so far
+static SCENE sSave;										///< scene being saved
+static SCENE_NEXT_RUN pfSaveRun = 0;					///< source of the runs of the scene being saved
+static unsigned char aucSaveRun[4];						///< run being written (amount of LEDs, green, red, blue)
+
+
+/** ***************************************************************************
+ * @brief Calculate the CRC of a slot
+ *
+ * @param [in] ucSlot: slot [0-SCENES-1]
+ * @param [in] ucRuns: amount of runs
+ * @return CRC-8 from the flags to the last run
+ *****************************************************************************/
+static unsigned char slotCRC(unsigned char ucSlot, unsigned char ucRuns)
+{
+	unsigned char i;
+	unsigned char ucCRC = CRC8_INIT;
+	unsigned char ucEnd = SCENE_HEADER_SIZE + (ucRuns*4);
+
+	for(i=SCENE_OFFSET_FLAGS;i<ucEnd;i++)
+	{
+		ucCRC = CRC8_Update(ucCRC, eeprom_read_byte(&aucSceneEE[ucSlot][i]));
+	}
+	return ucCRC;
+}
+
+
+/** ***************************************************************************
+ * @brief Find the newest byte of the ring of the last scene
+ *
+ * @param [void] no input
+ * @return index of the newest byte
+ *****************************************************************************/
+static unsigned char newestEntry(void)
+{
+	unsigned char i;
+	unsigned char ucEntry = eeprom_read_byte(&aucLastEE[0]);
+	unsigned char ucNext;
+
+	for(i=0;i<(SCENE_RING_SIZE-1);i++)
+	{
+		ucNext = eeprom_read_byte(&aucLastEE[i+1]);
+		if(RING_SEQUENCE(ucNext)!=((RING_SEQUENCE(ucEntry)+1) & RING_SEQUENCE_MASK))
+		{
+			break;
+		}
+		ucEntry = ucNext;
+	}
+	return i;
+}
+
+
+/** ***************************************************************************
+ * @brief Write a byte of the EEPROM if it changed
+ *
+ * @param [in] pucAddress: address of the byte
+ * @param [in] ucValue: value
+ * @return no return value
+ *****************************************************************************/
+static void updateByte(uint8_t* pucAddress, unsigned char ucValue)
+{
+	if(eeprom_read_byte(pucAddress)!=ucValue)
+	{
+		eeprom_write_byte(pucAddress, ucValue); // does not wait, the EEPROM is ready
+	}
+}
+
+
+/** ***************************************************************************
+ * @brief Get a byte of the header or of the runs of the scene being saved
+ *
+ * Called once per byte in ascending order, the runs are fetched from the
+ * source of the save at their first byte. Starting again at
+ * SCENE_OFFSET_FLAGS fetches the runs again from the first one.
+ *
+ * @param [in] ucOffset: offset in the slot [SCENE_OFFSET_FLAGS-ucSaveEnd-1]
+ * @return value of the byte
+ *****************************************************************************/
+static unsigned char saveByte(unsigned char ucOffset)
+{
+	unsigned char ucIndex;
+
+	if(ucOffset>=SCENE_HEADER_SIZE)
+	{
+		ucIndex = (ucOffset-SCENE_HEADER_SIZE) & 0x03;
+		if(ucIndex==0)
+		{
+			aucSaveRun[0] = pfSaveRun((unsigned char)((ucOffset-SCENE_HEADER_SIZE) >> 2), &aucSaveRun[1]);
+		}
+		return aucSaveRun[ucIndex];
+	}
+	switch(ucOffset)
+	{
+		case SCENE_OFFSET_FLAGS:
+		return sSave.ucFlags;
+		
+		case SCENE_OFFSET_FLAGS+1:
+		return (unsigned char)(sSave.uiDuty >> 8);
+		
+		case SCENE_OFFSET_FLAGS+2:
+		return (unsigned char)sSave.uiDuty;
+		
+		case SCENE_OFFSET_RUNS:
+		return sSave.ucRuns;
+		
+		default:
+		return sSave.aucEffect[ucOffset-(SCENE_OFFSET_FLAGS+3)];
+	}
+}
+
+
+/** ***************************************************************************
+ * @brief Start saving a scene
+ *
+ * The slot is compared first and stays valid if it already holds the
+ * scene. Otherwise it is invalid from the first written byte until the save
+ * is done. A save in progress is restarted.
+ *
+ * @param [in] ucSlot: slot [0-SCENES-1]
+ * @param [in] psScene: scene (ucRuns runs)
+ * @param [in] pfNextRun: source of the ucRuns runs, called by Scene_Step()
+ * @return no return value
+ *****************************************************************************/
+void Scene_Save(unsigned char ucSlot, const SCENE* psScene, SCENE_NEXT_RUN pfNextRun)
+{
+	sSave = *psScene;
+	pfSaveRun = pfNextRun;
+	ucSaveSlot = ucSlot;
+	ucSaveOffset = SCENE_OFFSET_FLAGS;
+	ucSaveEnd = SCENE_HEADER_SIZE + (psScene->ucRuns*4);
+	ucSaveCRC = CRC8_INIT;
+	ucSaveState = SAVE_COMPARE;
+}
+
+
+/** ***************************************************************************
+ * @brief Continue the save in progress
+ *
+ * Compares the next byte of the save with the slot, or writes it if it
+ * changed. Nothing is done while the EEPROM is still busy with the previous
+ * byte.
+ *
+ * @param [void] no input
+ * @return 1: save in progress  0: no save in progress (done)
+ *****************************************************************************/
+unsigned char Scene_Step(void)
+{
+	unsigned char ucValue;
+	uint8_t* pucSlot = aucSceneEE[ucSaveSlot];
+
+	if((ucSaveState==SAVE_IDLE) || (!eeprom_is_ready()))
+	{
+		return (ucSaveState!=SAVE_IDLE);
+	}
+	switch(ucSaveState)
+	{
+		case SAVE_COMPARE:
+		ucValue = saveByte(ucSaveOffset);
+		ucSaveCRC = CRC8_Update(ucSaveCRC, ucValue);
+		ucSaveOffset++;
+		if(eeprom_read_byte(&pucSlot[ucSaveOffset-1])!=ucValue)
+		{
+			ucSaveState = SAVE_INVALIDATE;
+		}
+		else if(ucSaveOffset>=ucSaveEnd)
+		{
+			if((eeprom_read_byte(&pucSlot[SCENE_OFFSET_CRC])==ucSaveCRC) && (eeprom_read_byte(&pucSlot[0])==SCENE_MAGIC))
+			{
+				ucSaveState = SAVE_LAST; // unchanged
+			}
+			else
+			{
+				ucSaveState = SAVE_INVALIDATE;
+			}
+		}
+		if(ucSaveState==SAVE_INVALIDATE)
+		{
+			ucSaveOffset = SCENE_OFFSET_FLAGS; // write from the start
+			ucSaveCRC = CRC8_INIT;
+		}
+		break;
+		
+		case SAVE_INVALIDATE:
+		updateByte(&pucSlot[0], 0);
+		ucSaveState = SAVE_DATA;
+		break;
+		
+		case SAVE_DATA:
+		ucValue = saveByte(ucSaveOffset);
+		ucSaveCRC = CRC8_Update(ucSaveCRC, ucValue);
+		updateByte(&pucSlot[ucSaveOffset], ucValue);
+		ucSaveOffset++;
+		if(ucSaveOffset>=ucSaveEnd)
+		{
+			ucSaveState = SAVE_CRC;
+		}
+		break;
+		
+		case SAVE_CRC:
+		updateByte(&pucSlot[SCENE_OFFSET_CRC], ucSaveCRC);
+		ucSaveState = SAVE_MAGIC;
+		break;
+		
+		case SAVE_MAGIC:
+		updateByte(&pucSlot[0], SCENE_MAGIC);
+		ucSaveState = SAVE_LAST;
+		break;
+		
+		default: // SAVE_LAST
+		Scene_SetLast(ucSaveSlot);
+		ucSaveState = SAVE_IDLE;
+		break;
+	}
+	return (ucSaveState!=SAVE_IDLE);
+}
+
+
+/** ***************************************************************************
+ * @brief Check if a save is in progress
+ *
+ * @param [void] no input
+ * @return 1: save in progress (see Scene_Step())  0: idle
+ *****************************************************************************/
+unsigned char Scene_IsSaving(void)
+{
+	return (ucSaveState!=SAVE_IDLE);
+}
+
+
+/** ***************************************************************************
+ * @brief Read a scene without its frame
+ *
+ * @param [in] ucSlot: slot
+ * @param [out] psScene: scene
+ * @return 1: valid scene  0: unknown slot, empty or corrupted
+ *****************************************************************************/
+unsigned char Scene_Read(unsigned char ucSlot, SCENE* psScene)
+{
+	unsigned char i;
+	const uint8_t* pucSlot;
+
+	if(ucSlot>=SCENES)
+	{
+		return 0;
+	}
+	pucSlot = aucSceneEE[ucSlot];
+	psScene->ucRuns = eeprom_read_byte(&pucSlot[SCENE_OFFSET_RUNS]);
+	if((eeprom_read_byte(&pucSlot[0])!=SCENE_MAGIC) || (psScene->ucRuns>SCENE_RUNS_MAX) ||
+		(eeprom_read_byte(&pucSlot[SCENE_OFFSET_CRC])!=slotCRC(ucSlot, psScene->ucRuns)))
+	{
+		return 0;
+	}
+	psScene->ucFlags = eeprom_read_byte(&pucSlot[SCENE_OFFSET_FLAGS]);
+	psScene->uiDuty = ((unsigned int)eeprom_read_byte(&pucSlot[SCENE_OFFSET_FLAGS+1]) << 8) | eeprom_read_byte(&pucSlot[SCENE_OFFSET_FLAGS+2]);
+	for(i=0;i<EFFECT_PAYLOAD_SIZE;i++)
+	{
+		psScene->aucEffect[i] = eeprom_read_byte(&pucSlot[SCENE_OFFSET_FLAGS+3+i]);
+	}
+	return 1;
+}
+
+
+/** ***************************************************************************
+ * @brief Read one run of the frame of a scene
+ *
+ * @param [in] ucSlot: slot of a valid scene (see Scene_Read())
+ * @param [in] ucRun: run [0-ucRuns-1]
+ * @param [out] aucColor: color in wire order (green, red, blue)
+ * @return amount of LEDs
+ *****************************************************************************/
+unsigned char Scene_ReadRun(unsigned char ucSlot, unsigned char ucRun, unsigned char* aucColor)
+{
+	const uint8_t* pucRun = &aucSceneEE[ucSlot][SCENE_HEADER_SIZE + (ucRun*4)];
+
+	aucColor[0] = eeprom_read_byte(&pucRun[1]);
+	aucColor[1] = eeprom_read_byte(&pucRun[2]);
+	aucColor[2] = eeprom_read_byte(&pucRun[3]);
+	return eeprom_read_byte(&pucRun[0]);
+}
+
+
+/** ***************************************************************************
+ * @brief Store the scene to restore at boot
+ *
+ * Nothing is written if the scene does not change.
+ *
+ * @param [in] ucSlot: slot [0-SCENES-1] or SCENE_NONE
+ * @return no return value
+ *****************************************************************************/
+void Scene_SetLast(unsigned char ucSlot)
+{
+	unsigned char ucNewest = newestEntry();
+	unsigned char ucEntry = eeprom_read_byte(&aucLastEE[ucNewest]);
+
+	if(RING_SLOT(ucEntry)==ucSlot)
+	{
+		return;
+	}
+	ucEntry = (unsigned char)((((RING_SEQUENCE(ucEntry)+1) & RING_SEQUENCE_MASK) << 3) | (ucSlot & 0x07));
+	ucNewest = (ucNewest+1) % SCENE_RING_SIZE;
+	eeprom_update_byte(&aucLastEE[ucNewest], ucEntry);
+}
+
+
+/** ***************************************************************************
+ * @brief Get the scene to restore at boot
+ *
+ * @param [void] no input
+ * @return slot [0-SCENES-1] or SCENE_NONE
+ *****************************************************************************/
+unsigned char Scene_GetLast(void)
+{
+	unsigned char ucSlot = RING_SLOT(eeprom_read_byte(&aucLastEE[newestEntry()]));
+
+	return (ucSlot<SCENES) ? ucSlot : SCENE_NONE;
+}
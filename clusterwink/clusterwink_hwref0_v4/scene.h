@@ -0,0 +1,73 @@
+/** ***************************************************************************
+ * @file scene.h
+ * @brief Scene store in the EEPROM
+ *
+ * A scene is a snapshot of the visible state: the frame on the strip (run
+ * length encoded colors in wire order), the power LED (enabled, brightness
+ * level) and the running effect. SCENES slots are kept in the EEPROM, every
+ * slot is protected by a magic byte and a CRC-8, so an interrupted save
+ * leaves an invalid slot instead of a wrong scene.
+ *
+ * A save runs in the background: Scene_Save() only starts it, every
+ * Scene_Step() writes at most one byte (3.4ms per written byte), so the
+ * caller keeps returning quickly. The runs of the frame are fetched from the
+ * caller while they are written, the frame must not change until
+ * Scene_Step() returns 0.
+ *
+ * The slot of the last saved or recalled scene is restored at boot. It is
+ * written much more often than the slots, so it is wear-levelled over a ring
+ * of SCENE_RING_SIZE bytes: every write goes to the next byte, a sequence
+ * number marks the newest one.
+ *
+ * Deliberately left out:
+ * - names: slots are addressed by number only, the SPI protocol has no way
+ *   to read text back (registers are single bytes)
+ * - wear-levelling of the slots: only the ring of the last scene rotates.
+ *   A slot is only written by an explicit save and only its changed bytes,
+ *   the slots and the ring use 944 of the 1024 EEPROM bytes, which leaves no
+ *   room for spare slots to rotate over
+ * - device configuration: a scene does not contain the strip layout (0x94,
+ *   stored on its own), the curves (0x92) or the temperature limit (0x89)
+ *
+ * @author agent
+ * @date 16.10.2026
+ *****************************************************************************/
+
+
+#ifndef SCENE_H_
+#define SCENE_H_
+
+#include "effects.h"
+
+#define SCENES				4		///< amount of scene slots
+#define SCENE_NONE			0x07	///< no scene (nothing restored at boot)
+#define SCENE_SIZE			232		///< EEPROM bytes per scene slot
+#define SCENE_HEADER_SIZE	(5+EFFECT_PAYLOAD_SIZE)	///< EEPROM bytes of the header (magic, CRC, flags, level, effect, runs)
+#define SCENE_RUNS_MAX		((SCENE_SIZE-SCENE_HEADER_SIZE)/4)	///< runs of a frame (amount of LEDs, green, red, blue)
+#define SCENE_RING_SIZE		16		///< EEPROM bytes of the ring of the last scene
+
+#define SCENE_PLED			0x01	///< flag: power LED enabled
+#define SCENE_EFFECT		0x02	///< flag: effect running
+
+
+/** Source of the runs of a scene being saved: color of run ucRun (wire order) into aucColor, returns its amount of LEDs. Called in ascending order, run 0 starts again at the first LED */
+typedef unsigned char (*SCENE_NEXT_RUN)(unsigned char ucRun, unsigned char* aucColor);
+
+/** Scene without its frame */
+typedef struct
+{
+	unsigned char ucFlags;							///< SCENE_PLED, SCENE_EFFECT (or'ed)
+	unsigned int uiDuty;							///< brightness level of the power LED [0-DUTY_LEVEL_MAX]
+	unsigned char aucEffect[EFFECT_PAYLOAD_SIZE];	///< effect (see Effect_Parse())
+	unsigned char ucRuns;							///< amount of runs of the frame [0-SCENE_RUNS_MAX]
+} SCENE;
+
+void Scene_Save(unsigned char ucSlot, const SCENE* psScene, SCENE_NEXT_RUN pfNextRun);
+unsigned char Scene_Step(void);
+unsigned char Scene_IsSaving(void);
+unsigned char Scene_Read(unsigned char ucSlot, SCENE* psScene);
+unsigned char Scene_ReadRun(unsigned char ucSlot, unsigned char ucRun, unsigned char* aucColor);
+void Scene_SetLast(unsigned char ucSlot);
+unsigned char Scene_GetLast(void);
+
+#endif /* SCENE_H_ */
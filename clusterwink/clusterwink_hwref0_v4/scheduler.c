@@ -0,0 +1,129 @@
+/** ***************************************************************************
+ * @file scheduler.c
+ * @brief Cooperative task scheduler on the 1ms system tick
+ *
+ * Every task is a function without parameters which is called periodically
+ * from the main loop. Tasks are not preempted, they have to return quickly
+ * (no waiting) so that the other tasks keep their periods. Interrupts are
+ * handled independently of the scheduler.
+ *
+ * The due time of a task advances by its period, so a late call does not
+ * shift the following ones. If a task is late by more than a period, the
+ * missed calls are dropped instead of being executed back to back.
+ *
+ * Between the due times the main loop sleeps (Scheduler_Sleep()). Every
+ * interrupt wakes it up: the tick, a SPI byte or a RGBooster handshake.
+ *
+ * @author agent
+ * @date 16.10.2026
+ *****************************************************************************/
+
+
+#include <avr/interrupt.h>
+#include "utils.h"
+#include "scheduler.h"
+
+
+static TASK asTask[SCHEDULER_MAX_TASKS];	///< task table
+static unsigned char ucTaskCount = 0;		///< amount of used entries of the task table
+
+
+/** ***************************************************************************
+ * @brief Remove all tasks
+ * 
+ * @param [void] no input
+ * @return no return value
+ *****************************************************************************/
+void Scheduler_Init(void)
+{
+	ucTaskCount = 0;
+}
+
+
+/** ***************************************************************************
+ * @brief Add a periodic task
+ *
+ * Tasks are called in the order they were added if they are due at the same
+ * tick. The first call is due immediately. The system tick has to be running
+ * (Tick_Init()).
+ * 
+ * @param [in] pfTask: task function
+ * @param [in] uiPeriod: period [ms], 0 or 1: call on every tick
+ * @return 1: task added  0: task table full
+ *****************************************************************************/
+unsigned char Scheduler_AddTask(TASKFUNCTION pfTask, unsigned int uiPeriod)
+{
+	if(ucTaskCount>=SCHEDULER_MAX_TASKS)
+	{
+		return 0;
+	}
+	asTask[ucTaskCount].pfTask = pfTask;
+	asTask[ucTaskCount].uiPeriod = (uiPeriod) ? uiPeriod : 1;
+	asTask[ucTaskCount].uiNext = Tick_Get();
+	ucTaskCount++;
+	return 1;
+}
+
+
+/** ***************************************************************************
+ * @brief Call all due tasks once
+ *
+ * Called from the main loop. Returns without waiting if no task is due.
+ * 
+ * @param [void] no input
+ * @return amount of called tasks
+ *****************************************************************************/
+unsigned char Scheduler_Run(void)
+{
+	unsigned char i;
+	unsigned char ucCalled = 0;
+	unsigned int uiNow = Tick_Get();
+	TASK* sTask_ptr;
+
+	for(i=0;i<ucTaskCount;i++)
+	{
+		sTask_ptr = &asTask[i];
+		if((unsigned int)(uiNow - sTask_ptr->uiNext) < 0x8000) // due (tick difference is not negative)
+		{
+			sTask_ptr->uiNext += sTask_ptr->uiPeriod;
+			if((unsigned int)(uiNow - sTask_ptr->uiNext) < 0x8000) // late by a period or more
+			{
+				sTask_ptr->uiNext = uiNow + sTask_ptr->uiPeriod;
+			}
+			sTask_ptr->pfTask();
+			ucCalled++;
+		}
+	}
+	return ucCalled;
+}
+
+
+/** ***************************************************************************
+ * @brief Sleep until the next interrupt if no task is due
+ *
+ * Called from the main loop after Scheduler_Run(). The due check and the
+ * sleep are atomic (see Sleep_Idle()), a tick between them is not missed.
+ * Tasks only become due with a tick, so the CPU sleeps through the rest of
+ * the millisecond. Work of the ISRs is not delayed, commands received over
+ * SPI are executed with the next tick as before.
+ * 
+ * @param [void] no input
+ * @return no return value
+ *****************************************************************************/
+void Scheduler_Sleep(void)
+{
+	unsigned char i;
+	unsigned int uiNow;
+
+	cli();
+	uiNow = Tick_Get();
+	for(i=0;i<ucTaskCount;i++)
+	{
+		if((unsigned int)(uiNow - asTask[i].uiNext) < 0x8000) // due
+		{
+			sei();
+			return;
+		}
+	}
+	Sleep_Idle();
+}
@@ -0,0 +1,37 @@
+/** ***************************************************************************
+ * @file scheduler.h
+ * @brief Cooperative task scheduler on the 1ms system tick
+ *
+ * Every task is a function without parameters which is called periodically
+ * from the main loop. Tasks are not preempted, they have to return quickly
+ * (no waiting) so that the other tasks keep their periods. Interrupts are
+ * handled independently of the scheduler.
+ *
+ * @author agent
+ * @date 16.10.2026
+ *****************************************************************************/
+
+
+#ifndef SCHEDULER_H_
+#define SCHEDULER_H_
+
+#define SCHEDULER_MAX_TASKS		4		///< size of the task table
+
+
+/** Task function */
+typedef void (*TASKFUNCTION)(void);
+
+/** Entry of the task table */
+typedef struct
+{
+	TASKFUNCTION pfTask;		///< function called by the scheduler
+	unsigned int uiPeriod;		///< period [ms]
+	unsigned int uiNext;		///< tick of the next call
+} TASK;
+
+void Scheduler_Init(void);
+unsigned char Scheduler_AddTask(TASKFUNCTION pfTask, unsigned int uiPeriod);
+unsigned char Scheduler_Run(void);
+void Scheduler_Sleep(void);
+
+#endif /* SCHEDULER_H_ */
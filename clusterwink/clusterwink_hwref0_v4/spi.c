@@ -34,6 +34,7 @@ void SPISlave_Init(void)
 	SPSR = 0x00;					// normal speed
 	ucTemp = SPDR;					//clear read buffer (not sure if necessary)
 	ucTemp = SPDR;
+	(void)ucTemp;					// only read to clear the buffer
 	SPDR = 0;						//clear write buffer (not sure if necessary)
 	
 	DDRB |= (1<<PINB4);				// MISO needs to be an output
@@ -0,0 +1,235 @@
+/** ***************************************************************************
+ * @file sunrise.c
+ * @brief On-device sunrise: fade of the power LED and the RGB strip
+ *
+ * A sunrise program (start and end dutycycle, start and end color, duration
+ * and easing curve) is uploaded once. Sunrise_Step() is called periodically
+ * by the effects task and advances a fixed-point phase by a constant step.
+ * The eased phase interpolates the brightness level of the power LED and the
+ * color. The RPi does not have to send any command during the fade.
+ *
+ * The phase is a 32bit fraction of the duration [0-0xFFFFFFFF]. The step is
+ * calculated once per program, so every call only needs an addition, the
+ * easing (up to two 16x16bit multiplications) and the interpolation. All
+ * functions are called from the main loop only.
+ *
+ * @author agent
+ * @date 16.10.2026
+ *****************************************************************************/
+
+
+#include "utils.h"
+#include "sunrise.h"
+
+
+#define SUNRISE_PHASE_MAX	0xFFFFFFFFUL	///< phase at the end of the duration
+
+
+static SUNRISE sProgram;					///< running program
+static unsigned long ulPhase = 0;			///< elapsed fraction of the duration [0-SUNRISE_PHASE_MAX]
+static unsigned long ulStep = 0;			///< phase increment per Sunrise_Step()
+static unsigned char ucRunning = 0;			///< program running
+static unsigned char ucLastStep = 0;		///< next Sunrise_Step() outputs the end values
+static SUNRISE_OUTPUT sLast;				///< last output (change detection)
+static unsigned char ucForce = 0;			///< next output is reported as changed
+
+
+/** ***************************************************************************
+ * @brief Apply the easing curve
+ *
+ * Fixed point with 16 fractional bits: 0 = start, 0xFFFF = end.
+ * - quadratic: p^2
+ * - cubic: p^3
+ * - smoothstep: 3p^2 - 2p^3 = p^2 * (3 - 2p), the second factor is used with
+ *   14 fractional bits so that the product fits into 32bit
+ *
+ * @param [in] uiProgress: linear progress [0-0xFFFF]
+ * @param [in] ucCurve: easing curve (SUNRISE_LINEAR, ...)
+ * @return eased progress [0-0xFFFF]
+ *****************************************************************************/
+static unsigned int ease(unsigned int uiProgress, unsigned char ucCurve)
+{
+	unsigned long ulSquare = ((unsigned long)uiProgress * uiProgress) >> 16;
+	unsigned long ulSmooth;
+
+	switch(ucCurve)
+	{
+		case SUNRISE_EASE_IN:
+		return (unsigned int)ulSquare;
+
+		case SUNRISE_EASE_IN_CUBIC:
+		return (unsigned int)((ulSquare * uiProgress) >> 16);
+
+		case SUNRISE_SMOOTH:
+		ulSmooth = (ulSquare * (0xC000UL - (uiProgress >> 1))) >> 14;
+		return (ulSmooth>0xFFFF) ? 0xFFFF : (unsigned int)ulSmooth; // rounding errors near the end
+
+		default:
+		return uiProgress;
+	}
+}
+
+
+/** ***************************************************************************
+ * @brief Interpolate between two values
+ *
+ * @param [in] uiStart: value at the start
+ * @param [in] uiEnd: value at the end
+ * @param [in] uiEased: eased progress [0-0xFFFF]
+ * @return interpolated value (rounded)
+ *****************************************************************************/
+static unsigned int interpolate(unsigned int uiStart, unsigned int uiEnd, unsigned int uiEased)
+{
+	if(uiEnd>=uiStart)
+	{
+		return uiStart + (unsigned int)((((unsigned long)(uiEnd - uiStart) * uiEased) + 0x8000) >> 16);
+	}
+	return uiStart - (unsigned int)((((unsigned long)(uiStart - uiEnd) * uiEased) + 0x8000) >> 16);
+}
+
+
+/** ***************************************************************************
+ * @brief Decode the payload of the sunrise command
+ *
+ * Payload: [DS, DE, RS, GS, BS, RE, GE, BE, TH, TL, CC]
+ * - DS, DE: start and end dutycycle in percent [0-100]
+ * - RS, GS, BS: start color, RE, GE, BE: end color
+ * - TH, TL: duration in seconds (high and low byte)
+ * - CC: easing curve (SUNRISE_LINEAR, ...)
+ *
+ * @param [out] psProgram: decoded program
+ * @param [in] aucPayload: payload of the command
+ * @param [in] ucLength: amount of payload bytes
+ * @return 1: valid program  0: wrong length or unknown curve
+ *****************************************************************************/
+unsigned char Sunrise_Parse(SUNRISE* psProgram, const unsigned char* aucPayload, unsigned char ucLength)
+{
+	unsigned char i;
+
+	if((ucLength!=SUNRISE_PAYLOAD_SIZE) || (aucPayload[10]>=SUNRISE_CURVES))
+	{
+		return 0;
+	}
+	psProgram->uiDutyStart = percentToLevel(aucPayload[0]);
+	psProgram->uiDutyEnd = percentToLevel(aucPayload[1]);
+	for(i=0;i<3;i++)
+	{
+		psProgram->aucColorStart[i] = aucPayload[2+i];
+		psProgram->aucColorEnd[i] = aucPayload[5+i];
+	}
+	psProgram->uiDuration = ((unsigned int)aucPayload[8] << 8) | aucPayload[9];
+	psProgram->ucCurve = aucPayload[10];
+	return 1;
+}
+
+
+/** ***************************************************************************
+ * @brief Start a sunrise program
+ *
+ * A running program is replaced. The next Sunrise_Step() outputs the start
+ * values, the end values are reached after the duration.
+ *
+ * @param [in] psProgram: program (copied)
+ * @param [in] uiPeriod: period of the Sunrise_Step() calls [ms]
+ * @return no return value
+ *****************************************************************************/
+void Sunrise_Start(const SUNRISE* psProgram, unsigned int uiPeriod)
+{
+	unsigned long ulSteps;
+
+	sProgram = *psProgram;
+	ulSteps = ((unsigned long)sProgram.uiDuration * 1000) / ((uiPeriod) ? uiPeriod : 1);
+	ulPhase = 0;
+	ulStep = (ulSteps) ? (SUNRISE_PHASE_MAX / ulSteps) : SUNRISE_PHASE_MAX;
+	ucLastStep = (ulSteps==0);
+	ucForce = 1;
+	ucRunning = 1;
+}
+
+
+/** ***************************************************************************
+ * @brief Stop the running program
+ *
+ * The outputs keep their last values.
+ *
+ * @param [void] no input
+ * @return no return value
+ *****************************************************************************/
+void Sunrise_Stop(void)
+{
+	ucRunning = 0;
+}
+
+
+/** ***************************************************************************
+ * @brief Check if a program is running
+ *
+ * @param [void] no input
+ * @return 1: running  0: stopped or finished
+ *****************************************************************************/
+unsigned char Sunrise_IsRunning(void)
+{
+	return ucRunning;
+}
+
+
+/** ***************************************************************************
+ * @brief Advance the running program by one step
+ *
+ * Only the changed parts of the output have to be applied by the caller (the
+ * color changes much less often than every step in a long sunrise).
+ *
+ * @param [out] psOutput: dutycycle and color of this step
+ * @return SUNRISE_DUTY_CHANGED, SUNRISE_COLOR_CHANGED, SUNRISE_FINISHED (or'ed), 0 if not running
+ *****************************************************************************/
+unsigned char Sunrise_Step(SUNRISE_OUTPUT* psOutput)
+{
+	unsigned char i;
+	unsigned char ucResult = 0;
+	unsigned int uiEased;
+
+	if(!ucRunning)
+	{
+		return 0;
+	}
+
+	if(ucLastStep)
+	{
+		psOutput->uiDuty = sProgram.uiDutyEnd;
+		for(i=0;i<3;i++)
+		{
+			psOutput->aucColor[i] = sProgram.aucColorEnd[i];
+		}
+		ucRunning = 0;
+		ucResult = SUNRISE_FINISHED;
+	}
+	else
+	{
+		uiEased = ease((unsigned int)(ulPhase >> 16), sProgram.ucCurve);
+		psOutput->uiDuty = interpolate(sProgram.uiDutyStart, sProgram.uiDutyEnd, uiEased);
+		for(i=0;i<3;i++)
+		{
+			psOutput->aucColor[i] = (unsigned char)interpolate(sProgram.aucColorStart[i], sProgram.aucColorEnd[i], uiEased);
+		}
+		if(ulPhase > (SUNRISE_PHASE_MAX - ulStep))
+		{
+			ucLastStep = 1;
+		}
+		else
+		{
+			ulPhase += ulStep;
+		}
+	}
+
+	if((ucForce) || (psOutput->uiDuty!=sLast.uiDuty))
+	{
+		ucResult |= SUNRISE_DUTY_CHANGED;
+	}
+	if((ucForce) || (psOutput->aucColor[0]!=sLast.aucColor[0]) || (psOutput->aucColor[1]!=sLast.aucColor[1]) || (psOutput->aucColor[2]!=sLast.aucColor[2]))
+	{
+		ucResult |= SUNRISE_COLOR_CHANGED;
+	}
+	ucForce = 0;
+	sLast = *psOutput;
+	return ucResult;
+}
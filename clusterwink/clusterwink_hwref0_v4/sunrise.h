@@ -0,0 +1,56 @@
+/** ***************************************************************************
+ * @file sunrise.h
+ * @brief On-device sunrise: fade of the power LED and the RGB strip
+ *
+ * A sunrise program (start and end dutycycle, start and end color, duration
+ * and easing curve) is uploaded once. Sunrise_Step() is called periodically
+ * by the effects task and advances a fixed-point phase by a constant step.
+ * The eased phase interpolates the brightness level of the power LED and the
+ * color. The RPi does not have to send any command during the fade.
+ *
+ * @author agent
+ * @date 16.10.2026
+ *****************************************************************************/
+
+
+#ifndef SUNRISE_H_
+#define SUNRISE_H_
+
+#define SUNRISE_LINEAR			0		///< curve: constant speed
+#define SUNRISE_EASE_IN			1		///< curve: quadratic, slow start
+#define SUNRISE_EASE_IN_CUBIC	2		///< curve: cubic, very slow start
+#define SUNRISE_SMOOTH			3		///< curve: smoothstep, slow start and end
+#define SUNRISE_CURVES			4		///< amount of curves
+
+#define SUNRISE_PAYLOAD_SIZE	11		///< payload of the sunrise command (see Sunrise_Parse())
+
+#define SUNRISE_DUTY_CHANGED	0x01	///< Sunrise_Step() result: new dutycycle
+#define SUNRISE_COLOR_CHANGED	0x02	///< Sunrise_Step() result: new color
+#define SUNRISE_FINISHED		0x04	///< Sunrise_Step() result: end values reached
+
+
+/** Sunrise program */
+typedef struct
+{
+	unsigned int uiDutyStart;			///< brightness level at the start [0-DUTY_LEVEL_MAX]
+	unsigned int uiDutyEnd;				///< brightness level at the end [0-DUTY_LEVEL_MAX]
+	unsigned char aucColorStart[3];		///< color at the start (red, green, blue)
+	unsigned char aucColorEnd[3];		///< color at the end (red, green, blue)
+	unsigned int uiDuration;			///< duration [s], 0: end values immediately
+	unsigned char ucCurve;				///< easing curve (SUNRISE_LINEAR, ...)
+} SUNRISE;
+
+/** Output of the sunrise engine */
+typedef struct
+{
+	unsigned int uiDuty;				///< brightness level [0-DUTY_LEVEL_MAX]
+	unsigned char aucColor[3];			///< color (red, green, blue)
+} SUNRISE_OUTPUT;
+
+unsigned char Sunrise_Parse(SUNRISE* psProgram, const unsigned char* aucPayload, unsigned char ucLength);
+void Sunrise_Start(const SUNRISE* psProgram, unsigned int uiPeriod);
+void Sunrise_Stop(void);
+unsigned char Sunrise_IsRunning(void);
+unsigned char Sunrise_Step(SUNRISE_OUTPUT* psOutput);
+
+#endif /* SUNRISE_H_ */
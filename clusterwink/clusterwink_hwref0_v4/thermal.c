@@ -0,0 +1,91 @@
+/** ***************************************************************************
+ * @file thermal.c
+ * @brief Power LED temperature: sensor conversion and thermal derating
+ *
+ * - Conversion
+ * @n The oversampled 12bit ADC value of the temperature sensor (10mV/K,
+ * 500mV at 0C, AVCC = 5V reference) is converted to 0.1C steps with integer
+ * arithmetic only.
+ *
+ * - Derating
+ * @n Below THERMAL_BAND under the configured limit the power LED runs with
+ * the requested dutycycle. Inside of the band the dutycycle is scaled down
+ * linearly, at the limit it is reduced to THERMAL_MIN_SCALE.
+ *
+ * @author agent
+ * @date 16.10.2026
+ *****************************************************************************/
+
+
+#include "thermal.h"
+
+
+static volatile unsigned char ucLimit = THERMAL_DEFAULT_LIMIT;	///< temperature limit [C] (set by the SPI ISR)
+static unsigned char ucState = THERMAL_NORMAL;					///< state of the last update
+
+
+/** ***************************************************************************
+ * @brief Convert a measurement of the temperature sensor
+ *
+ * T = U/10mV - 50 = raw * 5000mV/4096 / 10mV - 50
+ * @n -> T[0.1C] = raw * 5000/4096 - 500 = ((raw * 625) >> 9) - 500
+ * 
+ * @param [in] uiRaw: oversampled ADC value [12bit]
+ * @return temperature [0.1C]
+ *****************************************************************************/
+int Thermal_Convert(unsigned int uiRaw)
+{
+	return (int)((((unsigned long)uiRaw * 625) + 256) >> 9) - 500; // rounded
+}
+
+
+/** ***************************************************************************
+ * @brief Set the temperature limit of the power LED
+ *
+ * Derating starts THERMAL_BAND below the limit.
+ * 
+ * @param [in] ucNewLimit: temperature limit [C]
+ * @return no return value
+ *****************************************************************************/
+void Thermal_SetLimit(unsigned char ucNewLimit)
+{
+	ucLimit = ucNewLimit;
+}
+
+
+/** ***************************************************************************
+ * @brief Calculate the dutycycle scale for a new temperature
+ * 
+ * @param [in] iTemperature: power LED temperature [0.1C]
+ * @return dutycycle scale [THERMAL_MIN_SCALE-THERMAL_FULL_SCALE]
+ *****************************************************************************/
+unsigned int Thermal_Update(int iTemperature)
+{
+	int iLimit = (int)ucLimit * 10;
+	int iStart = iLimit - THERMAL_BAND;
+
+	if(iTemperature<=iStart)
+	{
+		ucState = THERMAL_NORMAL;
+		return THERMAL_FULL_SCALE;
+	}
+	if(iTemperature>=iLimit)
+	{
+		ucState = THERMAL_OVERTEMP;
+		return THERMAL_MIN_SCALE;
+	}
+	ucState = THERMAL_DERATING;
+	return THERMAL_FULL_SCALE - (unsigned int)(((unsigned int)(iTemperature - iStart) * (THERMAL_FULL_SCALE - THERMAL_MIN_SCALE)) / THERMAL_BAND);
+}
+
+
+/** ***************************************************************************
+ * @brief State of the last Thermal_Update()
+ * 
+ * @param [void] no input
+ * @return THERMAL_NORMAL, THERMAL_DERATING or THERMAL_OVERTEMP
+ *****************************************************************************/
+unsigned char Thermal_GetState(void)
+{
+	return ucState;
+}
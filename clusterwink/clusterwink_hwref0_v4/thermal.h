@@ -0,0 +1,39 @@
+/** ***************************************************************************
+ * @file thermal.h
+ * @brief Power LED temperature: sensor conversion and thermal derating
+ *
+ * - Conversion
+ * @n The oversampled 12bit ADC value of the temperature sensor (10mV/K,
+ * 500mV at 0C, AVCC = 5V reference) is converted to 0.1C steps with integer
+ * arithmetic only.
+ *
+ * - Derating
+ * @n Below THERMAL_BAND under the configured limit the power LED runs with
+ * the requested dutycycle. Inside of the band the dutycycle is scaled down
+ * linearly, at the limit it is reduced to THERMAL_MIN_SCALE.
+ *
+ * @author agent
+ * @date 16.10.2026
+ *****************************************************************************/
+
+
+#ifndef THERMAL_H_
+#define THERMAL_H_
+
+#include "utils.h"
+
+#define THERMAL_DEFAULT_LIMIT	75		///< default temperature limit [C]
+#define THERMAL_BAND			150		///< derating starts this far below the limit [0.1C]
+#define THERMAL_FULL_SCALE		DUTY_FULL_SCALE	///< dutycycle scale without derating
+#define THERMAL_MIN_SCALE		64		///< dutycycle scale at and above the limit (25%)
+
+#define THERMAL_NORMAL			0		///< state: full dutycycle
+#define THERMAL_DERATING		1		///< state: dutycycle reduced
+#define THERMAL_OVERTEMP		2		///< state: limit reached, minimal dutycycle
+
+int Thermal_Convert(unsigned int uiRaw);
+void Thermal_SetLimit(unsigned char ucLimit);
+unsigned int Thermal_Update(int iTemperature);
+unsigned char Thermal_GetState(void);
+
+#endif /* THERMAL_H_ */
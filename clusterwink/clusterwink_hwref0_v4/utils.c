@@ -6,13 +6,20 @@
  * @n Set pin directions and enable/disable the power LED driver circuit.
  * 
  * - PWM
- * @n Setup and control the PWM pin used for dimming the power LED
+ * @n Setup and control the PWM pin used for dimming the power LED. The
+ * brightness level is corrected by gamma.c. The 16bit dutycycle is output
+ * with a 10bit PWM and 6bit temporal dithering.
  * 
  * - ADC
  * @n Measure the voltage of the temperature sensor to determine the power LED temperature.
+ * The ADC runs freely in the background, the measurements get oversampled to 12bit.
+ * 
+ * - Tick
+ * @n 1ms system tick with timer0 (interrupt driven).
  * 
  * - Utilities
- * @n Map function for converting variables to a different number range and a 1ms wait routine.
+ * @n Map function for converting variables to a different number range, a 1ms wait routine
+ * and the idle sleep of the main loop.
  *
  * @author lopeslen, nosedmar
  * @date 14.11.2017
@@ -20,6 +27,10 @@
 
 
  #include <avr/io.h>
+ #include <avr/interrupt.h>
+ #include <avr/sleep.h>
+ #include <util/atomic.h>
+ #include "gamma.h"
  #include "utils.h"
 
 
@@ -71,25 +82,96 @@ void disablePLED(void)
 ///////////////////////////////////////////////////////////////////////////////
 
 
+static volatile unsigned int uiDutyLevel = 0;				///< brightness level before correction and scaling [0-DUTY_LEVEL_MAX]
+static volatile unsigned int uiDutyScale = DUTY_FULL_SCALE;	///< dutycycle scale [0-DUTY_FULL_SCALE]
+static volatile unsigned int uiPWMBase = 0;					///< integer part of the dutycycle [0-PWM_TOP] (ISR)
+static volatile unsigned char ucPWMFraction = 0;			///< fractional part of the dutycycle [0-PWM_DITHER_MASK] (ISR)
+
+
+/** ***************************************************************************
+ * @brief Write the corrected and scaled dutycycle to OCR1A
+ *
+ * The 16bit dutycycle (intensity * scale) is split into the OCR1A value and
+ * a fraction which is dithered by ISR(TIMER1_OVF_vect). The overflow
+ * interrupt only runs if the fraction is not zero.
+ * Must not be interrupted by another PWM function (16bit register access).
+ * 
+ * @param [void] no input
+ * @return no return value
+ *****************************************************************************/
+static inline void applyDuty(void)
+{
+	unsigned int uiDuty = (unsigned int)(((unsigned long)Gamma_PLED(uiDutyLevel) * uiDutyScale) >> 8);
+
+	uiPWMBase = uiDuty >> PWM_DITHER_BITS;
+	ucPWMFraction = (unsigned char)(uiDuty & PWM_DITHER_MASK);
+	if(uiPWMBase>=PWM_TOP) // 100%: OCR1A must not exceed TOP
+	{
+		uiPWMBase = PWM_TOP;
+		ucPWMFraction = 0;
+	}
+	OCR1A = uiPWMBase;
+	if(ucPWMFraction)
+	{
+		TIMSK1 |= (1<<TOIE1);
+	}
+	else
+	{
+		TIMSK1 &= ~(1<<TOIE1);
+	}
+}
+
+
 /** ***************************************************************************
  * @brief Initialize the PWM pin and setup timer1.
  *
  * - non-interted output of pwm signal
- * - mode: 9bit fast pwm
- * - frequency @20MHz and prescaler 1: 39kHz
- * - no interrupts
+ * - mode: fast pwm with TOP = ICR1 = PWM_TOP (10bit)
+ * - frequency @20MHz and prescaler 1: 19.5kHz
+ * - overflow interrupt for the dithering (only if needed)
  * 
  * @param [in] ucPercent: dutycycle in percent [0-100]
  * @return no return value
  *****************************************************************************/
 void initPWM(unsigned char ucPercent)
 {
-	TCCR1A = (1<<COM1A1) | (1<<WGM11);	// non inverting output on pwm pin | mode: fast pwm 9bit
-	TCCR1B = (1<<WGM12);				// mode: fast pwm 9bit
+	TCCR1A = (1<<COM1A1) | (1<<WGM11);	// non inverting output on pwm pin | mode: fast pwm, TOP = ICR1
+	TCCR1B = (1<<WGM13) | (1<<WGM12);	// mode: fast pwm, TOP = ICR1
 	TCCR1C = 0;
 	TCNT1 = 0;
-	OCR1A = Map(ucPercent,0,100,0,511); // dutycycle
-	TIMSK1 = 0;							// no interrupts
+	ICR1 = PWM_TOP;
+	TIMSK1 = 0;							// no interrupts (applyDuty() enables the overflow interrupt)
+	uiDutyLevel = percentToLevel(ucPercent);
+	applyDuty(); // dutycycle
+}
+
+
+/** ***************************************************************************
+ * @brief Timer1 overflow: temporal dithering of the dutycycle
+ *
+ * First order sigma-delta modulation: the fraction is accumulated every PWM
+ * period, a carry extends the next period by one count. The average over
+ * 2^PWM_DITHER_BITS periods is the 16bit dutycycle. The pattern repeats at
+ * 19.5kHz/64 = 305Hz or faster, which is not visible. OCR1A is double
+ * buffered and gets updated at the end of the period.
+ * 
+ * @param [in] TIMER1_OVF_vect: "Timer/Counter1 Overflow" vector
+ * @return no return value
+ *****************************************************************************/
+ISR(TIMER1_OVF_vect)
+{
+	static unsigned char ucAccumulator = 0;
+
+	ucAccumulator += ucPWMFraction;
+	if(ucAccumulator & (1<<PWM_DITHER_BITS))
+	{
+		ucAccumulator &= PWM_DITHER_MASK;
+		OCR1A = uiPWMBase + 1;
+	}
+	else
+	{
+		OCR1A = uiPWMBase;
+	}
 }
 
 
@@ -97,7 +179,7 @@ void initPWM(unsigned char ucPercent)
  * @brief Start the PWM output
  *
  * Timer1 is started by setting the prescaler to a non-zero value.
- * A prescaler of 1 yields the desired 39kHz.
+ * A prescaler of 1 yields the desired 19.5kHz.
  * 
  * @param [void] no input
  * @return no return value
@@ -125,14 +207,124 @@ void stopPWM(void)
 /** ***************************************************************************
  * @brief Set the dutycycle of the PWM output
  *
- * The map function converts the percentage to the corresponding 9bit value
+ * The percentage is a brightness level, it gets corrected (Gamma_PLED()) and
+ * scaled with the factor of setDutyScale() before it is written to OCR1A.
+ * No division is needed. Called by the SPI ISR.
  * 
  * @param [in] ucPercent: dutycycle in percent [0-100]
  * @return no return value
  *****************************************************************************/
 void setDuty(unsigned char ucPercent)
 {
-	OCR1A = Map(ucPercent,0,100,0,511);
+	uiDutyLevel = percentToLevel(ucPercent);
+	applyDuty();
+}
+
+
+/** ***************************************************************************
+ * @brief Set the dutycycle of the PWM output with a fine brightness level
+ *
+ * Used by the sunrise engine for fine steps (setDuty() has 1% steps). The
+ * level is corrected and scaled like the one of setDuty(). Can be called
+ * from the main loop while setDuty() is called by an ISR.
+ * 
+ * @param [in] uiLevel: brightness level [0-DUTY_LEVEL_MAX]
+ * @return no return value
+ *****************************************************************************/
+void setDutyLevel(unsigned int uiLevel)
+{
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+	{
+		uiDutyLevel = uiLevel;
+		applyDuty();
+	}
+}
+
+
+/** ***************************************************************************
+ * @brief Get the brightness level of the power LED
+ *
+ * @param [void] no input
+ * @return brightness level before correction and scaling [0-DUTY_LEVEL_MAX]
+ *****************************************************************************/
+unsigned int getDutyLevel(void)
+{
+	unsigned int uiLevel;
+
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+	{
+		uiLevel = uiDutyLevel;
+	}
+	return uiLevel;
+}
+
+
+/** ***************************************************************************
+ * @brief Write the dutycycle to OCR1A again (e.g. after Gamma_Select())
+ * 
+ * @param [void] no input
+ * @return no return value
+ *****************************************************************************/
+void refreshDuty(void)
+{
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+	{
+		applyDuty();
+	}
+}
+
+
+/** ***************************************************************************
+ * @brief Convert a dutycycle in percent to a brightness level
+ *
+ * level = percent * 655.36 (100% -> DUTY_LEVEL_MAX), multiplication only.
+ * 
+ * @param [in] ucPercent: dutycycle in percent [0-100], higher values are limited
+ * @return brightness level [0-DUTY_LEVEL_MAX]
+ *****************************************************************************/
+unsigned int percentToLevel(unsigned char ucPercent)
+{
+	if(ucPercent>=100)
+	{
+		return DUTY_LEVEL_MAX;
+	}
+	return (unsigned int)(((unsigned long)ucPercent * 41943) >> 6);
+}
+
+
+/** ***************************************************************************
+ * @brief Convert a brightness level to a dutycycle in percent
+ *
+ * percent = level * 100 / 65536 (rounded), multiplication only.
+ * 
+ * @param [in] uiLevel: brightness level [0-DUTY_LEVEL_MAX]
+ * @return dutycycle in percent [0-100]
+ *****************************************************************************/
+unsigned char levelToPercent(unsigned int uiLevel)
+{
+	return (unsigned char)((((unsigned long)uiLevel * 100) + 0x8000) >> 16);
+}
+
+
+/** ***************************************************************************
+ * @brief Scale the dutycycle of the PWM output (e.g. thermal derating)
+ *
+ * The dutycycle set by setDuty() is multiplied by uiScale/DUTY_FULL_SCALE.
+ * Can be called from the main loop while setDuty() is called by an ISR.
+ * 
+ * @param [in] uiScale: scale [0-DUTY_FULL_SCALE]
+ * @return no return value
+ *****************************************************************************/
+void setDutyScale(unsigned int uiScale)
+{
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+	{
+		if(uiScale!=uiDutyScale)
+		{
+			uiDutyScale = uiScale;
+			applyDuty();
+		}
+	}
 }
 
 
@@ -141,91 +333,176 @@ void setDuty(unsigned char ucPercent)
 ///////////////////////////////////////////////////////////////////////////////
 
 
+static volatile unsigned int uiADCFiltered = 0;		///< last oversampled measurement [12bit] (ISR)
+static volatile unsigned char ucADCUpdated = 0;		///< new measurement since the last ADC_GetFiltered() (ISR)
+
+
 /** ***************************************************************************
  * @brief Initialize the ADC for the temperature measurment (ADC6)
  *
  * - reference: AVCC pin
- * - left adjusted (8bit)
+ * - right adjusted (10bit)
  * - channel: ADC6 pin
- * - ADC clock prescaler: 128
+ * - ADC clock prescaler: 128 (156kHz, 12kSamples/s)
+ * - free running mode, conversion complete interrupt
+ *
+ * The conversions run continuously from now on and get oversampled by
+ * ISR(ADC_vect). Global interrupts have to be enabled.
  * 
  * @param [void] no input
  * @return no return value
  *****************************************************************************/
-void AD8bit_Init(void)
+void ADC_Init(void)
 {
-	ADMUX = (1<<REFS0) | (1<<ADLAR) | (1<<MUX2) | (1<<MUX1); // AVCC as reference | left adjusted result (8bit) | ADC6 pin
-	ADCSRA = (1<<ADEN) | (1<<ADPS2) | (1<<ADPS1) | (1<<ADPS0); // ADC enable | ADC clock prescaler 128
-	ADCSRB = 0x00;
+	ADMUX = (1<<REFS0) | (1<<MUX2) | (1<<MUX1); // AVCC as reference | right adjusted result (10bit) | ADC6 pin
+	ADCSRB = 0x00; // auto trigger source: free running
+	ADCSRA = (1<<ADEN) | (1<<ADATE) | (1<<ADIE) | (1<<ADPS2) | (1<<ADPS1) | (1<<ADPS0); // ADC enable | auto trigger | interrupt | ADC clock prescaler 128
+	ADCSRA |= (1<<ADSC); // start the first conversion
 }
 
 
 /** ***************************************************************************
- * @brief Initialize the ADC for the temperature measurment (ADC6)
+ * @brief ADC conversion complete
  *
- * - reference: AVCC pin
- * - left adjusted (8bit)
- * - channel: ADC6 pin
- * - ADC clock prescaler: 128
+ * Oversampling and decimation: ADC_OVERSAMPLING (4^2) conversions are summed
+ * up and the sum is shifted right by 2, which results in a 12bit value with
+ * averaged noise. The result is published for ADC_GetFiltered().
  * 
- * @param [void] no input
- * @return 8bit analog value
+ * @param [in] ADC_vect: "ADC Conversion Complete" vector
+ * @return no return value
  *****************************************************************************/
-unsigned char AD8bit_Measurement(void)
+ISR(ADC_vect)
 {
-	ADCSRA |= (1<<ADSC); // start conversion
+	static unsigned int uiSum = 0;
+	static unsigned char ucSamples = 0;
+
+	uiSum += ADC;
+	ucSamples++;
+	if(ucSamples>=ADC_OVERSAMPLING)
+	{
+		uiADCFiltered = uiSum >> 2;
+		ucADCUpdated = 1;
+		uiSum = 0;
+		ucSamples = 0;
+	}
+}
 
-	while(!(ADCSRA & (1<<ADIF))); // poll busy flag
-	ADCSRA = ADCSRA | (1<<ADIF); // clear busy flag
 
-	return (ADCH);
+/** ***************************************************************************
+ * @brief Get the last oversampled measurement of the temperature sensor
+ *
+ * Does not wait for a conversion. Returns 0 until the first ADC_OVERSAMPLING
+ * conversions are done.
+ * 
+ * @param [out] ucUpdated_ptr: set to 1 if the value is new since the last call (may be 0)
+ * @return analog value [12bit: 0-4095 = 0-AVCC]
+ *****************************************************************************/
+unsigned int ADC_GetFiltered(unsigned char* ucUpdated_ptr)
+{
+	unsigned int uiValue;
+
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+	{
+		uiValue = uiADCFiltered;
+		if(ucUpdated_ptr)
+		{
+			*ucUpdated_ptr = ucADCUpdated;
+		}
+		ucADCUpdated = 0;
+	}
+	return uiValue;
 }
 
 ///////////////////////////////////////////////////////////////////////////////
-// UTILITIES
+// TICK
 ///////////////////////////////////////////////////////////////////////////////
 
 
+static volatile unsigned int uiTickCount = 0;	///< milliseconds since Tick_Init(), wraps around (ISR)
+
+
 /** ***************************************************************************
- * @brief wait 1ms*factor
- * 
- * Use timer0 to wait a multiple of 1ms. Timermode: CTC
+ * @brief Start the 1ms system tick with timer0
  *
- * @param [in] uiFactor: 1ms multiplier
+ * - mode: CTC, TOP = OCR0A = 249
+ * - prescaler: 64 -> 20MHz/64/250 = 1kHz
+ * - compare match A interrupt
+ * 
+ * @param [void] no input
  * @return no return value
  *****************************************************************************/
-void wait_1ms(unsigned int uiFactor)
+void Tick_Init(void)
 {
-	unsigned int i;
 	TCCR0A = (1<<WGM01);
 	TCCR0B = 0x00;
-	TIFR0 =  (1<<OCF0B) | (1<<OCF0A) | (1<<TOV0); // clear all flags
-	TIMSK0 = 0x00; // no interrupts
 	TCNT0 = 0;
 	OCR0A = 249; // used formula on page 99 in datasheet to calculate this value and prescaler for 1ms
-	
+	TIFR0 = (1<<OCF0B) | (1<<OCF0A) | (1<<TOV0); // clear all flags
+	TIMSK0 = (1<<OCIE0A); // compare match A interrupt
 	TCCR0B |= 0x03; // set prescaler to 64
-	
-	for(i=0;i<uiFactor;i++)
+}
+
+
+/** ***************************************************************************
+ * @brief Timer0 compare match A: 1ms system tick
+ * 
+ * @param [in] TIMER0_COMPA_vect: "Timer/Counter0 Compare Match A" vector
+ * @return no return value
+ *****************************************************************************/
+ISR(TIMER0_COMPA_vect)
+{
+	uiTickCount++;
+}
+
+
+/** ***************************************************************************
+ * @brief Get the system tick
+ *
+ * Differences of two ticks are correct across the wrap around as long as
+ * they are calculated as unsigned int and are shorter than 65.5s.
+ * 
+ * @param [void] no input
+ * @return milliseconds since Tick_Init()
+ *****************************************************************************/
+unsigned int Tick_Get(void)
+{
+	unsigned int uiTick;
+
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
 	{
-		while(!(TIFR0&0x02));	// poll flag
-		TIFR0 = 0x03;			// clear flags
+		uiTick = uiTickCount;
 	}
-	TCCR0B &= ~(0x03);	// set prescaler to 0 (stop timer)
+	return uiTick;
 }
 
 
+///////////////////////////////////////////////////////////////////////////////
+// UTILITIES
+///////////////////////////////////////////////////////////////////////////////
+
+
 /** ***************************************************************************
- * @brief Map function for converting variables to a different number range.
+ * @brief Sleep in idle mode until the next interrupt
  *
- * @param [in] lData: data to be converted
- * @param [in] InMin: minimal value of input range
- * @param [in] InMax: maximal value of input range
- * @param [in] OutMin: minimal value of output range
- * @param [in] OutMax: maximal value of output range
- * @return data in new number range
+ * Has to be called with global interrupts disabled, after the caller has
+ * checked that there is nothing to do. The instruction after sei is always
+ * executed before a pending interrupt, so an interrupt that arrived after
+ * the check wakes the CPU immediately instead of being slept through.
+ * In idle mode the timers, SPI, ADC and the external interrupts keep
+ * running, only the CPU clock is stopped. Returns with global interrupts
+ * enabled after the ISR of the wake-up source.
+ *
+ * The ADC noise reduction mode would stop timer0 (system tick) and timer1
+ * (power LED PWM), so it is not used.
+ * 
+ * @param [void] no input
+ * @return no return value
  *****************************************************************************/
-long Map(long lData, long InMin, long InMax, long OutMin, long OutMax)
+void Sleep_Idle(void)
 {
-	return((lData-InMin)*(OutMax-OutMin)/(InMax-InMin)+OutMin);
+	set_sleep_mode(SLEEP_MODE_IDLE);
+	sleep_enable();
+	sei();
+	sleep_cpu();
+	sleep_disable();
 }
@@ -6,13 +6,20 @@
  * @n Set pin directions and enable/disable the power LED driver circuit.
  * 
  * - PWM
- * @n Setup and control the PWM pin used for dimming the power LED
+ * @n Setup and control the PWM pin used for dimming the power LED. The
+ * brightness level is corrected by gamma.c. The 16bit dutycycle is output
+ * with a 10bit PWM and 6bit temporal dithering.
  * 
  * - ADC
  * @n Measure the voltage of the temperature sensor to determine the power LED temperature.
+ * The ADC runs freely in the background, the measurements get oversampled to 12bit.
+ * 
+ * - Tick
+ * @n 1ms system tick with timer0 (interrupt driven).
  * 
  * - Utilities
- * @n Map function for converting variable to a different number range and a 1ms wait routine.
+ * @n Map function for converting variable to a different number range, a 1ms wait routine
+ * and the idle sleep of the main loop.
  *
  * @author lopeslen, nosedmar
  * @date 14.11.2017
@@ -28,6 +35,15 @@
 #define PLED_DISABLE		0		///< power LED disable pin
 #define PLED_PWM			1		///< power LED PWM pin
 
+#define PWM_TOP				1023	///< ICR1: TOP of the 10bit fast pwm, OCR1A value of 100% dutycycle
+#define PWM_DITHER_BITS		6		///< fractional bits of the dutycycle, dithered over the PWM periods
+#define PWM_DITHER_MASK		((1<<PWM_DITHER_BITS)-1)	///< fractional part of the 16bit dutycycle
+#define DUTY_LEVEL_MAX		0xFFFF	///< brightness level of 100% dutycycle
+#define DUTY_FULL_SCALE		256		///< dutycycle scale without reduction
+
+#define ADC_OVERSAMPLING	16		///< conversions per measurement (4^2: 10bit -> 12bit)
+#define ADC_FULL_SCALE		4096	///< range of an oversampled measurement
+
 
 //GPIO
 void portInit(void);
@@ -38,11 +54,19 @@ void initPWM(unsigned char ucPercent);
 void startPWM(void);
 void stopPWM(void);
 void setDuty(unsigned char ucPercent);
+void setDutyLevel(unsigned int uiLevel);
+unsigned int getDutyLevel(void);
+void refreshDuty(void);
+unsigned int percentToLevel(unsigned char ucPercent);
+unsigned char levelToPercent(unsigned int uiLevel);
+void setDutyScale(unsigned int uiScale);
 //ADC
-void AD8bit_Init(void);
-unsigned char AD8bit_Measurement(void);
+void ADC_Init(void);
+unsigned int ADC_GetFiltered(unsigned char* ucUpdated_ptr);
+//TICK
+void Tick_Init(void);
+unsigned int Tick_Get(void);
 //UTILITIES
-void wait_1ms(unsigned int uiFactor);
-long Map(long lData, long InMin, long InMax, long OutMin, long OutMax);
+void Sleep_Idle(void);
 
 #endif /* UTILS_H_ */
\ No newline at end of file